@@ -0,0 +1,320 @@
+/**
+ * @file analyse.c
+ * @brief Batch analysis: searches every position of a file on a pool of engines and writes the best moves in input order
+ *
+ * Each line of the input is one position, as its squares row by row ('B', 'W' or 'U', the form reversiSetPosition reads) followed by the side to move, 'B' or 'W'; the board size is taken from the
+ * number of squares. Lines that are empty or start with '#' are skipped. Every other line gives one line of output, in the order of the input:
+ *
+ *   line move score depth nodes
+ *
+ * with the line's number in the input, the best move as row and column letters ("--" for a pass), and the score for the side to move as the search gives it; a line that is not a position
+ * gives "line invalid" instead.
+ *
+ * The input is read as it is searched, into a ring of a few slots per worker. The reading thread fills the next free slot and hands it to the workers, which take the slots in turn, each
+ * searching with its own engine; the reading thread also writes out every slot that has been searched as soon as all the slots before it have been, which frees it for the next line. Memory
+ * is fixed by the number of workers, however long the input is, and the input is only read ahead of the output by the positions the workers have not finished yet
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "analyse.h"
+#include "arena.h"
+#include "util.h"
+
+//Longest line of the input: the squares of the largest board, the side to move, and room for spaces and the line ending
+#define MAX_ANALYSIS_LINE (MAX_SQUARES+16)
+
+/**
+ * @brief One line of the input, from when it is read until its result is written
+ */
+typedef struct  {
+	char line[MAX_ANALYSIS_LINE];
+	uint64_t lineNumber;		//The line's number in the input, counting from 1
+	bool overlong;				//Whether the line did not fit; it is reported as invalid
+	bool done;					//Whether the search is finished and the result below can be written
+	bool valid;
+	int dim;
+	int move;
+	int score;
+	int depth;
+	uint64_t nodes;
+} AnalysisSlot;
+
+/**
+ * @brief The ring of slots shared by the reading thread and the workers
+ *
+ * Slots are numbered in input order and slot number i is kept at i % capacity. Those from written to read are in use: from written to searched they have been handed to a worker, and from searched
+ * to read they are waiting for one. Only the reading thread moves read and written; the counters and the done flags are read and changed under the lock
+ */
+typedef struct  {
+	AnalysisSlot* slots;
+	uint64_t capacity;
+	uint64_t read;				//Slots filled from the input
+	uint64_t searched;			//Slots handed to a worker
+	uint64_t written;			//Slots whose results have been written
+	bool finished;				//Whether the input has been read to the end, so the workers stop once every slot has been handed out
+	const SearchLimits* limits;
+	pthread_mutex_t lock;
+	pthread_cond_t queued;		//Signalled when a slot is filled or the input ends
+	pthread_cond_t completed;	//Signalled when a worker finishes a slot
+} AnalysisQueue;
+
+/**
+ * @brief One worker: a thread and the engine it searches with
+ */
+typedef struct  {
+	AnalysisQueue* queue;
+	ReversiEngine* engine;
+	pthread_t thread;
+} AnalysisWorker;
+
+/**
+ * @brief Reads the position on one line of the input
+ *
+ * @param line The line: the squares, then the side to move
+ * @param pos Receives the position
+ *
+ * @return Whether the line is a position
+ */
+static bool parsePosition (char* line, Position* pos)  {
+	char* save;
+	char* squares = strtok_r(line, " \t\r\n", &save);
+	char* colour = strtok_r(NULL, " \t\r\n", &save);
+	int dim = 0;
+
+	if (squares == NULL || colour == NULL || colour[1] != '\0' || strtok_r(NULL, " \t\r\n", &save) != NULL)  {
+		return false;
+	}
+	while ((size_t) ((dim+1)*(dim+1)) <= strlen(squares))  {
+		dim++;
+	}
+	return reversiSetPosition(pos, dim, squares, colour[0]);
+}
+
+/**
+ * @brief Searches the position of one slot
+ *
+ * @param engine The worker's engine
+ * @param slot The slot, which receives the result
+ * @param limits How far the position is searched
+ */
+static void analyseSlot (ReversiEngine* engine, AnalysisSlot* slot, const SearchLimits* limits)  {
+	Position pos;
+	SearchResult result;
+
+	slot->valid = !slot->overlong && parsePosition(slot->line, &pos);
+	if (!slot->valid)  {
+		return;
+	}
+	slot->dim = pos.dim;
+	slot->move = reversiSearch(engine, &pos, limits, &result);
+	slot->score = result.score;
+	slot->depth = result.depth;
+	slot->nodes = result.nodes;
+}
+
+/**
+ * @brief Takes slots from the ring and searches them until the input has ended and every slot has been handed out
+ *
+ * @param argument The worker
+ *
+ * @return NULL
+ */
+static void* analysisWorker (void* argument)  {
+	AnalysisWorker* worker = (AnalysisWorker*) argument;
+	AnalysisQueue* queue = worker->queue;
+	AnalysisSlot* slot;
+
+	pthread_mutex_lock(&queue->lock);
+	while (true)  {
+		while (queue->searched == queue->read && !queue->finished)  {
+			pthread_cond_wait(&queue->queued, &queue->lock);
+		}
+		if (queue->searched == queue->read)  {
+			break;
+		}
+		slot = &queue->slots[queue->searched % queue->capacity];
+		queue->searched++;
+		//The slot is the worker's alone until it is marked done, so it is searched without the lock
+		pthread_mutex_unlock(&queue->lock);
+		analyseSlot(worker->engine, slot, queue->limits);
+		pthread_mutex_lock(&queue->lock);
+		slot->done = true;
+		pthread_cond_signal(&queue->completed);
+	}
+	pthread_mutex_unlock(&queue->lock);
+	return NULL;
+}
+
+/**
+ * @brief Writes the results of the searched slots that follow on from those already written, and frees their slots
+ *
+ * @param queue The ring
+ * @param output The file the results are written to
+ * @param wait Whether to wait for the next slot to be searched if it has not been; there must be one in use
+ * @param summary Receives the count of positions, invalid lines and nodes
+ */
+static void writeResults (AnalysisQueue* queue, FILE* output, bool wait, AnalysisSummary* summary)  {
+	uint64_t first, last;
+	char name[3];
+
+	pthread_mutex_lock(&queue->lock);
+	while (wait && !queue->slots[queue->written % queue->capacity].done)  {
+		pthread_cond_wait(&queue->completed, &queue->lock);
+	}
+	first = queue->written;
+	for (last = first; last < queue->read && queue->slots[last % queue->capacity].done; last++);
+	pthread_mutex_unlock(&queue->lock);
+
+	//No worker touches a slot once it is done, so the results are written without the lock, leaving the workers free to take new slots
+	for (uint64_t i = first; i < last; i++)  {
+		AnalysisSlot* slot = &queue->slots[i % queue->capacity];
+		if (slot->valid)  {
+			reversiMoveName(slot->move, slot->dim, name);
+			fprintf(output, "%llu %s %d %d %llu\n", (unsigned long long) slot->lineNumber, name, slot->score, slot->depth, (unsigned long long) slot->nodes);
+			summary->positions++;
+			summary->nodes += slot->nodes;
+		}
+		else  {
+			fprintf(output, "%llu invalid\n", (unsigned long long) slot->lineNumber);
+			summary->invalid++;
+		}
+		slot->done = false;
+	}
+
+	pthread_mutex_lock(&queue->lock);
+	queue->written = last;
+	pthread_mutex_unlock(&queue->lock);
+}
+
+/**
+ * @brief Reads the next position of the input into a slot
+ *
+ * @param input The input
+ * @param slot Receives the line
+ * @param lineNumber The number of the last line read, which is advanced past every line read
+ *
+ * @return Whether a line was read; false at the end of the input
+ */
+static bool readLine (FILE* input, AnalysisSlot* slot, uint64_t* lineNumber)  {
+	size_t length;
+	int c;
+
+	while (fgets(slot->line, sizeof(slot->line), input) != NULL)  {
+		(*lineNumber)++;
+		length = strlen(slot->line);
+		slot->overlong = length == sizeof(slot->line)-1 && slot->line[length-1] != '\n';
+		//The rest of a line that does not fit is passed over, so it is not taken for a line of its own
+		for (c = 0; slot->overlong && c != '\n' && c != EOF; c = fgetc(input));
+		if (slot->line[0] != '#' && strspn(slot->line, " \t\r\n") != length)  {
+			slot->lineNumber = *lineNumber;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Searches every position of a file and writes the best move of each, in input order
+ *
+ * @param options The input and output files, the number of workers, how their engines are set up and how far each position is searched
+ * @param summary Receives what was searched and how long it took
+ *
+ * @return Whether every position was searched and written; false if a file could not be read or written, or the workers could not be set up
+ */
+bool analysePositions (const AnalysisOptions* options, AnalysisSummary* summary)  {
+	//Variable declaration
+	int workers = options->workers > 0 ? (options->workers < MAX_ANALYSIS_WORKERS ? options->workers : MAX_ANALYSIS_WORKERS) : 1;
+	AnalysisWorker pool[MAX_ANALYSIS_WORKERS];
+	AnalysisQueue queue;
+	ReversiConfig config = options->config;
+	size_t megabytes = config.hashMegabytes > 0 ? config.hashMegabytes : REVERSI_DEFAULT_HASH_MEGABYTES;
+	uint64_t lineNumber = 0;
+	FILE* input;
+	FILE* output;
+	bool ready = true, written;
+	int started = 0;
+	double start = secondsNow();
+
+	memset(summary, 0, sizeof(AnalysisSummary));
+	summary->workers = workers;
+	input = strcmp(options->inputPath, "-") == 0 ? stdin : fopen(options->inputPath, "r");
+	if (input == NULL)  {
+		return false;
+	}
+	output = options->outputPath != NULL ? fopen(options->outputPath, "w") : stdout;
+	if (output == NULL)  {
+		if (input != stdin)  {
+			fclose(input);
+		}
+		return false;
+	}
+
+	//The table is shared out, so a run takes the memory asked for whatever the number of workers
+	config.hashMegabytes = megabytes/workers > 0 ? megabytes/workers : 1;
+	memset(&queue, 0, sizeof(AnalysisQueue));
+	queue.capacity = (uint64_t) workers*ANALYSIS_SLOTS_PER_WORKER;
+	queue.slots = (AnalysisSlot*) engineMalloc(queue.capacity*sizeof(AnalysisSlot));
+	queue.limits = &options->limits;
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.queued, NULL);
+	pthread_cond_init(&queue.completed, NULL);
+	ready = queue.slots != NULL;
+	if (ready)  {
+		memset(queue.slots, 0, queue.capacity*sizeof(AnalysisSlot));
+	}
+	for (; ready && started < workers; started++)  {
+		pool[started].queue = &queue;
+		pool[started].engine = reversiCreate(&config);
+		if (pool[started].engine == NULL || pthread_create(&pool[started].thread, NULL, analysisWorker, &pool[started]) != 0)  {
+			reversiFree(pool[started].engine);
+			ready = false;
+			break;
+		}
+	}
+
+	//Reads a line into every slot that comes free, writing out what has been searched whenever the ring is full
+	while (ready)  {
+		writeResults(&queue, output, queue.read-queue.written == queue.capacity, summary);
+		if (queue.read-queue.written == queue.capacity)  {
+			continue;
+		}
+		if (!readLine(input, &queue.slots[queue.read % queue.capacity], &lineNumber))  {
+			break;
+		}
+		pthread_mutex_lock(&queue.lock);
+		queue.read++;
+		pthread_cond_signal(&queue.queued);
+		pthread_mutex_unlock(&queue.lock);
+	}
+
+	pthread_mutex_lock(&queue.lock);
+	queue.finished = true;
+	pthread_cond_broadcast(&queue.queued);
+	pthread_mutex_unlock(&queue.lock);
+	while (queue.written < queue.read)  {
+		writeResults(&queue, output, true, summary);
+	}
+	for (int i = 0; i < started; i++)  {
+		pthread_join(pool[i].thread, NULL);
+		reversiFree(pool[i].engine);
+	}
+	pthread_mutex_destroy(&queue.lock);
+	pthread_cond_destroy(&queue.queued);
+	pthread_cond_destroy(&queue.completed);
+	engineFree(queue.slots);
+
+	summary->seconds = secondsNow() - start;
+	written = !ferror(input) && !ferror(output);
+	if (input != stdin)  {
+		fclose(input);
+	}
+	written = (output == stdout ? fflush(output) == 0 : fclose(output) == 0) && written;
+	return ready && written;
+}
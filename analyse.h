@@ -0,0 +1,43 @@
+/**
+ * @file analyse.h
+ * @brief Batch analysis: searches every position of a file on a pool of engines and writes the best moves in input order
+ */
+
+#ifndef ANALYSE_H
+#define ANALYSE_H
+
+#include <stdint.h>
+
+#include "reversi.h"
+
+//Most engines one run searches with
+#define MAX_ANALYSIS_WORKERS 64
+
+//Positions each worker may have read ahead of the output, waiting or being searched; the memory of a run is this many lines per worker, whatever the size of the input
+#define ANALYSIS_SLOTS_PER_WORKER 4
+
+/**
+ * @brief What a batch analysis run searches, and with what
+ */
+typedef struct  {
+	const char* inputPath;		//File of positions, one per line as the squares then the side to move; "-" for standard input
+	const char* outputPath;		//File the results are written to; NULL for standard output
+	int workers;				//Positions searched at once, each by its own engine; 0 for 1
+	ReversiConfig config;		//How every worker's engine is set up; the transposition table is shared out between the workers rather than given to each
+	SearchLimits limits;		//How far every position is searched. With no limit, reversiDefaultDepth of the board size
+} AnalysisOptions;
+
+/**
+ * @brief What a batch analysis run searched
+ */
+typedef struct  {
+	uint64_t positions;		//Positions searched
+	uint64_t invalid;		//Lines that were not a position
+	uint64_t nodes;			//Positions visited by every search
+	int workers;			//Engines the positions were searched with
+	double seconds;			//Wall-clock time of the whole run
+} AnalysisSummary;
+
+bool analysePositions (const AnalysisOptions* options, AnalysisSummary* summary);
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file arena.c
+ * @brief Fixed-size arena allocator, and a counter of the engine's heap allocations
+ *
+ * The search takes all of its working memory (positions, undo stacks and move lists) from per-thread arenas that are set up once and reset before every search, so searching never touches the heap.
+ * Every heap allocation the engine does make goes through engineMalloc or engineAlignedMalloc, which count it for the thread that made it, so a search can check that its own threads made none,
+ * whatever other engines in the process are doing at the same time
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+
+#include "arena.h"
+
+//Alignment of every arena allocation; a cache line, so data used by different threads never shares one
+#define ARENA_ALIGNMENT 64
+
+//Heap allocations made by each thread
+static __thread uint64_t allocationCount = 0;
+
+/**
+ * @brief Allocates heap memory for the engine and counts the allocation
+ *
+ * @param bytes The number of bytes needed
+ *
+ * @return The memory, or NULL if it could not be allocated
+ */
+void* engineMalloc (size_t bytes)  {
+	allocationCount++;
+	return malloc(bytes);
+}
+
+/**
+ * @brief Allocates heap memory for the engine starting on a given boundary, and counts the allocation
+ *
+ * @param alignment The boundary, a power of two and a multiple of the size of a pointer
+ * @param bytes The number of bytes needed
+ *
+ * @return The memory, or NULL if it could not be allocated
+ */
+void* engineAlignedMalloc (size_t alignment, size_t bytes)  {
+	void* memory;
+
+	allocationCount++;
+	return posix_memalign(&memory, alignment, bytes) == 0 ? memory : NULL;
+}
+
+/**
+ * @brief Frees memory allocated by engineMalloc or engineAlignedMalloc
+ */
+void engineFree (void* memory)  {
+	free(memory);
+}
+
+/**
+ * @brief The number of heap allocations the calling thread has made through the engine since it started
+ */
+uint64_t heapAllocations (void)  {
+	return allocationCount;
+}
+
+/**
+ * @brief Sets up an arena with its own block of memory
+ *
+ * @param arena The arena being set up
+ * @param capacity The number of bytes the arena can hand out between resets
+ *
+ * @return Whether the memory could be allocated
+ */
+bool arenaInit (Arena* arena, size_t capacity)  {
+	//Over-allocates so the first allocation can be moved up to a cache line boundary
+	arena->memory = (unsigned char*) engineMalloc(capacity + ARENA_ALIGNMENT);
+	arena->capacity = arena->memory != NULL ? capacity : 0;
+	arena->used = 0;
+	arena->peak = 0;
+	return arena->memory != NULL;
+}
+
+/**
+ * @brief Frees an arena's block of memory
+ */
+void arenaRelease (Arena* arena)  {
+	engineFree(arena->memory);
+	arena->memory = NULL;
+	arena->capacity = 0;
+	arena->used = 0;
+}
+
+/**
+ * @brief Hands out memory from an arena
+ *
+ * @param arena The arena
+ * @param bytes The number of bytes needed
+ *
+ * @return Cache-line aligned memory, or NULL if the arena does not have enough left
+ */
+void* arenaAlloc (Arena* arena, size_t bytes)  {
+	uintptr_t base = (uintptr_t) arena->memory;
+	size_t start = (size_t) (((base + arena->used + ARENA_ALIGNMENT-1) & ~(uintptr_t) (ARENA_ALIGNMENT-1)) - base);
+
+	if (start + bytes > arena->capacity + ARENA_ALIGNMENT)  {
+		return NULL;
+	}
+	arena->used = start + bytes;
+	if (arena->used > arena->peak)  {
+		arena->peak = arena->used;
+	}
+	return arena->memory + start;
+}
+
+/**
+ * @brief Makes all of an arena's memory available again
+ */
+void arenaReset (Arena* arena)  {
+	arena->used = 0;
+}
+
+/**
+ * @brief Remembers how much of an arena is in use, so later allocations can be released with arenaRewind
+ */
+size_t arenaMark (const Arena* arena)  {
+	return arena->used;
+}
+
+/**
+ * @brief Releases everything allocated from an arena since a mark was taken
+ */
+void arenaRewind (Arena* arena, size_t mark)  {
+	arena->used = mark;
+}
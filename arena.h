@@ -0,0 +1,37 @@
+/**
+ * @file arena.h
+ * @brief Fixed-size arena allocator, and a counter of the engine's heap allocations
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief A block of memory handed out front to back and released all at once
+ *
+ * Every allocation is aligned to a cache line. Nothing is freed on its own; arenaReset makes the whole block available again, and arenaRewind releases everything allocated after a mark
+ */
+typedef struct  {
+	unsigned char* memory;
+	size_t capacity;		//Bytes in the block
+	size_t used;			//Bytes handed out since the last reset
+	size_t peak;			//Most bytes ever in use at once
+} Arena;
+
+bool arenaInit (Arena* arena, size_t capacity);
+void arenaRelease (Arena* arena);
+void* arenaAlloc (Arena* arena, size_t bytes);
+void arenaReset (Arena* arena);
+size_t arenaMark (const Arena* arena);
+void arenaRewind (Arena* arena, size_t mark);
+
+void* engineMalloc (size_t bytes);
+void* engineAlignedMalloc (size_t alignment, size_t bytes);
+void engineFree (void* memory);
+uint64_t heapAllocations (void);
+
+#endif
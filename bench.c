@@ -0,0 +1,365 @@
+/**
+ * @file bench.c
+ * @brief Benchmark of move generation and search, for tracking speed and correctness across changes
+ *
+ * Runs in three parts:
+ *
+ *   perft   counts the leaves of the full game tree from the starting position to a fixed depth, on several board sizes, and checks every count against a known value; a wrong count means move
+ *           generation or make/unmake is broken. A pass counts as a move, and a game that ends before the depth counts as one leaf
+ *   search  searches a fixed suite of middle game and endgame positions to a fixed depth, each from an empty transposition table so the node counts are the same on every run, and reports
+ *           nodes, nodes/sec and the time taken to reach the depth
+ *   -json   prints the results of both parts as one JSON object instead of a table, for scripts that compare runs
+ *
+ * With -crosscheck followed by a number of positions, it instead generates that many random positions of every board size that uses the vector kernels and checks that every instruction set the processor
+ * offers generates exactly the moves the scalar code does. -simd followed by scalar, sse2 or avx2 runs the benchmark with that instruction set instead of the best one
+ *
+ * The program exits with status 1 if any perft count is wrong
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "reversi.h"
+#include "arena.h"
+#include "endgame.h"
+#include "util.h"
+
+//Transposition table size for the search suite, unless another size is given with -hash; small enough to clear quickly before every position
+#define BENCH_HASH_MEGABYTES 16
+
+/**
+ * @brief A perft count that is known to be right
+ */
+typedef struct  {
+	int dim;
+	int depth;
+	uint64_t leaves;
+} PerftCase;
+
+/**
+ * @brief A position of the search suite
+ */
+typedef struct  {
+	const char* name;
+	int dim;
+	char colour;			//The colour to move
+	const char* squares;	//Row by row, as read by reversiSetPosition
+	int depth;
+} BenchPosition;
+
+//Known 8 x 8 counts, used when a depth is given with -perft
+static const uint64_t perft8[] = {1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284, 212258976};
+
+//The counts checked on every run; 4 x 4 is searched to the end of every game
+static const PerftCase perftCases[] = {
+	{4, 16, 60060},
+	{6, 9, 2114912},
+	{8, 9, 3005288},
+	{10, 8, 392268},
+	{26, 6, 8200},
+};
+
+static const BenchPosition benchPositions[] = {
+	{"8x8 opening", 8, 'B', "UUUUUUUUUUWUBUUUUUWWWWUUUBBBBUUUUUWBWWUUUUUUBWUUUUUUUWUUUUUUBBBU", 9},
+	{"8x8 early midgame", 8, 'B', "UUUUUUUUUUWWBUUUUBBWWWWUBBBBWWUUUUUWBWUUUUWWWWUUUUUWBUUUUUUUUUUU", 9},
+	{"8x8 midgame", 8, 'B', "UUUWUUUUUUUWWUUUUUUWBWUUUUWWBWWUUUWWBWUUUWWWWWUUUUWBBWUUUWWWWWWU", 9},
+	{"8x8 late midgame", 8, 'B', "UUUUBUWUUUBUBWUUUUBBBBWUUBBBBWBBWWBBWBBBWWWWBBBUUUWUBUUUUUUUUUUU", 9},
+	{"8x8 20 empties", 8, 'B', "UBBBBBUUUUUWWWWUUUBBWWWWUUBBWBWWUUWWBBWWUUWBWBBWUUWWBBBUWWWWBBUU", 10},
+	{"8x8 14 empties", 8, 'B', "UUWBBWUUBUBBBWUUBBBBBWWUBBWBBWWWBBWWBWWUBBWBWBBUBWWWBWWWUUWWUBUB", 14},
+	{"8x8 12 empties", 8, 'B', "UUWWWWWBUUWWBWWBBBBBWBWBUBBWBWWBUBWBBWWBUWBBBBWBWUUBWWBBUUUBBBBB", 12},
+	{"6x6 12 empties", 6, 'B', "UUWUUUUUWWBWUUWWWWBBBWWWBBBBUUBBUWWW", 12},
+	{"10x10 opening", 10, 'B', "UUUUUUUUUUUUUUUBUUUUUUBBBBWUUUUWWBBWWUUUUBWBBWWUUUUUWWWWBUUUUUUWWWUUUUUUUWWWUUUUUUWUUUUUUUUUUUUUUUUU", 6},
+	{"10x10 midgame", 10, 'B', "WUUWBUUUUUWUWBBUUUUUWBBBBBBUUUWWBWWBWWUUWBWWBWWWUUWBBWBWBBUUWBWBWWWUUUUWWWBUUWUUWUBBBBUUUUUBBBBBUUUU", 6},
+	{"16x16 opening", 16, 'B', "UUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUWBUUUUUUUUUUUUBWWUUUUUUUBUBUWWWBWWUUUUUBUBBWWWBBWUUUUUUUBBBBBBBWBBUUUUUUWWBWBBWWUUUUUUUWWBWBBBUUUUUUUUUWWWBBBUUUUUUUUUUUUBBUUUUUUUUUUUUUBUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUUU", 4},
+};
+
+/**
+ * @brief Counts the leaves of the game tree below a position
+ *
+ * One ply above the leaves, the legal moves are counted rather than played
+ *
+ * @param pos The position; every move made on it is taken back
+ * @param undo The stack the moves are recorded on
+ * @param depth The number of moves, passes included, to the leaves
+ *
+ * @return The number of leaves
+ */
+static uint64_t perft (Position* pos, UndoStack* undo, int depth)  {
+	Bitboard moves;
+	uint64_t leaves = 0;
+
+	if (depth == 0)  {
+		return 1;
+	}
+	generateMoves(pos, pos->side, &moves);
+	if (!anySquare(&moves, pos->words))  {
+		generateMoves(pos, 1-pos->side, &moves);
+		//A finished game is a leaf however deep it is; otherwise the pass is the only move
+		if (!anySquare(&moves, pos->words) || depth == 1)  {
+			return 1;
+		}
+		makeMove(pos, PASS_MOVE, undo);
+		leaves = perft(pos, undo, depth-1);
+		unmakeMove(pos, undo);
+		return leaves;
+	}
+	if (depth == 1)  {
+		return countSquares(&moves, pos->words);
+	}
+	for (int square = popSquare(&moves, pos->words); square != -1; square = popSquare(&moves, pos->words))  {
+		makeMove(pos, square, undo);
+		leaves += perft(pos, undo, depth-1);
+		unmakeMove(pos, undo);
+	}
+	return leaves;
+}
+
+/**
+ * @brief Runs one perft case and prints its result
+ *
+ * @param perftCase The board size, depth and expected count
+ * @param undo The stack moves are recorded on
+ * @param json Whether to print JSON rather than a table row
+ * @param first Whether this is the first JSON entry, which has no comma before it
+ *
+ * @return Whether the count was right
+ */
+static bool runPerft (const PerftCase* perftCase, UndoStack* undo, bool json, bool first)  {
+	Position pos;
+	uint64_t leaves;
+	double start, seconds;
+	bool correct;
+
+	reversiNewPosition(&pos, perftCase->dim);
+	clearUndoStack(undo);
+	start = secondsNow();
+	leaves = perft(&pos, undo, perftCase->depth);
+	seconds = secondsNow() - start;
+	correct = leaves == perftCase->leaves;
+
+	if (json)  {
+		printf("%s\n    {\"size\": %d, \"depth\": %d, \"leaves\": %llu, \"expected\": %llu, \"correct\": %s, \"seconds\": %.6f, \"leavesPerSecond\": %.0f}", first ? "" : ",",
+			perftCase->dim, perftCase->depth, (unsigned long long) leaves, (unsigned long long) perftCase->leaves, correct ? "true" : "false", seconds,
+			seconds > 0 ? leaves/seconds : 0.0);
+	}
+	else  {
+		printf("perft %2dx%-2d depth %2d  leaves %12llu  %-5s  %8.3fs  %12.0f leaves/sec\n", perftCase->dim, perftCase->dim, perftCase->depth, (unsigned long long) leaves,
+			correct ? "ok" : "WRONG", seconds, seconds > 0 ? leaves/seconds : 0.0);
+	}
+	return correct;
+}
+
+/**
+ * @brief Searches one position of the suite and prints its result
+ *
+ * @param engine The engine to search with; its table is cleared first
+ * @param position The position and depth
+ * @param endgameEmpties The number of empty squares at or below which positions are solved exactly
+ * @param json Whether to print JSON rather than a table row
+ * @param first Whether this is the first JSON entry, which has no comma before it
+ * @param total Incremented by the nodes and time of the search
+ */
+static void runSearch (ReversiEngine* engine, const BenchPosition* position, int endgameEmpties, bool json, bool first, SearchResult* total)  {
+	Position pos;
+	SearchLimits limits;
+	SearchResult result;
+	char move[3];
+
+	reversiSetPosition(&pos, position->dim, position->squares, position->colour);
+	memset(&limits, 0, sizeof(SearchLimits));
+	limits.maxDepth = position->depth;
+	limits.endgameEmpties = endgameEmpties;
+	reversiNewGame(engine);
+	reversiSearch(engine, &pos, &limits, &result);
+	reversiMoveName(result.move, position->dim, move);
+	total->nodes += result.nodes;
+	total->seconds += result.seconds;
+
+	if (json)  {
+		printf("%s\n    {\"name\": \"%s\", \"size\": %d, \"depth\": %d, \"move\": \"%s\", \"score\": %d, \"nodes\": %llu, \"seconds\": %.6f, \"nodesPerSecond\": %.0f}", first ? "" : ",",
+			position->name, position->dim, result.depth, move, result.score, (unsigned long long) result.nodes, result.seconds,
+			result.seconds > 0 ? result.nodes/result.seconds : 0.0);
+	}
+	else  {
+		printf("search %-18s depth %2d  move %s  score %7d  nodes %11llu  %8.3fs  %10.0f nodes/sec\n", position->name, result.depth, move, result.score,
+			(unsigned long long) result.nodes, result.seconds, result.seconds > 0 ? result.nodes/result.seconds : 0.0);
+	}
+}
+
+/**
+ * @brief Generates moves in random positions with every instruction set the processor offers, and compares the moves with those of the scalar code
+ *
+ * Positions are filled square by square at a random density, so most are not reachable in a game; the moves of any position must still match exactly
+ *
+ * @param positions The number of positions of each board size
+ * @param json Whether to print JSON rather than a table row
+ *
+ * @return Whether every instruction set matched the scalar code in every position
+ */
+static bool crossCheck (int positions, bool json)  {
+	int best = simdSupported(), mismatches[SIMD_AVX2+1] = {0};
+	uint64_t state = 1;
+	char squares[MAX_SQUARES+1];
+	Position pos;
+	LegalMoves expected, legal;
+	Bitboard expectedMoves[2], moves;
+
+	for (int dim = SIMD_MIN_DIM; dim <= MAX_DIM; dim++)  {
+		for (int i = 0; i < positions; i++)  {
+			uint64_t emptyOdds = nextRandom(&state) % 100;
+			for (int square = 0; square < dim*dim; square++)  {
+				uint64_t roll = nextRandom(&state);
+				squares[square] = roll % 100 < emptyOdds ? 'U' : (roll >> 32) & 1 ? 'B' : 'W';
+			}
+			squares[dim*dim] = '\0';
+			reversiSetPosition(&pos, dim, squares, nextRandom(&state) & 1 ? 'B' : 'W');
+
+			selectSimd(SIMD_SCALAR);
+			generateLegalMoves(&pos, &expected);
+			generateMoves(&pos, BLACK, &expectedMoves[BLACK]);
+			generateMoves(&pos, WHITE, &expectedMoves[WHITE]);
+			for (int level = SIMD_SSE2; level <= best; level++)  {
+				bool same;
+
+				selectSimd(level);
+				generateLegalMoves(&pos, &legal);
+				same = memcmp(&legal, &expected, sizeof(LegalMoves)) == 0;
+				for (int colour = BLACK; colour <= WHITE; colour++)  {
+					generateMoves(&pos, colour, &moves);
+					same &= memcmp(&moves, &expectedMoves[colour], sizeof(Bitboard)) == 0;
+				}
+				mismatches[level] += !same;
+			}
+		}
+	}
+	selectSimd(best);
+
+	for (int level = SIMD_SSE2; level <= best; level++)  {
+		if (json)  {
+			printf("%s\n    {\"simd\": \"%s\", \"positions\": %d, \"mismatches\": %d}", level == SIMD_SSE2 ? "" : ",", simdName(level), positions*(MAX_DIM-SIMD_MIN_DIM+1), mismatches[level]);
+		}
+		else  {
+			printf("crosscheck %-6s  sizes %d-%d  positions %8d  mismatches %d  %s\n", simdName(level), SIMD_MIN_DIM, MAX_DIM, positions*(MAX_DIM-SIMD_MIN_DIM+1), mismatches[level], mismatches[level] == 0 ? "ok" : "WRONG");
+		}
+	}
+	for (int level = SIMD_SSE2; level <= best; level++)  {
+		if (mismatches[level] > 0)  {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Runs the benchmark
+ *
+ * Accepts -json to print JSON, -perft followed by a depth to run only an 8 x 8 perft to that depth, -noperft and -nosearch to skip a part, -hash, -threads, -weights and -endgame as the game does,
+ * -simd followed by an instruction set, and -crosscheck followed by a number of positions to check the instruction sets against each other instead of benchmarking
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	ReversiConfig config = {BENCH_HASH_MEGABYTES, 1, NULL, NULL, NULL};
+	ReversiEngine* engine;
+	UndoStack* undo;
+	SearchResult total;
+	PerftCase single;
+	bool json = false, runPerftCases = true, runSearches = true, correct = true;
+	int perftDepth = 0, crossCheckPositions = 0, simd = simdSupported(), endgameEmpties = DEFAULT_ENDGAME_EMPTIES, caseCount = sizeof(perftCases)/sizeof(perftCases[0]), positionCount = sizeof(benchPositions)/sizeof(benchPositions[0]);
+
+	for (int i = 1; i < argc; i++)  {
+		if (strcmp(argv[i], "-json") == 0)  {
+			json = true;
+		}
+		else if (strcmp(argv[i], "-perft") == 0 && i+1 < argc)  {
+			perftDepth = atoi(argv[++i]);
+			runSearches = false;
+		}
+		else if (strcmp(argv[i], "-noperft") == 0)  {
+			runPerftCases = false;
+		}
+		else if (strcmp(argv[i], "-nosearch") == 0)  {
+			runSearches = false;
+		}
+		else if (strcmp(argv[i], "-endgame") == 0 && i+1 < argc)  {
+			endgameEmpties = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-hash") == 0 && i+1 < argc)  {
+			config.hashMegabytes = (size_t) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc)  {
+			config.threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-weights") == 0 && i+1 < argc)  {
+			config.weightsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-simd") == 0 && i+1 < argc)  {
+			i++;
+			simd = strcmp(argv[i], "avx2") == 0 ? SIMD_AVX2 : strcmp(argv[i], "sse2") == 0 ? SIMD_SSE2 : strcmp(argv[i], "scalar") == 0 ? SIMD_SCALAR : -1;
+		}
+		else if (strcmp(argv[i], "-crosscheck") == 0 && i+1 < argc)  {
+			crossCheckPositions = atoi(argv[++i]);
+		}
+	}
+	if (crossCheckPositions > 0)  {
+		if (json)  {
+			printf("{\n  \"crosscheck\": [");
+		}
+		correct = crossCheck(crossCheckPositions, json);
+		if (json)  {
+			printf("\n  ],\n  \"correct\": %s\n}\n", correct ? "true" : "false");
+		}
+		return correct ? 0 : 1;
+	}
+	if (!selectSimd(simd))  {
+		fprintf(stderr, "This processor does not offer that instruction set; the best it offers is %s\n", simdName(simdSupported()));
+		return 1;
+	}
+	if (perftDepth < 0 || perftDepth >= (int) (sizeof(perft8)/sizeof(perft8[0])))  {
+		fprintf(stderr, "perft depths on 8x8 go up to %d\n", (int) (sizeof(perft8)/sizeof(perft8[0]))-1);
+		return 1;
+	}
+	undo = (UndoStack*) engineMalloc(sizeof(UndoStack));
+	engine = reversiCreate(&config);
+	if (undo == NULL || engine == NULL)  {
+		fprintf(stderr, "Could not set up the benchmark\n");
+		return 1;
+	}
+
+	if (json)  {
+		printf("{\n  \"perft\": [");
+	}
+	if (perftDepth > 0)  {
+		single.dim = 8;
+		single.depth = perftDepth;
+		single.leaves = perft8[perftDepth];
+		correct = runPerft(&single, undo, json, true);
+	}
+	else if (runPerftCases)  {
+		for (int i = 0; i < caseCount; i++)  {
+			correct &= runPerft(&perftCases[i], undo, json, i == 0);
+		}
+	}
+
+	memset(&total, 0, sizeof(SearchResult));
+	if (json)  {
+		printf("\n  ],\n  \"search\": [");
+	}
+	for (int i = 0; runSearches && i < positionCount; i++)  {
+		runSearch(engine, &benchPositions[i], endgameEmpties, json, i == 0, &total);
+	}
+	if (json)  {
+		printf("\n  ],\n  \"simd\": \"%s\",\n  \"threads\": %d,\n  \"perftCorrect\": %s,\n  \"searchNodes\": %llu,\n  \"searchSeconds\": %.6f,\n  \"searchNodesPerSecond\": %.0f\n}\n", simdName(selectedSimd()), config.threads,
+			correct ? "true" : "false", (unsigned long long) total.nodes, total.seconds, total.seconds > 0 ? total.nodes/total.seconds : 0.0);
+	}
+	else if (runSearches)  {
+		printf("search total  nodes %llu  %.3fs  %.0f nodes/sec  (%s)\n", (unsigned long long) total.nodes, total.seconds, total.seconds > 0 ? total.nodes/total.seconds : 0.0, simdName(selectedSimd()));
+	}
+
+	reversiFree(engine);
+	engineFree(undo);
+	return correct ? 0 : 1;
+}
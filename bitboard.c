@@ -0,0 +1,1157 @@
+/**
+ * @file bitboard.c
+ * @brief Bitboard move generation and flipping for n x n reversi boards
+ *
+ * Legal moves are generated for every square at once: the mover's discs are shifted one step at a time along each of the 8 directions through runs of opposing discs, and every empty square reached
+ * at the end of such a run is a legal move. Flips for a single move are found by walking outwards from the move. Boards of 8 x 8 use a dedicated single-word path for both
+ *
+ * Each board size has its kernels looked up once per call from a table indexed by size. The multi-word kernels are written once and compiled again for each of the sizes that are played most, 10 x 10
+ * and 16 x 16, with the size and the number of words as constants; every other size uses the same code reading the size from the position. On boards of 4 words or more, move generation runs on
+ * AVX2 or SSE2 vectors instead, whichever is the best the processor has, shifting several words of every bitboard at once; it takes exactly the same steps, so it finds exactly the same moves
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+
+#include "bitboard.h"
+#include "pattern.h"
+#include "util.h"
+
+const int directionRow[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+const int directionCol[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+
+//Words of a bitboard as the vector kernels lay it out: a zero word, the bitboard's words, then zero words up to a whole number of vectors and one more, so every word can be shifted
+//together with both of its neighbours by loading the vector one word before or after it
+#define PADDED_WORDS 16
+
+/**
+ * @brief Masks that only depend on the size of the board
+ */
+typedef struct  {
+	Bitboard board;			//Every square on the board
+	Bitboard landing[8];	//Squares a shifted disc may land on in each direction; excludes the column a disc would land in if it wrapped around the edge of a row
+	uint64_t paddedBoard[PADDED_WORDS];			//The same masks laid out for the vector kernels
+	uint64_t paddedLanding[8][PADDED_WORDS];
+} Geometry;
+
+static Geometry geometry[MAX_DIM+1];
+
+static void initTables (void);
+
+//Zobrist keys: one random number for each colour of disc on each square, one for the side to move being white, and one for each board size so positions of different sizes never share a hash
+static uint64_t zobristDisc[2][MAX_SQUARES];
+static uint64_t zobristFlip[MAX_SQUARES];
+static uint64_t zobristWhiteToMove;
+static uint64_t zobristDim[MAX_DIM+1];
+
+/**
+ * @brief Fills the Zobrist keys
+ *
+ * The keys come from a fixed seed, so a position hashes to the same value in every run of the program
+ */
+static void initZobrist (void)  {
+	uint64_t seed = 0x9e3779b97f4a7c15ULL;
+
+	for (int square = 0; square < MAX_SQUARES; square++)  {
+		zobristDisc[BLACK][square] = nextRandom(&seed);
+		zobristDisc[WHITE][square] = nextRandom(&seed);
+		//Flipping a disc removes one colour and adds the other
+		zobristFlip[square] = zobristDisc[BLACK][square] ^ zobristDisc[WHITE][square];
+	}
+	zobristWhiteToMove = nextRandom(&seed);
+	for (int dim = 0; dim <= MAX_DIM; dim++)  {
+		zobristDim[dim] = nextRandom(&seed);
+	}
+}
+
+/**
+ * @brief Builds the masks for a board size
+ *
+ * @param dim The size n of the n x n board
+ */
+static void buildGeometry (int dim)  {
+	Geometry* geo = &geometry[dim];
+
+	clearBitboard(&geo->board);
+	for (int d = 0; d < 8; d++)  {
+		clearBitboard(&geo->landing[d]);
+	}
+	for (int row = 0; row < dim; row++)  {
+		for (int col = 0; col < dim; col++)  {
+			setSquare(&geo->board, row*dim+col);
+			for (int d = 0; d < 8; d++)  {
+				//A disc moving East can never land in the first column, and a disc moving West can never land in the last column
+				if (!(directionCol[d] == 1 && col == 0) && !(directionCol[d] == -1 && col == dim-1))  {
+					setSquare(&geo->landing[d], row*dim+col);
+				}
+			}
+		}
+	}
+	memset(geo->paddedBoard, 0, sizeof(geo->paddedBoard));
+	memset(geo->paddedLanding, 0, sizeof(geo->paddedLanding));
+	memcpy(geo->paddedBoard+1, geo->board.word, MAX_WORDS*sizeof(uint64_t));
+	for (int d = 0; d < 8; d++)  {
+		memcpy(geo->paddedLanding[d]+1, geo->landing[d].word, MAX_WORDS*sizeof(uint64_t));
+	}
+}
+
+/**
+ * @brief Returns the masks for a board size, built for every size before the first position is set up
+ *
+ * Kept out of line: inlined into the any-size kernels, it draws a false -Warray-bounds warning of an index below the table from GCC
+ *
+ * @param dim The size n of the n x n board
+ *
+ * @return Pointer to the masks for the board size
+ */
+static __attribute__((noinline)) const Geometry* geometryFor (int dim)  {
+	return &geometry[dim];
+}
+
+/**
+ * @brief Shifts every square of a bitboard by a number of squares and masks the result
+ *
+ * A positive amount moves squares towards higher indices (South and East), a negative amount towards lower indices (North and West). The output may be the same bitboard as the input
+ *
+ * @param out The shifted bitboard
+ * @param in The bitboard being shifted
+ * @param amount The number of squares to shift by; never 0 and never more than 63 in either direction
+ * @param mask The squares that are kept after the shift
+ * @param words The number of words in use
+ */
+static inline void shiftBitboard (Bitboard* out, const Bitboard* in, int amount, const Bitboard* mask, int words)  {
+	if (amount > 0)  {
+		//Works from the top word down so that each word can still read the word below it before it is overwritten
+		for (int i = words-1; i > 0; i--)  {
+			out->word[i] = ((in->word[i] << amount) | (in->word[i-1] >> (64-amount))) & mask->word[i];
+		}
+		out->word[0] = (in->word[0] << amount) & mask->word[0];
+	}
+	else  {
+		amount = -amount;
+		for (int i = 0; i < words-1; i++)  {
+			out->word[i] = ((in->word[i] >> amount) | (in->word[i+1] << (64-amount))) & mask->word[i];
+		}
+		out->word[words-1] = (in->word[words-1] >> amount) & mask->word[words-1];
+	}
+}
+
+//Shift amounts and landing masks of the 8 directions on an 8 x 8 board; NOT_FIRST_COL drops squares that wrapped into column a, NOT_LAST_COL drops squares that wrapped into column h
+#define NOT_FIRST_COL 0xfefefefefefefefeULL
+#define NOT_LAST_COL 0x7f7f7f7f7f7f7f7fULL
+static const int shift8Amount[8] = {-9, -8, -7, -1, 1, 7, 8, 9};
+static const uint64_t shift8Mask[8] = {NOT_LAST_COL, ~0ULL, NOT_FIRST_COL, NOT_LAST_COL, NOT_FIRST_COL, NOT_LAST_COL, ~0ULL, NOT_FIRST_COL};
+
+/**
+ * @brief Shifts an 8 x 8 bitboard one step in a direction
+ */
+static inline uint64_t shift8 (uint64_t bits, int direction)  {
+	int amount = shift8Amount[direction];
+	return (amount > 0 ? bits << amount : bits >> -amount) & shift8Mask[direction];
+}
+
+/**
+ * @brief Generates the legal moves of one side on an 8 x 8 board
+ *
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ *
+ * @return Bitboard of every square that flips at least one disc
+ */
+static uint64_t generateMoves8 (uint64_t own, uint64_t opp)  {
+	uint64_t empty = ~(own | opp), moves = 0, run;
+
+	for (int d = 0; d < 8; d++)  {
+		//Collects runs of opposing discs that start next to one of the mover's discs; a run is at most 6 discs long on an 8 x 8 board
+		run = shift8(own, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		moves |= shift8(run, d) & empty;
+	}
+	return moves;
+}
+
+/**
+ * @brief Generates the legal moves of both sides on an 8 x 8 board in one pass
+ *
+ * @param black The black discs
+ * @param white The white discs
+ * @param blackMoves Receives every square where black can move
+ * @param whiteMoves Receives every square where white can move
+ */
+static void generateLegalMoves8 (uint64_t black, uint64_t white, uint64_t* blackMoves, uint64_t* whiteMoves)  {
+	uint64_t empty = ~(black | white), runBlack, runWhite;
+
+	*blackMoves = 0;
+	*whiteMoves = 0;
+	for (int d = 0; d < 8; d++)  {
+		//Grows the runs of both colours side by side, sharing the direction's shift and mask
+		runBlack = shift8(black, d) & white;
+		runWhite = shift8(white, d) & black;
+		for (int step = 0; step < 5; step++)  {
+			runBlack |= shift8(runBlack, d) & white;
+			runWhite |= shift8(runWhite, d) & black;
+		}
+		*blackMoves |= shift8(runBlack, d) & empty;
+		*whiteMoves |= shift8(runWhite, d) & empty;
+	}
+}
+
+/**
+ * @brief Finds the discs flipped by a move on an 8 x 8 board
+ *
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ * @param square The square the move is played on
+ * @param directionCounts If not NULL, receives the number of discs flipped in each direction
+ *
+ * @return Bitboard of the discs that are flipped
+ */
+static uint64_t computeFlips8 (uint64_t own, uint64_t opp, int square, int* directionCounts)  {
+	uint64_t move = (uint64_t) 1 << square, flips = 0, run;
+
+	for (int d = 0; d < 8; d++)  {
+		//Grows a run of opposing discs outwards from the move; it only flips if the square just past the run holds one of the mover's discs
+		run = shift8(move, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		run |= shift8(run, d) & opp;
+		if (!(shift8(run, d) & own))  {
+			run = 0;
+		}
+		flips |= run;
+		if (directionCounts != NULL)  {
+			directionCounts[d] = __builtin_popcountll(run);
+		}
+	}
+	return flips;
+}
+
+/**
+ * @brief Generates the legal moves of one side on an 8 x 8 board held in single words
+ *
+ * For code that works on the bare words of an 8 x 8 board without a Position, such as the endgame solver
+ *
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ *
+ * @return Bitboard of every square that flips at least one disc
+ */
+uint64_t generateMoves8x8 (uint64_t own, uint64_t opp)  {
+	return generateMoves8(own, opp);
+}
+
+/**
+ * @brief Finds the discs flipped by a move on an 8 x 8 board held in single words
+ *
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ * @param square The square the move is played on, which must be empty
+ *
+ * @return Bitboard of the discs that are flipped; 0 if the move is not legal
+ */
+uint64_t computeFlips8x8 (uint64_t own, uint64_t opp, int square)  {
+	return computeFlips8(own, opp, square, NULL);
+}
+
+/**
+ * @brief Computes the Zobrist hash of a position from scratch
+ *
+ * Only needed when a position is set up; moves keep the hash up to date by XORing in the keys of the squares they change
+ *
+ * @param pos The position being hashed
+ *
+ * @return The hash of the position
+ */
+uint64_t computeHash (const Position* pos)  {
+	uint64_t hash = zobristDim[pos->dim];
+
+	for (int colour = BLACK; colour <= WHITE; colour++)  {
+		Bitboard discs = pos->disc[colour];
+		for (int square = popSquare(&discs, pos->words); square != -1; square = popSquare(&discs, pos->words))  {
+			hash ^= zobristDisc[colour][square];
+		}
+	}
+	if (pos->side == WHITE)  {
+		hash ^= zobristWhiteToMove;
+	}
+	return hash;
+}
+
+/**
+ * @brief Sets up the starting position of a game
+ *
+ * Places the centre four discs exactly as setBoard does, with black to move
+ *
+ * @param pos The position being set up
+ * @param dim The size n of the n x n board
+ */
+void positionInit (Position* pos, int dim)  {
+	initTables();
+	memset(pos, 0, sizeof(Position));
+	pos->dim = dim;
+	pos->words = (dim*dim+63)/64;
+	pos->side = BLACK;
+	setSquare(&pos->disc[WHITE], ((dim/2)-1)*dim + (dim/2)-1);
+	setSquare(&pos->disc[BLACK], (dim/2)*dim + (dim/2)-1);
+	setSquare(&pos->disc[BLACK], ((dim/2)-1)*dim + dim/2);
+	setSquare(&pos->disc[WHITE], (dim/2)*dim + dim/2);
+	pos->hash = computeHash(pos);
+	computePatternIndices(pos);
+}
+
+/**
+ * @brief Reads a position from a game board
+ *
+ * @param pos The position that is filled in
+ * @param board The n x n board of 'B', 'W' and 'U' characters
+ * @param dim The size n of the n x n board
+ * @param colour The colour of the player to move
+ */
+void positionFromBoard (Position* pos, char** board, int dim, char colour)  {
+	initTables();
+	memset(pos, 0, sizeof(Position));
+	pos->dim = dim;
+	pos->words = (dim*dim+63)/64;
+	pos->side = colourIndex(colour);
+	for (int i = 0; i < dim; i++)  {
+		for (int j = 0; j < dim; j++)  {
+			if (board[i][j] == 'B')  {
+				setSquare(&pos->disc[BLACK], i*dim+j);
+			}
+			else if (board[i][j] == 'W')  {
+				setSquare(&pos->disc[WHITE], i*dim+j);
+			}
+		}
+	}
+	pos->hash = computeHash(pos);
+	computePatternIndices(pos);
+}
+
+/**
+ * @brief Writes a position onto a game board
+ *
+ * @param pos The position being written
+ * @param board The n x n board of 'B', 'W' and 'U' characters that is overwritten
+ */
+void positionToBoard (const Position* pos, char** board)  {
+	for (int i = 0; i < pos->dim; i++)  {
+		for (int j = 0; j < pos->dim; j++)  {
+			if (testSquare(&pos->disc[BLACK], i*pos->dim+j))  {
+				board[i][j] = 'B';
+			}
+			else if (testSquare(&pos->disc[WHITE], i*pos->dim+j))  {
+				board[i][j] = 'W';
+			}
+			else  {
+				board[i][j] = 'U';
+			}
+		}
+	}
+}
+
+/**
+ * @brief Counts the squares set in a bitboard
+ */
+int countSquares (const Bitboard* bits, int words)  {
+	int count = 0;
+	for (int i = 0; i < words; i++)  {
+		count += __builtin_popcountll(bits->word[i]);
+	}
+	return count;
+}
+
+/**
+ * @brief Checks whether any square is set in a bitboard
+ */
+bool anySquare (const Bitboard* bits, int words)  {
+	for (int i = 0; i < words; i++)  {
+		if (bits->word[i])  {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Removes the lowest numbered square from a bitboard
+ *
+ * Squares come out in the same Northwest to Southeast order that the board is scanned in by the rest of the game
+ *
+ * @param bits The bitboard the square is removed from
+ * @param words The number of words in use
+ *
+ * @return The square that was removed, or -1 if the bitboard was empty
+ */
+int popSquare (Bitboard* bits, int words)  {
+	for (int i = 0; i < words; i++)  {
+		if (bits->word[i])  {
+			int bit = __builtin_ctzll(bits->word[i]);
+			bits->word[i] &= bits->word[i]-1;
+			return i*64 + bit;
+		}
+	}
+	return -1;
+}
+
+//Marks the bodies of the kernels, which are compiled once for every board size that has its own kernels and once for any size; with the size a constant, every loop over the words and
+//the directions is unrolled
+#define KERNEL_BODY static inline __attribute__((always_inline))
+
+/**
+ * @brief Generates every legal move for one side: the body of every size's kernel
+ *
+ * @param own The discs of the player whose moves are generated
+ * @param opp The discs of the opponent
+ * @param moves Receives one bit for every square where the player can legally move
+ * @param geo The masks of the board size
+ * @param dim The size n of the n x n board
+ * @param words The number of words in use
+ */
+KERNEL_BODY void movesOfSide (const Bitboard* own, const Bitboard* opp, Bitboard* moves, const Geometry* geo, int dim, int words)  {
+	Bitboard empty, run, step;
+	bool growing;
+
+	clearBitboard(moves);
+	clearBitboard(&empty);
+	for (int i = 0; i < words; i++)  {
+		empty.word[i] = geo->board.word[i] & ~(own->word[i] | opp->word[i]);
+	}
+
+	#pragma GCC unroll 8
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*dim + directionCol[d];
+		//Starts with the opposing discs that sit next to one of the mover's discs
+		shiftBitboard(&run, own, amount, &geo->landing[d], words);
+		growing = false;
+		for (int i = 0; i < words; i++)  {
+			run.word[i] &= opp->word[i];
+			growing |= run.word[i] != 0;
+		}
+		//Steps the front of every run forward until it leaves the opposing discs; empty squares reached by a front are legal moves
+		while (growing)  {
+			shiftBitboard(&step, &run, amount, &geo->landing[d], words);
+			growing = false;
+			for (int i = 0; i < words; i++)  {
+				moves->word[i] |= step.word[i] & empty.word[i];
+				run.word[i] = step.word[i] & opp->word[i];
+				growing |= run.word[i] != 0;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Generates every legal move of both colours: the body of every size's kernel
+ *
+ * @param black The black discs
+ * @param white The white discs
+ * @param legal Receives the legal moves of both colours and how many there are
+ * @param geo The masks of the board size
+ * @param dim The size n of the n x n board
+ * @param words The number of words in use
+ */
+KERNEL_BODY void movesOfBoth (const Bitboard* black, const Bitboard* white, LegalMoves* legal, const Geometry* geo, int dim, int words)  {
+	Bitboard empty, runBlack, runWhite, step;
+	bool growing;
+
+	clearBitboard(&legal->moves[BLACK]);
+	clearBitboard(&legal->moves[WHITE]);
+	clearBitboard(&empty);
+	for (int i = 0; i < words; i++)  {
+		empty.word[i] = geo->board.word[i] & ~(black->word[i] | white->word[i]);
+	}
+
+	#pragma GCC unroll 8
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*dim + directionCol[d];
+		//Starts the runs of both colours: the opposing discs next to each colour's discs
+		shiftBitboard(&runBlack, black, amount, &geo->landing[d], words);
+		shiftBitboard(&runWhite, white, amount, &geo->landing[d], words);
+		growing = false;
+		for (int i = 0; i < words; i++)  {
+			runBlack.word[i] &= white->word[i];
+			runWhite.word[i] &= black->word[i];
+			growing |= (runBlack.word[i] | runWhite.word[i]) != 0;
+		}
+		//Steps both sets of fronts forward together until neither colour has a run left to follow
+		while (growing)  {
+			growing = false;
+			shiftBitboard(&step, &runBlack, amount, &geo->landing[d], words);
+			for (int i = 0; i < words; i++)  {
+				legal->moves[BLACK].word[i] |= step.word[i] & empty.word[i];
+				runBlack.word[i] = step.word[i] & white->word[i];
+				growing |= runBlack.word[i] != 0;
+			}
+			shiftBitboard(&step, &runWhite, amount, &geo->landing[d], words);
+			for (int i = 0; i < words; i++)  {
+				legal->moves[WHITE].word[i] |= step.word[i] & empty.word[i];
+				runWhite.word[i] = step.word[i] & black->word[i];
+				growing |= runWhite.word[i] != 0;
+			}
+		}
+	}
+	legal->count[BLACK] = countSquares(&legal->moves[BLACK], words);
+	legal->count[WHITE] = countSquares(&legal->moves[WHITE], words);
+}
+
+/**
+ * @brief Finds every disc a move would flip: the body of every size's kernel
+ *
+ * @param own The discs of the player making the move
+ * @param opp The discs of the opponent
+ * @param square The square the move is played on
+ * @param flips Receives the discs that are flipped
+ * @param directionCounts If not NULL, receives the number of discs flipped in each of the 8 directions
+ * @param dim The size n of the n x n board
+ *
+ * @return The total number of discs flipped; 0 if the move is not legal
+ */
+KERNEL_BODY int flipsOfMove (const Bitboard* own, const Bitboard* opp, int square, Bitboard* flips, int* directionCounts, int dim)  {
+	int row = square/dim, col = square%dim, total = 0;
+
+	clearBitboard(flips);
+	if (testSquare(own, square) || testSquare(opp, square))  {
+		if (directionCounts != NULL)  {
+			memset(directionCounts, 0, 8*sizeof(int));
+		}
+		return 0;
+	}
+
+	#pragma GCC unroll 8
+	for (int d = 0; d < 8; d++)  {
+		int i = row+directionRow[d], j = col+directionCol[d], count = 0;
+		//Walks over the run of opposing discs next to the move
+		while (i >= 0 && j >= 0 && i < dim && j < dim && testSquare(opp, i*dim+j))  {
+			i += directionRow[d];
+			j += directionCol[d];
+			count++;
+		}
+		//The run only flips if it is closed off by one of the mover's discs
+		if (count > 0 && i >= 0 && j >= 0 && i < dim && j < dim && testSquare(own, i*dim+j))  {
+			for (int k = 1; k <= count; k++)  {
+				setSquare(flips, (row+k*directionRow[d])*dim + col+k*directionCol[d]);
+			}
+		}
+		else  {
+			count = 0;
+		}
+		if (directionCounts != NULL)  {
+			directionCounts[d] = count;
+		}
+		total += count;
+	}
+	return total;
+}
+
+/**
+ * @brief The move generation and flipping of one board size
+ */
+typedef struct  {
+	void (*generateMoves) (const Position* pos, int side, Bitboard* moves);
+	void (*generateLegalMoves) (const Position* pos, LegalMoves* legal);
+	int (*computeFlips) (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts);
+} BoardKernels;
+
+/**
+ * @brief The kernels of an 8 x 8 board, which fits in one word
+ */
+static void generateMovesSize8 (const Position* pos, int side, Bitboard* moves)  {
+	clearBitboard(moves);
+	moves->word[0] = generateMoves8(pos->disc[side].word[0], pos->disc[1-side].word[0]);
+}
+
+static void generateLegalMovesSize8 (const Position* pos, LegalMoves* legal)  {
+	clearBitboard(&legal->moves[BLACK]);
+	clearBitboard(&legal->moves[WHITE]);
+	generateLegalMoves8(pos->disc[BLACK].word[0], pos->disc[WHITE].word[0], &legal->moves[BLACK].word[0], &legal->moves[WHITE].word[0]);
+	legal->count[BLACK] = __builtin_popcountll(legal->moves[BLACK].word[0]);
+	legal->count[WHITE] = __builtin_popcountll(legal->moves[WHITE].word[0]);
+}
+
+static int computeFlipsSize8 (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts)  {
+	clearBitboard(flips);
+	if (testSquare(&pos->disc[side], square) || testSquare(&pos->disc[1-side], square))  {
+		if (directionCounts != NULL)  {
+			memset(directionCounts, 0, 8*sizeof(int));
+		}
+		return 0;
+	}
+	flips->word[0] = computeFlips8(pos->disc[side].word[0], pos->disc[1-side].word[0], square, directionCounts);
+	return __builtin_popcountll(flips->word[0]);
+}
+
+//Compiles the kernels of an N x N board, with the size and the number of words as constants
+#define SIZED_KERNELS(N) \
+	static void generateMovesSize##N (const Position* pos, int side, Bitboard* moves)  { \
+		movesOfSide(&pos->disc[side], &pos->disc[1-side], moves, geometryFor(N), N, ((N)*(N)+63)/64); \
+	} \
+	static void generateLegalMovesSize##N (const Position* pos, LegalMoves* legal)  { \
+		movesOfBoth(&pos->disc[BLACK], &pos->disc[WHITE], legal, geometryFor(N), N, ((N)*(N)+63)/64); \
+	} \
+	static int computeFlipsSize##N (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts)  { \
+		return flipsOfMove(&pos->disc[side], &pos->disc[1-side], square, flips, directionCounts, N); \
+	}
+
+SIZED_KERNELS(10)
+SIZED_KERNELS(16)
+
+/**
+ * @brief The kernels of any other board size, which read the size from the position
+ */
+static void generateMovesAnySize (const Position* pos, int side, Bitboard* moves)  {
+	movesOfSide(&pos->disc[side], &pos->disc[1-side], moves, geometryFor(pos->dim), pos->dim, pos->words);
+}
+
+static void generateLegalMovesAnySize (const Position* pos, LegalMoves* legal)  {
+	movesOfBoth(&pos->disc[BLACK], &pos->disc[WHITE], legal, geometryFor(pos->dim), pos->dim, pos->words);
+}
+
+static int computeFlipsAnySize (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts)  {
+	return flipsOfMove(&pos->disc[side], &pos->disc[1-side], square, flips, directionCounts, pos->dim);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+//The vector kernels keep every bitboard padded, in PADDED_WORDS words. A shift of every square by amount squares, between -63 and 63 but never 0, joins each word with the word below it (or
+//above it for a negative amount), which is simply the vector loaded one word lower (or higher); the padding words are 0, and the masks keep every word past the board at 0. The shifts read
+//their counts from left, the size of the amount, and right, 64 less it
+#define SHIFT_AVX2(in, i, amount) ((amount) > 0 ? \
+	_mm256_or_si256(_mm256_sll_epi64(_mm256_loadu_si256((const __m256i*) ((in)+(i))), left), _mm256_srl_epi64(_mm256_loadu_si256((const __m256i*) ((in)+(i)-1)), right)) : \
+	_mm256_or_si256(_mm256_srl_epi64(_mm256_loadu_si256((const __m256i*) ((in)+(i))), left), _mm256_sll_epi64(_mm256_loadu_si256((const __m256i*) ((in)+(i)+1)), right)))
+#define SHIFT_SSE2(in, i, amount) ((amount) > 0 ? \
+	_mm_or_si128(_mm_sll_epi64(_mm_loadu_si128((const __m128i*) ((in)+(i))), left), _mm_srl_epi64(_mm_loadu_si128((const __m128i*) ((in)+(i)-1)), right)) : \
+	_mm_or_si128(_mm_srl_epi64(_mm_loadu_si128((const __m128i*) ((in)+(i))), left), _mm_sll_epi64(_mm_loadu_si128((const __m128i*) ((in)+(i)+1)), right)))
+
+/**
+ * @brief Copies the words of a bitboard into the padded layout
+ */
+static inline void padBitboard (uint64_t* padded, const Bitboard* bits, int words)  {
+	memset(padded, 0, PADDED_WORDS*sizeof(uint64_t));
+	memcpy(padded+1, bits->word, words*sizeof(uint64_t));
+}
+
+/**
+ * @brief Copies the words of a padded bitboard back out
+ */
+static inline void unpadBitboard (Bitboard* bits, const uint64_t* padded, int words)  {
+	clearBitboard(bits);
+	memcpy(bits->word, padded+1, words*sizeof(uint64_t));
+}
+
+/**
+ * @brief Generates every legal move of both colours with AVX2, four words at a time
+ *
+ * Follows movesOfBoth step for step, so its result is identical
+ *
+ * @param pos The position being checked
+ * @param legal Receives the legal moves of both colours and how many there are
+ */
+static __attribute__((target("avx2"))) void generateLegalMovesAvx2 (const Position* pos, LegalMoves* legal)  {
+	const Geometry* geo = geometryFor(pos->dim);
+	int words = pos->words, last = 1 + 4*((words+3)/4);
+	uint64_t black[PADDED_WORDS], white[PADDED_WORDS], runBlack[PADDED_WORDS], runWhite[PADDED_WORDS], empty[PADDED_WORDS], moves[2][PADDED_WORDS];
+
+	padBitboard(black, &pos->disc[BLACK], words);
+	padBitboard(white, &pos->disc[WHITE], words);
+	memset(runBlack, 0, sizeof(runBlack));
+	memset(runWhite, 0, sizeof(runWhite));
+	memset(moves, 0, sizeof(moves));
+	for (int i = 1; i < last; i += 4)  {
+		__m256i occupied = _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (black+i)), _mm256_loadu_si256((const __m256i*) (white+i)));
+		_mm256_storeu_si256((__m256i*) (empty+i), _mm256_andnot_si256(occupied, _mm256_loadu_si256((const __m256i*) (geo->paddedBoard+i))));
+	}
+
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*pos->dim + directionCol[d];
+		__m128i left = _mm_cvtsi32_si128(amount > 0 ? amount : -amount), right = _mm_cvtsi32_si128(64 - (amount > 0 ? amount : -amount));
+		const uint64_t* landing = geo->paddedLanding[d];
+		__m256i any = _mm256_setzero_si256();
+
+		//Starts the runs of both colours: the opposing discs next to each colour's discs. The shifted vectors are all computed before any is stored, since a shift reads its neighbours
+		for (int i = 1; i < last; i += 4)  {
+			__m256i mask = _mm256_loadu_si256((const __m256i*) (landing+i));
+			__m256i nextBlack = _mm256_and_si256(_mm256_and_si256(SHIFT_AVX2(black, i, amount), mask), _mm256_loadu_si256((const __m256i*) (white+i)));
+			__m256i nextWhite = _mm256_and_si256(_mm256_and_si256(SHIFT_AVX2(white, i, amount), mask), _mm256_loadu_si256((const __m256i*) (black+i)));
+			_mm256_storeu_si256((__m256i*) (runBlack+i), nextBlack);
+			_mm256_storeu_si256((__m256i*) (runWhite+i), nextWhite);
+			any = _mm256_or_si256(any, _mm256_or_si256(nextBlack, nextWhite));
+		}
+		//Steps both sets of fronts forward together until neither colour has a run left to follow
+		while (!_mm256_testz_si256(any, any))  {
+			__m256i stepBlack[4], stepWhite[4];
+			int vectors = 0;
+
+			for (int i = 1; i < last; i += 4, vectors++)  {
+				__m256i mask = _mm256_loadu_si256((const __m256i*) (landing+i));
+				stepBlack[vectors] = _mm256_and_si256(SHIFT_AVX2(runBlack, i, amount), mask);
+				stepWhite[vectors] = _mm256_and_si256(SHIFT_AVX2(runWhite, i, amount), mask);
+			}
+			any = _mm256_setzero_si256();
+			vectors = 0;
+			for (int i = 1; i < last; i += 4, vectors++)  {
+				__m256i space = _mm256_loadu_si256((const __m256i*) (empty+i));
+				__m256i nextBlack = _mm256_and_si256(stepBlack[vectors], _mm256_loadu_si256((const __m256i*) (white+i)));
+				__m256i nextWhite = _mm256_and_si256(stepWhite[vectors], _mm256_loadu_si256((const __m256i*) (black+i)));
+				_mm256_storeu_si256((__m256i*) (moves[BLACK]+i), _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (moves[BLACK]+i)), _mm256_and_si256(stepBlack[vectors], space)));
+				_mm256_storeu_si256((__m256i*) (moves[WHITE]+i), _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (moves[WHITE]+i)), _mm256_and_si256(stepWhite[vectors], space)));
+				_mm256_storeu_si256((__m256i*) (runBlack+i), nextBlack);
+				_mm256_storeu_si256((__m256i*) (runWhite+i), nextWhite);
+				any = _mm256_or_si256(any, _mm256_or_si256(nextBlack, nextWhite));
+			}
+		}
+	}
+	unpadBitboard(&legal->moves[BLACK], moves[BLACK], words);
+	unpadBitboard(&legal->moves[WHITE], moves[WHITE], words);
+	legal->count[BLACK] = countSquares(&legal->moves[BLACK], words);
+	legal->count[WHITE] = countSquares(&legal->moves[WHITE], words);
+}
+
+/**
+ * @brief Generates every legal move for one side with AVX2, four words at a time
+ *
+ * Follows movesOfSide step for step, so its result is identical
+ *
+ * @param pos The position being checked
+ * @param side The colour index of the player whose moves are generated
+ * @param moves Receives one bit for every square where the player can legally move
+ */
+static __attribute__((target("avx2"))) void generateMovesAvx2 (const Position* pos, int side, Bitboard* moves)  {
+	const Geometry* geo = geometryFor(pos->dim);
+	int words = pos->words, last = 1 + 4*((words+3)/4);
+	uint64_t own[PADDED_WORDS], opp[PADDED_WORDS], run[PADDED_WORDS], empty[PADDED_WORDS], found[PADDED_WORDS];
+
+	padBitboard(own, &pos->disc[side], words);
+	padBitboard(opp, &pos->disc[1-side], words);
+	memset(run, 0, sizeof(run));
+	memset(found, 0, sizeof(found));
+	for (int i = 1; i < last; i += 4)  {
+		__m256i occupied = _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (own+i)), _mm256_loadu_si256((const __m256i*) (opp+i)));
+		_mm256_storeu_si256((__m256i*) (empty+i), _mm256_andnot_si256(occupied, _mm256_loadu_si256((const __m256i*) (geo->paddedBoard+i))));
+	}
+
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*pos->dim + directionCol[d];
+		__m128i left = _mm_cvtsi32_si128(amount > 0 ? amount : -amount), right = _mm_cvtsi32_si128(64 - (amount > 0 ? amount : -amount));
+		const uint64_t* landing = geo->paddedLanding[d];
+		__m256i any = _mm256_setzero_si256();
+
+		//Starts with the opposing discs that sit next to one of the mover's discs
+		for (int i = 1; i < last; i += 4)  {
+			__m256i next = _mm256_and_si256(_mm256_and_si256(SHIFT_AVX2(own, i, amount), _mm256_loadu_si256((const __m256i*) (landing+i))), _mm256_loadu_si256((const __m256i*) (opp+i)));
+			_mm256_storeu_si256((__m256i*) (run+i), next);
+			any = _mm256_or_si256(any, next);
+		}
+		//Steps the front of every run forward until it leaves the opposing discs; empty squares reached by a front are legal moves
+		while (!_mm256_testz_si256(any, any))  {
+			__m256i step[4];
+			int vectors = 0;
+
+			for (int i = 1; i < last; i += 4, vectors++)  {
+				step[vectors] = _mm256_and_si256(SHIFT_AVX2(run, i, amount), _mm256_loadu_si256((const __m256i*) (landing+i)));
+			}
+			any = _mm256_setzero_si256();
+			vectors = 0;
+			for (int i = 1; i < last; i += 4, vectors++)  {
+				__m256i next = _mm256_and_si256(step[vectors], _mm256_loadu_si256((const __m256i*) (opp+i)));
+				_mm256_storeu_si256((__m256i*) (found+i), _mm256_or_si256(_mm256_loadu_si256((const __m256i*) (found+i)), _mm256_and_si256(step[vectors], _mm256_loadu_si256((const __m256i*) (empty+i)))));
+				_mm256_storeu_si256((__m256i*) (run+i), next);
+				any = _mm256_or_si256(any, next);
+			}
+		}
+	}
+	unpadBitboard(moves, found, words);
+}
+
+/**
+ * @brief Checks whether any bit of an SSE2 vector is set; SSE2 has no single instruction for it
+ */
+static inline bool anySse2 (__m128i bits)  {
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0xffff;
+}
+
+/**
+ * @brief Generates every legal move of both colours with SSE2, two words at a time
+ *
+ * Follows movesOfBoth step for step, so its result is identical
+ *
+ * @param pos The position being checked
+ * @param legal Receives the legal moves of both colours and how many there are
+ */
+static void generateLegalMovesSse2 (const Position* pos, LegalMoves* legal)  {
+	const Geometry* geo = geometryFor(pos->dim);
+	int words = pos->words, last = 1 + 2*((words+1)/2);
+	uint64_t black[PADDED_WORDS], white[PADDED_WORDS], runBlack[PADDED_WORDS], runWhite[PADDED_WORDS], empty[PADDED_WORDS], moves[2][PADDED_WORDS];
+
+	padBitboard(black, &pos->disc[BLACK], words);
+	padBitboard(white, &pos->disc[WHITE], words);
+	memset(runBlack, 0, sizeof(runBlack));
+	memset(runWhite, 0, sizeof(runWhite));
+	memset(moves, 0, sizeof(moves));
+	for (int i = 1; i < last; i += 2)  {
+		__m128i occupied = _mm_or_si128(_mm_loadu_si128((const __m128i*) (black+i)), _mm_loadu_si128((const __m128i*) (white+i)));
+		_mm_storeu_si128((__m128i*) (empty+i), _mm_andnot_si128(occupied, _mm_loadu_si128((const __m128i*) (geo->paddedBoard+i))));
+	}
+
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*pos->dim + directionCol[d];
+		__m128i left = _mm_cvtsi32_si128(amount > 0 ? amount : -amount), right = _mm_cvtsi32_si128(64 - (amount > 0 ? amount : -amount));
+		const uint64_t* landing = geo->paddedLanding[d];
+		__m128i any = _mm_setzero_si128();
+
+		for (int i = 1; i < last; i += 2)  {
+			__m128i mask = _mm_loadu_si128((const __m128i*) (landing+i));
+			__m128i nextBlack = _mm_and_si128(_mm_and_si128(SHIFT_SSE2(black, i, amount), mask), _mm_loadu_si128((const __m128i*) (white+i)));
+			__m128i nextWhite = _mm_and_si128(_mm_and_si128(SHIFT_SSE2(white, i, amount), mask), _mm_loadu_si128((const __m128i*) (black+i)));
+			_mm_storeu_si128((__m128i*) (runBlack+i), nextBlack);
+			_mm_storeu_si128((__m128i*) (runWhite+i), nextWhite);
+			any = _mm_or_si128(any, _mm_or_si128(nextBlack, nextWhite));
+		}
+		while (anySse2(any))  {
+			__m128i stepBlack[6], stepWhite[6];
+			int vectors = 0;
+
+			for (int i = 1; i < last; i += 2, vectors++)  {
+				__m128i mask = _mm_loadu_si128((const __m128i*) (landing+i));
+				stepBlack[vectors] = _mm_and_si128(SHIFT_SSE2(runBlack, i, amount), mask);
+				stepWhite[vectors] = _mm_and_si128(SHIFT_SSE2(runWhite, i, amount), mask);
+			}
+			any = _mm_setzero_si128();
+			vectors = 0;
+			for (int i = 1; i < last; i += 2, vectors++)  {
+				__m128i space = _mm_loadu_si128((const __m128i*) (empty+i));
+				__m128i nextBlack = _mm_and_si128(stepBlack[vectors], _mm_loadu_si128((const __m128i*) (white+i)));
+				__m128i nextWhite = _mm_and_si128(stepWhite[vectors], _mm_loadu_si128((const __m128i*) (black+i)));
+				_mm_storeu_si128((__m128i*) (moves[BLACK]+i), _mm_or_si128(_mm_loadu_si128((const __m128i*) (moves[BLACK]+i)), _mm_and_si128(stepBlack[vectors], space)));
+				_mm_storeu_si128((__m128i*) (moves[WHITE]+i), _mm_or_si128(_mm_loadu_si128((const __m128i*) (moves[WHITE]+i)), _mm_and_si128(stepWhite[vectors], space)));
+				_mm_storeu_si128((__m128i*) (runBlack+i), nextBlack);
+				_mm_storeu_si128((__m128i*) (runWhite+i), nextWhite);
+				any = _mm_or_si128(any, _mm_or_si128(nextBlack, nextWhite));
+			}
+		}
+	}
+	unpadBitboard(&legal->moves[BLACK], moves[BLACK], words);
+	unpadBitboard(&legal->moves[WHITE], moves[WHITE], words);
+	legal->count[BLACK] = countSquares(&legal->moves[BLACK], words);
+	legal->count[WHITE] = countSquares(&legal->moves[WHITE], words);
+}
+
+/**
+ * @brief Generates every legal move for one side with SSE2, two words at a time
+ *
+ * Follows movesOfSide step for step, so its result is identical
+ *
+ * @param pos The position being checked
+ * @param side The colour index of the player whose moves are generated
+ * @param moves Receives one bit for every square where the player can legally move
+ */
+static void generateMovesSse2 (const Position* pos, int side, Bitboard* moves)  {
+	const Geometry* geo = geometryFor(pos->dim);
+	int words = pos->words, last = 1 + 2*((words+1)/2);
+	uint64_t own[PADDED_WORDS], opp[PADDED_WORDS], run[PADDED_WORDS], empty[PADDED_WORDS], found[PADDED_WORDS];
+
+	padBitboard(own, &pos->disc[side], words);
+	padBitboard(opp, &pos->disc[1-side], words);
+	memset(run, 0, sizeof(run));
+	memset(found, 0, sizeof(found));
+	for (int i = 1; i < last; i += 2)  {
+		__m128i occupied = _mm_or_si128(_mm_loadu_si128((const __m128i*) (own+i)), _mm_loadu_si128((const __m128i*) (opp+i)));
+		_mm_storeu_si128((__m128i*) (empty+i), _mm_andnot_si128(occupied, _mm_loadu_si128((const __m128i*) (geo->paddedBoard+i))));
+	}
+
+	for (int d = 0; d < 8; d++)  {
+		int amount = directionRow[d]*pos->dim + directionCol[d];
+		__m128i left = _mm_cvtsi32_si128(amount > 0 ? amount : -amount), right = _mm_cvtsi32_si128(64 - (amount > 0 ? amount : -amount));
+		const uint64_t* landing = geo->paddedLanding[d];
+		__m128i any = _mm_setzero_si128();
+
+		for (int i = 1; i < last; i += 2)  {
+			__m128i next = _mm_and_si128(_mm_and_si128(SHIFT_SSE2(own, i, amount), _mm_loadu_si128((const __m128i*) (landing+i))), _mm_loadu_si128((const __m128i*) (opp+i)));
+			_mm_storeu_si128((__m128i*) (run+i), next);
+			any = _mm_or_si128(any, next);
+		}
+		while (anySse2(any))  {
+			__m128i step[6];
+			int vectors = 0;
+
+			for (int i = 1; i < last; i += 2, vectors++)  {
+				step[vectors] = _mm_and_si128(SHIFT_SSE2(run, i, amount), _mm_loadu_si128((const __m128i*) (landing+i)));
+			}
+			any = _mm_setzero_si128();
+			vectors = 0;
+			for (int i = 1; i < last; i += 2, vectors++)  {
+				__m128i next = _mm_and_si128(step[vectors], _mm_loadu_si128((const __m128i*) (opp+i)));
+				_mm_storeu_si128((__m128i*) (found+i), _mm_or_si128(_mm_loadu_si128((const __m128i*) (found+i)), _mm_and_si128(step[vectors], _mm_loadu_si128((const __m128i*) (empty+i)))));
+				_mm_storeu_si128((__m128i*) (run+i), next);
+				any = _mm_or_si128(any, next);
+			}
+		}
+	}
+	unpadBitboard(moves, found, words);
+}
+
+#endif
+
+//Whether the kernels have been chosen for this processor, and which instruction set they use
+static bool kernelsChosen = false;
+static int kernelLevel = SIMD_SCALAR;
+
+//The kernels of each board size; sizes without their own use the ones for any size. Move generation on boards of SIMD_MIN_DIM and larger is switched to the vector kernels by selectSimd
+#define ANY_SIZE_KERNELS {generateMovesAnySize, generateLegalMovesAnySize, computeFlipsAnySize}
+static BoardKernels boardKernels[MAX_DIM+1] = {
+	ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS,
+	{generateMovesSize8, generateLegalMovesSize8, computeFlipsSize8}, ANY_SIZE_KERNELS, {generateMovesSize10, generateLegalMovesSize10, computeFlipsSize10},
+	ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, {generateMovesSize16, generateLegalMovesSize16, computeFlipsSize16},
+	ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS, ANY_SIZE_KERNELS
+};
+#undef ANY_SIZE_KERNELS
+
+/**
+ * @brief The best instruction set the processor running the program offers to the move generation
+ *
+ * @return SIMD_AVX2, SIMD_SSE2 or SIMD_SCALAR
+ */
+int simdSupported (void)  {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))  {
+		return SIMD_AVX2;
+	}
+	if (__builtin_cpu_supports("sse2"))  {
+		return SIMD_SSE2;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+/**
+ * @brief Chooses the instruction set of the move generation on boards of SIMD_MIN_DIM and larger
+ *
+ * Every choice gives exactly the same moves. Must not be called while another thread is generating moves
+ *
+ * @param level SIMD_SCALAR, SIMD_SSE2 or SIMD_AVX2
+ *
+ * @return Whether the processor offers the instruction set; if not, nothing changes
+ */
+bool selectSimd (int level)  {
+	if (level < SIMD_SCALAR || level > simdSupported())  {
+		return false;
+	}
+	for (int dim = SIMD_MIN_DIM; dim <= MAX_DIM; dim++)  {
+		BoardKernels* kernels = &boardKernels[dim];
+		//The scalar kernels of each size are put back first, as the vector kernels only replace move generation
+		kernels->generateMoves = dim == 16 ? generateMovesSize16 : generateMovesAnySize;
+		kernels->generateLegalMoves = dim == 16 ? generateLegalMovesSize16 : generateLegalMovesAnySize;
+#if defined(__x86_64__) || defined(__i386__)
+		if (level == SIMD_AVX2)  {
+			kernels->generateMoves = generateMovesAvx2;
+			kernels->generateLegalMoves = generateLegalMovesAvx2;
+		}
+		else if (level == SIMD_SSE2)  {
+			kernels->generateMoves = generateMovesSse2;
+			kernels->generateLegalMoves = generateLegalMovesSse2;
+		}
+#endif
+	}
+	kernelLevel = level;
+	kernelsChosen = true;
+	return true;
+}
+
+/**
+ * @brief The instruction set the move generation uses
+ */
+int selectedSimd (void)  {
+	return kernelLevel;
+}
+
+/**
+ * @brief The name of an instruction set, for reports
+ */
+const char* simdName (int level)  {
+	return level == SIMD_AVX2 ? "avx2" : level == SIMD_SSE2 ? "sse2" : "scalar";
+}
+
+//Makes sure the tables below are built exactly once, whichever thread sets up the first position
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Builds the tables every board size shares: the Zobrist keys, the masks of every size, and the best kernels for the processor unless a choice has already been made
+ *
+ * Every size is built at once, so threads that later set up positions of sizes not yet played only ever read the tables
+ */
+static void buildTables (void)  {
+	initZobrist();
+	for (int dim = 0; dim <= MAX_DIM; dim++)  {
+		buildGeometry(dim);
+	}
+	if (!kernelsChosen)  {
+		selectSimd(simdSupported());
+	}
+}
+
+/**
+ * @brief Builds the shared tables the first time any thread sets up a position; later calls, from any thread, return once they are built
+ */
+static void initTables (void)  {
+	pthread_once(&tablesOnce, buildTables);
+}
+
+/**
+ * @brief Generates every legal move for one side
+ *
+ * @param pos The position being checked
+ * @param side The colour index of the player whose moves are generated
+ * @param moves Receives one bit for every square where the player can legally move
+ */
+void generateMoves (const Position* pos, int side, Bitboard* moves)  {
+	boardKernels[pos->dim].generateMoves(pos, side, moves);
+}
+
+/**
+ * @brief Generates every legal move of both colours in a single pass over the 8 directions
+ *
+ * Used wherever both sides matter, such as checking whether the game is over or whether a player has to pass, so neither colour needs a separate pass or a test move on every square
+ *
+ * @param pos The position being checked
+ * @param legal Receives the legal moves of both colours and how many there are
+ */
+void generateLegalMoves (const Position* pos, LegalMoves* legal)  {
+	boardKernels[pos->dim].generateLegalMoves(pos, legal);
+}
+
+/**
+ * @brief Finds every disc that a move would flip, without changing the position
+ *
+ * Follows the rules moveAtLocation has always applied: a direction flips only if it has at least one opposing disc followed directly by one of the mover's discs, and a move on an occupied square flips
+ * nothing
+ *
+ * @param pos The position being checked
+ * @param side The colour index of the player making the move
+ * @param square The square the move is played on
+ * @param flips Receives the discs that are flipped
+ * @param directionCounts If not NULL, receives the number of discs flipped in each of the 8 directions
+ *
+ * @return The total number of discs flipped; 0 if the move is not legal
+ */
+int computeFlips (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts)  {
+	return boardKernels[pos->dim].computeFlips(pos, side, square, flips, directionCounts);
+}
+
+/**
+ * @brief Plays a move whose flips were found by computeFlips
+ *
+ * @param pos The position the move is played on
+ * @param side The colour index of the player making the move
+ * @param square The square the move is played on
+ * @param flips The discs flipped by the move
+ */
+void applyMove (Position* pos, int side, int square, const Bitboard* flips)  {
+	Bitboard flipped = *flips;
+	const PatternLinks* links = patternLinks(pos->dim);
+
+	for (int i = 0; i < pos->words; i++)  {
+		pos->disc[side].word[i] |= flips->word[i];
+		pos->disc[1-side].word[i] &= ~flips->word[i];
+	}
+	setSquare(&pos->disc[side], square);
+	pos->hash ^= zobristDisc[side][square];
+	placePatternDisc(pos, links, square, side);
+	for (int f = popSquare(&flipped, pos->words); f != -1; f = popSquare(&flipped, pos->words))  {
+		pos->hash ^= zobristFlip[f];
+		flipPatternDisc(pos, links, f, side);
+	}
+}
+
+/**
+ * @brief Hands the move to the other side, updating the hash
+ *
+ * Used after applyMove, which changes only the discs, and on its own when the side to move passes
+ *
+ * @param pos The position whose side to move changes
+ */
+void passTurn (Position* pos)  {
+	pos->side = 1-pos->side;
+	pos->hash ^= zobristWhiteToMove;
+}
+
+/**
+ * @brief Plays a move for the side to move and records how to take it back
+ *
+ * Only the squares that are flipped are written to the undo stack, so making and unmaking a move costs time in proportion to the number of flips rather than to the size of the board
+ *
+ * @param pos The position the move is played on; the side to move passes to the opponent
+ * @param square The square the move is played on, or PASS_MOVE to pass the turn
+ * @param undo The stack the move is recorded on
+ *
+ * @return The number of discs flipped; 0 for a pass, or for an illegal move, which leaves the position and the stack untouched
+ */
+int makeMove (Position* pos, int square, UndoStack* undo)  {
+	Bitboard flips;
+	UndoRecord* record;
+	int count = 0, side = pos->side;
+
+	if (square != PASS_MOVE)  {
+		count = computeFlips(pos, side, square, &flips, NULL);
+		if (count == 0)  {
+			return 0;
+		}
+	}
+	record = &undo->record[undo->moves++];
+	record->square = square;
+	record->flipCount = count;
+	record->hash = pos->hash;
+	if (square != PASS_MOVE)  {
+		const PatternLinks* links = patternLinks(pos->dim);
+
+		memcpy(record->pattern, pos->pattern, sizeof(pos->pattern));
+		//Turns over each flipped disc, recording its square and updating the hash and pattern indices as it goes
+		for (int flipped = popSquare(&flips, pos->words); flipped != -1; flipped = popSquare(&flips, pos->words))  {
+			uint64_t bit = (uint64_t) 1 << (flipped & 63);
+			pos->disc[side].word[flipped >> 6] |= bit;
+			pos->disc[1-side].word[flipped >> 6] &= ~bit;
+			pos->hash ^= zobristFlip[flipped];
+			flipPatternDisc(pos, links, flipped, side);
+			undo->flipped[undo->flips++] = (uint16_t) flipped;
+		}
+		setSquare(&pos->disc[side], square);
+		pos->hash ^= zobristDisc[side][square];
+		placePatternDisc(pos, links, square, side);
+	}
+	pos->side = 1-side;
+	pos->hash ^= zobristWhiteToMove;
+	return count;
+}
+
+/**
+ * @brief Takes back the last move recorded on an undo stack
+ *
+ * @param pos The position the move was played on
+ * @param undo The stack the move was recorded on
+ */
+void unmakeMove (Position* pos, UndoStack* undo)  {
+	UndoRecord* record = &undo->record[--undo->moves];
+	int side = 1-pos->side;
+
+	pos->side = side;
+	if (record->square != PASS_MOVE)  {
+		//Turns the flipped discs back over, then lifts the disc that was placed
+		for (int i = 0; i < record->flipCount; i++)  {
+			int flipped = undo->flipped[--undo->flips];
+			uint64_t bit = (uint64_t) 1 << (flipped & 63);
+			pos->disc[side].word[flipped >> 6] &= ~bit;
+			pos->disc[1-side].word[flipped >> 6] |= bit;
+		}
+		pos->disc[side].word[record->square >> 6] &= ~((uint64_t) 1 << (record->square & 63));
+		memcpy(pos->pattern, record->pattern, sizeof(pos->pattern));
+	}
+	pos->hash = record->hash;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file bitboard.h
+ * @brief Bitboard representation of a reversi position, with shift-and-mask move generation and flipping
+ *
+ * Square (row, col) of an n x n board is stored as bit row*n+col of a multi-word bitboard, one bitboard per colour. An 8 x 8 board therefore fits in a single 64-bit word per colour, and the
+ * largest board that setBoard can label (26 x 26) fits in MAX_WORDS words per colour
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+//Largest board size that can be labelled with the letters 'a' to 'z'
+#define MAX_DIM 26
+//Largest number of squares on a board, and the number of 64-bit words needed to store one bit for each of them
+#define MAX_SQUARES (MAX_DIM*MAX_DIM)
+#define MAX_WORDS ((MAX_SQUARES+63)/64)
+
+//Colour indices used by the engine; the other colour is always 1-colour
+#define BLACK 0
+#define WHITE 1
+
+//The square used for a player who has no legal move and passes the turn
+#define PASS_MOVE -1
+
+//Instruction sets the move generation of large boards can use; the best one the processor offers is chosen when the first position is set up
+#define SIMD_SCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+//Smallest board whose move generation uses the vector kernels: the first size that takes 4 words per bitboard. Below it the scalar code is as fast
+#define SIMD_MIN_DIM 14
+
+//Most moves an undo stack can hold (every square filled, with a pass before each move), and most flipped discs those moves can record (each move flips at most n-2 discs in each direction)
+#define MAX_UNDO_MOVES (2*MAX_SQUARES)
+#define MAX_UNDO_FLIPS ((MAX_SQUARES-4)*8*(MAX_DIM-2))
+
+/**
+ * @brief One bit per square of the board
+ */
+typedef struct  {
+	uint64_t word[MAX_WORDS];
+} Bitboard;
+
+//Patterns of squares kept indexed in every position, 4 at each corner; see pattern.h
+#define PATTERN_INSTANCES 16
+
+/**
+ * @brief A board together with the side to move
+ */
+typedef struct  {
+	int dim;			//The size n of the n x n board
+	int words;			//The number of words of each bitboard that hold squares of this board
+	int side;			//The colour index of the player to move
+	Bitboard disc[2];	//The discs of each colour, indexed by BLACK and WHITE
+	uint64_t hash;		//Zobrist hash of the board size, the discs and the side to move; kept up to date by every move
+	int pattern[PATTERN_INSTANCES];	//The table index of each corner pattern's contents; kept up to date by every move, and all 0 on boards too small for patterns
+} Position;
+
+/**
+ * @brief What is needed to take back one move made by makeMove
+ */
+typedef struct  {
+	int square;			//The square the move was played on, or PASS_MOVE
+	int flipCount;		//The number of discs the move flipped; the squares are the last flipCount entries of the stack's flipped list
+	uint64_t hash;		//The hash of the position before the move
+	int pattern[PATTERN_INSTANCES];	//The pattern indices of the position before the move
+} UndoRecord;
+
+/**
+ * @brief Moves made on a position, newest last, with only the squares each move flipped
+ *
+ * Large enough for any sequence of moves on any board; allocate it once and reuse it for every make and unmake
+ */
+typedef struct  {
+	int moves;
+	int flips;
+	UndoRecord record[MAX_UNDO_MOVES];
+	uint16_t flipped[MAX_UNDO_FLIPS];
+} UndoStack;
+
+/**
+ * @brief The legal moves of both colours in a position
+ */
+typedef struct  {
+	Bitboard moves[2];	//One bit for every square where each colour can legally move, indexed by BLACK and WHITE
+	int count[2];		//The number of legal moves of each colour
+} LegalMoves;
+
+//Direction vectors, ordered Northwest, North, Northeast, West, East, Southwest, South, Southeast; the same order moveAtLocation has always used for its score vector
+extern const int directionRow[8];
+extern const int directionCol[8];
+
+/**
+ * @brief Tests whether a square is set in a bitboard
+ */
+static inline bool testSquare (const Bitboard* bits, int square)  {
+	return (bits->word[square >> 6] >> (square & 63)) & 1;
+}
+
+/**
+ * @brief Sets a square in a bitboard
+ */
+static inline void setSquare (Bitboard* bits, int square)  {
+	bits->word[square >> 6] |= (uint64_t) 1 << (square & 63);
+}
+
+/**
+ * @brief Clears every square of a bitboard
+ */
+static inline void clearBitboard (Bitboard* bits)  {
+	memset(bits, 0, sizeof(Bitboard));
+}
+
+/**
+ * @brief Empties an undo stack
+ */
+static inline void clearUndoStack (UndoStack* undo)  {
+	undo->moves = 0;
+	undo->flips = 0;
+}
+
+/**
+ * @brief Converts between the 'B'/'W' characters used on the game board and the engine's colour indices
+ */
+static inline int colourIndex (char colour)  {
+	return colour == 'W' ? WHITE : BLACK;
+}
+
+static inline char colourChar (int colour)  {
+	return colour == WHITE ? 'W' : 'B';
+}
+
+uint64_t computeHash (const Position* pos);
+void positionInit (Position* pos, int dim);
+void positionFromBoard (Position* pos, char** board, int dim, char colour);
+void positionToBoard (const Position* pos, char** board);
+int countSquares (const Bitboard* bits, int words);
+bool anySquare (const Bitboard* bits, int words);
+int popSquare (Bitboard* bits, int words);
+int simdSupported (void);
+bool selectSimd (int level);
+int selectedSimd (void);
+const char* simdName (int level);
+void generateMoves (const Position* pos, int side, Bitboard* moves);
+void generateLegalMoves (const Position* pos, LegalMoves* legal);
+uint64_t generateMoves8x8 (uint64_t own, uint64_t opp);
+uint64_t computeFlips8x8 (uint64_t own, uint64_t opp, int square);
+int computeFlips (const Position* pos, int side, int square, Bitboard* flips, int* directionCounts);
+void applyMove (Position* pos, int side, int square, const Bitboard* flips);
+void passTurn (Position* pos);
+int makeMove (Position* pos, int square, UndoStack* undo);
+void unmakeMove (Position* pos, UndoStack* undo);
+
+#endif
@@ -0,0 +1,211 @@
+/**
+ * @file book.c
+ * @brief Opening book: the results of moves played from known positions, in a sorted binary file that is mapped into memory
+ *
+ * A book file is a BookHeader followed by its entries, sorted by position hash and then by move, in the byte order of the machine that built it. Opening a book maps the file read-only and
+ * checks its header, without reading any entry, so it costs nothing at startup however large the book is; the pages a lookup touches are read on demand and shared by every process that has
+ * the same file open. A lookup is a binary search over the entries. Books are rewritten whole, to a temporary file that is then renamed over the old one, so a process that still has the old
+ * file mapped keeps reading it unchanged
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "book.h"
+#include "arena.h"
+
+//First bytes of a book file
+static const char bookMagic[4] = {'R', 'V', 'B', 'K'};
+
+/**
+ * @brief Maps a book file into memory
+ *
+ * @param path The file
+ *
+ * @return The open book, or NULL if the file cannot be read or is not a book of this version
+ */
+OpeningBook* bookOpen (const char* path)  {
+	OpeningBook* book;
+	const BookHeader* header;
+	struct stat status;
+	void* mapping;
+	int file = open(path, O_RDONLY);
+
+	if (file < 0)  {
+		return NULL;
+	}
+	if (fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(BookHeader))  {
+		close(file);
+		return NULL;
+	}
+	//The mapping stays valid once the file is closed
+	mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED)  {
+		return NULL;
+	}
+	header = (const BookHeader*) mapping;
+	book = (OpeningBook*) engineMalloc(sizeof(OpeningBook));
+	if (book == NULL || memcmp(header->magic, bookMagic, 4) != 0 || header->version != BOOK_VERSION ||
+		sizeof(BookHeader) + header->count*sizeof(BookEntry) != (size_t) status.st_size)  {
+		engineFree(book);
+		munmap(mapping, (size_t) status.st_size);
+		return NULL;
+	}
+	book->entries = (const BookEntry*) (header+1);
+	book->count = (size_t) header->count;
+	book->minGames = header->minGames;
+	book->mapping = mapping;
+	book->bytes = (size_t) status.st_size;
+	return book;
+}
+
+/**
+ * @brief Unmaps a book
+ */
+void bookClose (OpeningBook* book)  {
+	if (book == NULL)  {
+		return;
+	}
+	munmap(book->mapping, book->bytes);
+	engineFree(book);
+}
+
+/**
+ * @brief Finds the best move the book knows for a position
+ *
+ * Of the moves played from the position in at least the book's minimum number of games, the one with the best average result for the side that played it is chosen, preferring the one played more often on a tie. Moves that are not legal
+ * in the position are passed over, so a position that only shares its hash with a book position is never given a move from it
+ *
+ * @param book The book
+ * @param pos The position
+ * @param move Receives the move
+ * @param score Receives the move's average final disc differential for the side to move
+ *
+ * @return Whether the book had a legal move for the position
+ */
+bool bookLookup (const OpeningBook* book, const Position* pos, int* move, int* score)  {
+	size_t low = 0, high = book->count;
+	const BookEntry* best = NULL;
+	Bitboard flips;
+
+	//The first entry whose hash is not below the position's
+	while (low < high)  {
+		size_t middle = low + (high-low)/2;
+		if (book->entries[middle].hash < pos->hash)  {
+			low = middle+1;
+		}
+		else  {
+			high = middle;
+		}
+	}
+	for (const BookEntry* entry = &book->entries[low]; entry < book->entries+book->count && entry->hash == pos->hash; entry++)  {
+		if (entry->games == 0 || entry->games < book->minGames || entry->move < 0 || entry->move >= pos->dim*pos->dim || computeFlips(pos, pos->side, entry->move, &flips, NULL) == 0)  {
+			continue;
+		}
+		//Compares the averages without dividing: a/b > c/d exactly when a*d > c*b for positive b and d
+		if (best == NULL || (int64_t) entry->resultSum*best->games > (int64_t) best->resultSum*entry->games ||
+			((int64_t) entry->resultSum*best->games == (int64_t) best->resultSum*entry->games && entry->games > best->games))  {
+			best = entry;
+		}
+	}
+	if (best == NULL)  {
+		return false;
+	}
+	*move = best->move;
+	*score = best->resultSum / best->games;
+	return true;
+}
+
+/**
+ * @brief Orders book entries by hash and then by move, for qsort
+ */
+int compareBookEntries (const void* a, const void* b)  {
+	const BookEntry* x = (const BookEntry*) a;
+	const BookEntry* y = (const BookEntry*) b;
+
+	if (x->hash != y->hash)  {
+		return x->hash < y->hash ? -1 : 1;
+	}
+	return x->move - y->move;
+}
+
+/**
+ * @brief Sorts entries and combines every run of entries for the same position and move into one
+ *
+ * @param entries The entries, which are sorted and compacted in place
+ * @param count The number of entries
+ *
+ * @return The number of entries left
+ */
+size_t mergeBookEntries (BookEntry* entries, size_t count)  {
+	size_t kept = 0;
+
+	qsort(entries, count, sizeof(BookEntry), compareBookEntries);
+	for (size_t i = 0; i < count; i++)  {
+		if (kept > 0 && entries[kept-1].hash == entries[i].hash && entries[kept-1].move == entries[i].move)  {
+			BookEntry* merged = &entries[kept-1];
+			//Past UINT16_MAX games, the average is kept and the count stops
+			if ((uint32_t) merged->games + entries[i].games > UINT16_MAX)  {
+				merged->resultSum = (int32_t) ((int64_t) (merged->resultSum + entries[i].resultSum) * UINT16_MAX / ((int64_t) merged->games + entries[i].games));
+				merged->games = UINT16_MAX;
+			}
+			else  {
+				merged->resultSum += entries[i].resultSum;
+				merged->games += entries[i].games;
+			}
+		}
+		else  {
+			entries[kept++] = entries[i];
+		}
+	}
+	return kept;
+}
+
+/**
+ * @brief Writes a book, replacing any book already at the path only once the new one is complete
+ *
+ * @param path The file
+ * @param entries The entries, sorted by compareBookEntries with no two for the same position and move
+ * @param count The number of entries
+ * @param minGames Fewest games a move must have been played in for a lookup to choose it
+ *
+ * @return Whether the book was written
+ */
+bool bookWrite (const char* path, const BookEntry* entries, size_t count, int minGames)  {
+	BookHeader header;
+	size_t length = strlen(path);
+	char* temporary = (char*) engineMalloc(length+5);
+	FILE* file;
+	bool written;
+
+	if (temporary == NULL)  {
+		return false;
+	}
+	memcpy(temporary, path, length);
+	memcpy(temporary+length, ".tmp", 5);
+	file = fopen(temporary, "wb");
+	if (file == NULL)  {
+		engineFree(temporary);
+		return false;
+	}
+	memset(&header, 0, sizeof(BookHeader));
+	memcpy(header.magic, bookMagic, 4);
+	header.version = BOOK_VERSION;
+	header.minGames = (uint16_t) (minGames < 1 ? 1 : minGames > UINT16_MAX ? UINT16_MAX : minGames);
+	header.count = count;
+	written = fwrite(&header, sizeof(BookHeader), 1, file) == 1 && fwrite(entries, sizeof(BookEntry), count, file) == count;
+	written = fclose(file) == 0 && written && rename(temporary, path) == 0;
+	if (!written)  {
+		remove(temporary);
+	}
+	engineFree(temporary);
+	return written;
+}
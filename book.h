@@ -0,0 +1,66 @@
+/**
+ * @file book.h
+ * @brief Opening book: the results of moves played from known positions, in a sorted binary file that is mapped into memory
+ */
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+
+//Version of the file layout, stored after the magic bytes
+#define BOOK_VERSION 1
+
+/**
+ * @brief The results of one move from one position, over every game the book was built from
+ *
+ * Entries are sorted by hash and then by move, so all the moves of a position lie together and one binary search finds them
+ */
+typedef struct  {
+	uint64_t hash;			//Zobrist hash of the position, which includes the board size and the side to move
+	int32_t resultSum;		//Final disc differentials for the side that played the move, added over every game
+	uint16_t games;			//Games in which the move was played from the position; stops counting at UINT16_MAX
+	int16_t move;			//The square of the move
+} BookEntry;
+
+/**
+ * @brief The start of a book file, followed directly by its entries
+ */
+typedef struct  {
+	char magic[4];
+	uint16_t version;
+	uint16_t minGames;		//Fewest games a move must have been played in to be chosen; moves played less are kept, so a later build can add to them
+	uint64_t count;			//The number of entries
+} BookHeader;
+
+/**
+ * @brief An open book: the file's entries, mapped read-only so every process using the file shares its pages
+ */
+typedef struct  {
+	const BookEntry* entries;
+	size_t count;
+	int minGames;
+	void* mapping;
+	size_t bytes;
+} OpeningBook;
+
+/**
+ * @brief How often an engine found its move in its book
+ */
+typedef struct  {
+	uint64_t probes;		//Positions looked up
+	uint64_t hits;			//Positions whose move came from the book
+} BookStats;
+
+OpeningBook* bookOpen (const char* path);
+void bookClose (OpeningBook* book);
+bool bookLookup (const OpeningBook* book, const Position* pos, int* move, int* score);
+int compareBookEntries (const void* a, const void* b);
+size_t mergeBookEntries (BookEntry* entries, size_t count);
+bool bookWrite (const char* path, const BookEntry* entries, size_t count, int minGames);
+
+#endif
@@ -0,0 +1,541 @@
+/**
+ * @file endgame.c
+ * @brief Exact solver for the last empty squares of a game
+ *
+ * Plays every line out to the end of the game and returns the exact final disc differential, using alpha-beta on the differential itself. Moves are ordered two ways:
+ *
+ *   fastest-first  with many empty squares left, the moves that leave the opponent the fewest replies are searched first; they tend to be the best moves and have the smallest subtrees
+ *   parity         with fewer empty squares, moves into quadrants with an odd number of empty squares go first, since the player who moves first into such a region usually gets its last move too
+ *
+ * The last 4 empty squares are played by dedicated code that walks a list of the empty squares instead of generating moves, and the very last square only counts the discs it would flip. On an 8 x 8
+ * board the whole solve runs on the bare words of the board, copied from move to move, so nothing is ever taken back, and the bounds found for positions with many empty squares are kept in a
+ * table, so a position reached again, by another move order or by a later solve, is not solved twice
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+
+#include "endgame.h"
+#include "util.h"
+
+//Empty squares at or below which the dedicated last-moves code takes over
+#define SMALL_EMPTIES 4
+//Empty squares above which moves are ordered fastest-first; parity orders them at or below
+#define FASTEST_FIRST_EMPTIES 7
+//Empty squares at or above which 8 x 8 results are kept in the solver's table; below, solving again is cheaper than the lookup
+#define TABLE_EMPTIES 8
+
+//Larger than any disc differential
+#define SOLVE_INFINITY (MAX_SQUARES+1)
+
+//The four quadrants of an 8 x 8 board
+static const uint64_t quadrant8[4] = {0x000000000f0f0f0fULL, 0x00000000f0f0f0f0ULL, 0x0f0f0f0f00000000ULL, 0xf0f0f0f000000000ULL};
+
+/**
+ * @brief Checks whether the solve has to stop, setting the stop flag itself once its deadline or node limit has passed or it has been cancelled
+ *
+ * The clock is only read every ENDGAME_POLL_NODES nodes
+ */
+static bool stopRequested (EndgameSolver* solver)  {
+	if (solver->nodes >= solver->nextPoll)  {
+		solver->nextPoll = solver->nodes + ENDGAME_POLL_NODES;
+		if ((solver->maxNodes > 0 && solver->nodes >= solver->maxNodes) || (solver->deadline > 0 && secondsNow() >= solver->deadline) ||
+			(solver->cancel != NULL && __atomic_load_n(solver->cancel, __ATOMIC_RELAXED)))  {
+			__atomic_store_n(solver->stop, true, __ATOMIC_RELAXED);
+		}
+	}
+	return __atomic_load_n(solver->stop, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Counts the empty squares of a position
+ */
+int countEmpties (const Position* pos)  {
+	return pos->dim*pos->dim - countSquares(&pos->disc[BLACK], pos->words) - countSquares(&pos->disc[WHITE], pos->words);
+}
+
+/**
+ * @brief Finds the squares of an 8 x 8 board that lie in quadrants with an odd number of empty squares
+ *
+ * @param empty The empty squares
+ */
+static inline uint64_t oddQuadrants8 (uint64_t empty)  {
+	uint64_t odd = 0;
+
+	for (int q = 0; q < 4; q++)  {
+		if (__builtin_popcountll(empty & quadrant8[q]) & 1)  {
+			odd |= quadrant8[q];
+		}
+	}
+	return odd;
+}
+
+/**
+ * @brief Solves an 8 x 8 position with one empty square
+ *
+ * @param solver The state of the solve
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ * @param square The empty square
+ *
+ * @return The final disc differential for the side to move
+ */
+static int solveLast1_8 (EndgameSolver* solver, uint64_t own, uint64_t opp, int square)  {
+	int difference = __builtin_popcountll(own) - __builtin_popcountll(opp), flipped;
+
+	solver->nodes++;
+	flipped = __builtin_popcountll(computeFlips8x8(own, opp, square));
+	if (flipped > 0)  {
+		return difference + 2*flipped + 1;
+	}
+	//The side to move passes, and the opponent takes the square if it can
+	flipped = __builtin_popcountll(computeFlips8x8(opp, own, square));
+	if (flipped > 0)  {
+		return difference - 2*flipped - 1;
+	}
+	return difference;
+}
+
+/**
+ * @brief Solves an 8 x 8 position with 2 to SMALL_EMPTIES empty squares
+ *
+ * Tries each listed square directly instead of generating moves, which is cheaper when so few squares are empty
+ *
+ * @param solver The state of the solve
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ * @param squares The empty squares, in the order they are tried
+ * @param count The number of empty squares
+ *
+ * @return The final disc differential for the side to move, or a bound on it outside the window
+ */
+static int solveSmall8 (EndgameSolver* solver, uint64_t own, uint64_t opp, int alpha, int beta, bool passed, const int* squares, int count)  {
+	int rest[SMALL_EMPTIES], best = -SOLVE_INFINITY, score;
+	uint64_t flips, placed;
+	bool moved = false;
+
+	solver->nodes++;
+	for (int i = 0; i < count; i++)  {
+		flips = computeFlips8x8(own, opp, squares[i]);
+		if (flips == 0)  {
+			continue;
+		}
+		moved = true;
+		placed = own | flips | ((uint64_t) 1 << squares[i]);
+		//The squares still empty after the move, in the same order
+		for (int j = 0, k = 0; j < count; j++)  {
+			if (j != i)  {
+				rest[k++] = squares[j];
+			}
+		}
+		if (count == 2)  {
+			score = -solveLast1_8(solver, opp & ~flips, placed, rest[0]);
+		}
+		else  {
+			score = -solveSmall8(solver, opp & ~flips, placed, -beta, -alpha, false, rest, count-1);
+		}
+		if (score > best)  {
+			best = score;
+			if (score > alpha)  {
+				alpha = score;
+				if (alpha >= beta)  {
+					break;
+				}
+			}
+		}
+	}
+
+	if (!moved)  {
+		if (passed)  {
+			return __builtin_popcountll(own) - __builtin_popcountll(opp);
+		}
+		return -solveSmall8(solver, opp, own, -beta, -alpha, true, squares, count);
+	}
+	return best;
+}
+
+/**
+ * @brief Finds the table entry an 8 x 8 position is kept in
+ */
+static inline EndgameEntry* tableEntry8 (const EndgameSolver* solver, uint64_t own, uint64_t opp)  {
+	uint64_t key = own*0x9e3779b97f4a7c15ULL ^ (opp + (opp >> 29))*0xbf58476d1ce4e5b9ULL;
+	return &solver->table[(key >> 32) & (ENDGAME_TABLE_ENTRIES-1)];
+}
+
+/**
+ * @brief Solves an 8 x 8 position
+ *
+ * @param solver The state of the solve
+ * @param own The discs of the side to move
+ * @param opp The discs of the opponent
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ * @param empties The number of empty squares
+ *
+ * @return The final disc differential for the side to move, or a bound on it outside the window
+ */
+static int solve8 (EndgameSolver* solver, uint64_t own, uint64_t opp, int alpha, int beta, bool passed, int empties)  {
+	//Variable declaration
+	uint64_t empty = ~(own | opp), odd = oddQuadrants8(empty), moves, flips[64], placed;
+	int order[64], keys[64], count = 0, best = -SOLVE_INFINITY, score, key, square, bestSquare = -1, alphaOriginal, tableMove = -1;
+	EndgameEntry* entry = NULL;
+
+	if (empties <= SMALL_EMPTIES)  {
+		if (empties == 0)  {
+			return __builtin_popcountll(own) - __builtin_popcountll(opp);
+		}
+		//Lists the empty squares with those in odd quadrants first
+		for (uint64_t left = empty & odd; left != 0; left &= left-1)  {
+			order[count++] = __builtin_ctzll(left);
+		}
+		for (uint64_t left = empty & ~odd; left != 0; left &= left-1)  {
+			order[count++] = __builtin_ctzll(left);
+		}
+		if (count == 1)  {
+			return solveLast1_8(solver, own, opp, order[0]);
+		}
+		return solveSmall8(solver, own, opp, alpha, beta, passed, order, count);
+	}
+
+	solver->nodes++;
+	if (stopRequested(solver))  {
+		solver->aborted = true;
+		return 0;
+	}
+	//Bounds from an earlier solve of the same position narrow the window, or settle the position outright
+	if (solver->table != NULL && empties >= TABLE_EMPTIES)  {
+		entry = tableEntry8(solver, own, opp);
+		if (entry->own == own && entry->opp == opp)  {
+			if (entry->lower >= beta || entry->lower == entry->upper)  {
+				return entry->lower;
+			}
+			if (entry->upper <= alpha)  {
+				return entry->upper;
+			}
+			alpha = entry->lower > alpha ? entry->lower : alpha;
+			beta = entry->upper < beta ? entry->upper : beta;
+			tableMove = entry->move;
+		}
+	}
+	alphaOriginal = alpha;
+	moves = generateMoves8x8(own, opp);
+	if (moves == 0)  {
+		if (passed)  {
+			return __builtin_popcountll(own) - __builtin_popcountll(opp);
+		}
+		return -solve8(solver, opp, own, -beta, -alpha, true, empties);
+	}
+
+	//Orders the moves: by the opponent's number of replies, with parity breaking ties, or by parity alone close to the end
+	for (uint64_t left = moves; left != 0; left &= left-1)  {
+		uint64_t f;
+		square = __builtin_ctzll(left);
+		f = computeFlips8x8(own, opp, square);
+		key = (odd >> square & 1) ? 0 : 1;
+		if (square == tableMove)  {
+			key = -1;
+		}
+		else if (empties > FASTEST_FIRST_EMPTIES)  {
+			key += 2*__builtin_popcountll(generateMoves8x8(opp & ~f, own | f | ((uint64_t) 1 << square)));
+		}
+		//Insertion sort; moves with equal keys keep their Northwest to Southeast order
+		int i = count++;
+		while (i > 0 && keys[i-1] > key)  {
+			order[i] = order[i-1];
+			keys[i] = keys[i-1];
+			flips[i] = flips[i-1];
+			i--;
+		}
+		order[i] = square;
+		keys[i] = key;
+		flips[i] = f;
+	}
+
+	for (int i = 0; i < count; i++)  {
+		placed = own | flips[i] | ((uint64_t) 1 << order[i]);
+		score = -solve8(solver, opp & ~flips[i], placed, -beta, -alpha, false, empties-1);
+		if (solver->aborted)  {
+			return 0;
+		}
+		if (score > best)  {
+			best = score;
+			bestSquare = order[i];
+			if (score > alpha)  {
+				alpha = score;
+				if (alpha >= beta)  {
+					break;
+				}
+			}
+		}
+	}
+
+	//A score outside the window is only a bound; one inside it is exact
+	if (entry != NULL)  {
+		if (entry->own != own || entry->opp != opp)  {
+			entry->own = own;
+			entry->opp = opp;
+			entry->lower = -64;
+			entry->upper = 64;
+		}
+		if (best > alphaOriginal)  {
+			entry->lower = (int8_t) best;
+		}
+		if (best < beta)  {
+			entry->upper = (int8_t) best;
+		}
+		entry->move = (int8_t) bestSquare;
+	}
+	return best;
+}
+
+/**
+ * @brief Finds which quadrant of the board a square lies in
+ *
+ * @param dim The size n of the n x n board
+ * @param square The square
+ *
+ * @return 0 to 3, for the Northwest, Northeast, Southwest and Southeast quadrants
+ */
+static inline int quadrantOf (int dim, int square)  {
+	return (square/dim >= dim/2 ? 2 : 0) + (square%dim >= dim/2 ? 1 : 0);
+}
+
+/**
+ * @brief Lists the empty squares of a position, with those in quadrants with an odd number of empty squares first
+ *
+ * @param pos The position
+ * @param squares Receives the empty squares
+ * @param oddQuadrants If not NULL, receives one bit for each quadrant with an odd number of empty squares
+ *
+ * @return The number of empty squares
+ */
+static int listEmpties (const Position* pos, int* squares, unsigned* oddQuadrants)  {
+	int count = 0, dim = pos->dim, squareCount = pos->dim*pos->dim, first = 0;
+	unsigned odd = 0;
+	uint64_t empty;
+
+	for (int i = 0; i < pos->words; i++)  {
+		empty = ~(pos->disc[BLACK].word[i] | pos->disc[WHITE].word[i]);
+		for (; empty != 0; empty &= empty-1)  {
+			int square = i*64 + __builtin_ctzll(empty);
+			if (square >= squareCount)  {
+				break;
+			}
+			squares[count++] = square;
+			odd ^= 1u << quadrantOf(dim, square);
+		}
+	}
+	//Moves the squares of odd quadrants to the front, keeping the order within each group
+	for (int i = 0; i < count; i++)  {
+		if (odd >> quadrantOf(dim, squares[i]) & 1)  {
+			int square = squares[i];
+			for (int j = i; j > first; j--)  {
+				squares[j] = squares[j-1];
+			}
+			squares[first++] = square;
+		}
+	}
+	if (oddQuadrants != NULL)  {
+		*oddQuadrants = odd;
+	}
+	return count;
+}
+
+/**
+ * @brief The disc differential of a position for the side to move
+ */
+static inline int discDifference (const Position* pos)  {
+	return countSquares(&pos->disc[pos->side], pos->words) - countSquares(&pos->disc[1-pos->side], pos->words);
+}
+
+/**
+ * @brief Solves a position of any size with one empty square
+ *
+ * @param solver The state of the solve
+ * @param square The empty square
+ *
+ * @return The final disc differential for the side to move
+ */
+static int solveLast1 (EndgameSolver* solver, int square)  {
+	Position* pos = solver->pos;
+	Bitboard flips;
+	int difference = discDifference(pos), flipped;
+
+	solver->nodes++;
+	flipped = computeFlips(pos, pos->side, square, &flips, NULL);
+	if (flipped > 0)  {
+		return difference + 2*flipped + 1;
+	}
+	flipped = computeFlips(pos, 1-pos->side, square, &flips, NULL);
+	if (flipped > 0)  {
+		return difference - 2*flipped - 1;
+	}
+	return difference;
+}
+
+/**
+ * @brief Solves a position of any size with 2 to SMALL_EMPTIES empty squares, trying each listed square directly
+ *
+ * @param solver The state of the solve; moves are made on its position and taken back
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ * @param squares The empty squares, in the order they are tried
+ * @param count The number of empty squares
+ *
+ * @return The final disc differential for the side to move, or a bound on it outside the window
+ */
+static int solveSmall (EndgameSolver* solver, int alpha, int beta, bool passed, const int* squares, int count)  {
+	Position* pos = solver->pos;
+	int rest[SMALL_EMPTIES], best = -SOLVE_INFINITY, score;
+	bool moved = false;
+
+	solver->nodes++;
+	for (int i = 0; i < count; i++)  {
+		//makeMove leaves the position untouched if the square flips nothing
+		if (makeMove(pos, squares[i], solver->undo) == 0)  {
+			continue;
+		}
+		moved = true;
+		for (int j = 0, k = 0; j < count; j++)  {
+			if (j != i)  {
+				rest[k++] = squares[j];
+			}
+		}
+		score = count == 2 ? -solveLast1(solver, rest[0]) : -solveSmall(solver, -beta, -alpha, false, rest, count-1);
+		unmakeMove(pos, solver->undo);
+		if (score > best)  {
+			best = score;
+			if (score > alpha)  {
+				alpha = score;
+				if (alpha >= beta)  {
+					break;
+				}
+			}
+		}
+	}
+
+	if (!moved)  {
+		if (passed)  {
+			return discDifference(pos);
+		}
+		makeMove(pos, PASS_MOVE, solver->undo);
+		score = -solveSmall(solver, -beta, -alpha, true, squares, count);
+		unmakeMove(pos, solver->undo);
+		return score;
+	}
+	return best;
+}
+
+/**
+ * @brief Solves a position of any size, making and taking back moves on the solver's position
+ *
+ * @param solver The state of the solve
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ * @param empties The number of empty squares
+ *
+ * @return The final disc differential for the side to move, or a bound on it outside the window
+ */
+static int solveGeneric (EndgameSolver* solver, int alpha, int beta, bool passed, int empties)  {
+	//Variable declaration
+	Position* pos = solver->pos;
+	Bitboard moveMask, replies;
+	int order[MAX_SQUARES], keys[MAX_SQUARES], count = 0, best = -SOLVE_INFINITY, score, key;
+	unsigned odd;
+
+	if (empties <= SMALL_EMPTIES)  {
+		count = listEmpties(pos, order, NULL);
+		if (count == 0)  {
+			return discDifference(pos);
+		}
+		if (count == 1)  {
+			return solveLast1(solver, order[0]);
+		}
+		return solveSmall(solver, alpha, beta, passed, order, count);
+	}
+
+	solver->nodes++;
+	if (stopRequested(solver))  {
+		solver->aborted = true;
+		return 0;
+	}
+	generateMoves(pos, pos->side, &moveMask);
+	if (!anySquare(&moveMask, pos->words))  {
+		if (passed)  {
+			return discDifference(pos);
+		}
+		makeMove(pos, PASS_MOVE, solver->undo);
+		score = -solveGeneric(solver, -beta, -alpha, true, empties);
+		unmakeMove(pos, solver->undo);
+		return score;
+	}
+
+	listEmpties(pos, order, &odd);
+	for (int square = popSquare(&moveMask, pos->words); square != -1; square = popSquare(&moveMask, pos->words))  {
+		key = (odd >> quadrantOf(pos->dim, square) & 1) ? 0 : 1;
+		if (empties > FASTEST_FIRST_EMPTIES)  {
+			makeMove(pos, square, solver->undo);
+			generateMoves(pos, pos->side, &replies);
+			key += 2*countSquares(&replies, pos->words);
+			unmakeMove(pos, solver->undo);
+		}
+		int i = count++;
+		while (i > 0 && keys[i-1] > key)  {
+			order[i] = order[i-1];
+			keys[i] = keys[i-1];
+			i--;
+		}
+		order[i] = square;
+		keys[i] = key;
+	}
+
+	for (int i = 0; i < count; i++)  {
+		makeMove(pos, order[i], solver->undo);
+		score = -solveGeneric(solver, -beta, -alpha, false, empties-1);
+		unmakeMove(pos, solver->undo);
+		if (solver->aborted)  {
+			return 0;
+		}
+		if (score > best)  {
+			best = score;
+			if (score > alpha)  {
+				alpha = score;
+				if (alpha >= beta)  {
+					break;
+				}
+			}
+		}
+	}
+	return best;
+}
+
+/**
+ * @brief Solves a position exactly, playing every line out to the end of the game
+ *
+ * Empty squares are not awarded to either side, the same as terminalScore
+ *
+ * @param solver The position, undo stack, stop flag and limits to solve with; the node count is added to
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ *
+ * @return The final disc differential for the side to move with best play by both sides, or a bound on it if it lies outside the window; meaningless if the solver was stopped
+ */
+int solveEndgame (EndgameSolver* solver, int alpha, int beta, bool passed)  {
+	Position* pos = solver->pos;
+	int empties = countEmpties(pos);
+
+	solver->aborted = false;
+	solver->nextPoll = solver->nodes + ENDGAME_POLL_NODES;
+	if (pos->dim == 8)  {
+		return solve8(solver, pos->disc[pos->side].word[0], pos->disc[1-pos->side].word[0], alpha, beta, passed, empties);
+	}
+	return solveGeneric(solver, alpha, beta, passed, empties);
+}
@@ -0,0 +1,55 @@
+/**
+ * @file endgame.h
+ * @brief Exact solver for the last empty squares of a game
+ */
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+
+//Number of empty squares at or below which the search switches to the exact solver, unless another number is given
+#define DEFAULT_ENDGAME_EMPTIES 14
+
+//Nodes the solver visits between checks of its clock and node limit
+#define ENDGAME_POLL_NODES 1024
+
+//Entries in each solver's table of 8 x 8 results; a power of two
+#define ENDGAME_TABLE_ENTRIES (1 << 16)
+
+/**
+ * @brief Bounds on the final disc differential of one 8 x 8 position, found by an earlier solve
+ *
+ * The position is stored whole, so a lookup never mistakes one position for another
+ */
+typedef struct  {
+	uint64_t own;		//The discs of the side to move
+	uint64_t opp;		//The discs of the opponent
+	int8_t lower;		//The differential is at least this
+	int8_t upper;		//The differential is at most this
+	int8_t move;		//The best move found, tried first next time; -1 if none
+} EndgameEntry;
+
+/**
+ * @brief The state of one exact solve
+ */
+typedef struct  {
+	Position* pos;		//The position being solved; every move made on it is taken back
+	UndoStack* undo;	//The stack the solver's moves are recorded on
+	EndgameEntry* table;	//ENDGAME_TABLE_ENTRIES results kept between solves, or NULL to keep none; bounds are exact, so the table never has to be cleared
+	bool* stop;			//Checked as the solve goes; once set, the solver unwinds and its result must not be used
+	bool aborted;		//Whether the solver has seen the stop flag
+	double deadline;	//Monotonic time, in seconds, at which the solver sets the stop flag itself; 0 for none
+	uint64_t maxNodes;	//Nodes after which the solver sets the stop flag itself; 0 for no limit
+	const bool* cancel;	//Makes the solver set the stop flag itself once another thread sets it; NULL for none
+	uint64_t nextPoll;	//Node count at which the deadline, node limit and cancel flag are next checked
+	uint64_t nodes;		//The number of positions visited
+} EndgameSolver;
+
+int countEmpties (const Position* pos);
+int solveEndgame (EndgameSolver* solver, int alpha, int beta, bool passed);
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * @file eval.c
+ * @brief Static evaluation of a reversi position for the search
+ *
+ * Scores a position as a sum of weights: one looked up in a table for the contents of each corner pattern (see pattern.h), whose indices every position keeps up to date as moves are made,
+ * plus weights for the difference in mobility, the difference in discs and the side to move. Each stage of the game has its own weights, since what a corner region or a spare move is worth
+ * changes as the board fills up. The weights are fitted to the results of self-play games by train.c; without a file of trained weights, they reproduce the hand-set evaluation of mobility,
+ * corners and the squares diagonally next to an empty corner (which hand that corner to the opponent)
+ *
+ * Boards too small for patterns are scored by the hand-set evaluation directly
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include "eval.h"
+#include "search.h"
+
+//Weights of the hand-set evaluation, in discs
+#define MOBILITY_WEIGHT 8
+#define CORNER_WEIGHT 40
+#define X_SQUARE_WEIGHT 20
+
+//Bounds on any evaluation, well inside the scores of finished games
+#define EVAL_LIMIT (SCORE_WIN/2)
+
+//First bytes of a file of weights, followed by the number of stages and the number of weights in each
+static const char weightsMagic[4] = {'R', 'V', 'E', 'W'};
+
+/**
+ * @brief Finds the stage of the game a position is in
+ *
+ * @param dim The size n of the n x n board
+ * @param discs The discs on the board, of both colours
+ *
+ * @return The stage, from 0 at the start of the game to EVAL_STAGES-1 at the end
+ */
+int evalStage (int dim, int discs)  {
+	int stage = (discs-4)*EVAL_STAGES / (dim*dim-3);
+	return stage < 0 ? 0 : stage >= EVAL_STAGES ? EVAL_STAGES-1 : stage;
+}
+
+/**
+ * @brief Fills in the weights of the hand-set evaluation, for use until trained weights are loaded
+ *
+ * Only the corner table is set: a corner is worth CORNER_WEIGHT discs to whoever holds it, and while it is empty, the square diagonally next to it costs its owner X_SQUARE_WEIGHT
+ *
+ * @param weights The weights that are overwritten
+ */
+void evalDefaultWeights (EvalWeights* weights)  {
+	memset(weights, 0, sizeof(EvalWeights));
+	for (int stage = 0; stage < EVAL_STAGES; stage++)  {
+		int16_t* corner = &weights->weight[stage][patternTypeOffset[PATTERN_CORNER]];
+		//The corner is the lowest digit of the 3 x 3 pattern, and the square diagonally next to it the fifth
+		for (int index = 0; index < 19683; index++)  {
+			int cornerDigit = index % 3, xDigit = (index / 81) % 3;
+			if (cornerDigit != 0)  {
+				corner[index] = (cornerDigit == 1 ? CORNER_WEIGHT : -CORNER_WEIGHT)*EVAL_SCALE;
+			}
+			else if (xDigit != 0)  {
+				corner[index] = (xDigit == 1 ? -X_SQUARE_WEIGHT : X_SQUARE_WEIGHT)*EVAL_SCALE;
+			}
+		}
+		weights->weight[stage][EVAL_MOBILITY] = MOBILITY_WEIGHT*EVAL_SCALE;
+		weights->weight[stage][EVAL_DISCS] = EVAL_SCALE;
+	}
+}
+
+/**
+ * @brief Reads weights written by evalSaveWeights
+ *
+ * @param weights Receives the weights; meaningless if the file cannot be read
+ * @param path The file
+ *
+ * @return Whether the file held weights for this many stages and patterns
+ */
+bool evalLoadWeights (EvalWeights* weights, const char* path)  {
+	FILE* file = fopen(path, "rb");
+	char magic[4];
+	uint32_t counts[2];
+	bool valid;
+
+	if (file == NULL)  {
+		return false;
+	}
+	valid = fread(magic, 1, 4, file) == 4 && memcmp(magic, weightsMagic, 4) == 0 && fread(counts, sizeof(uint32_t), 2, file) == 2 && counts[0] == EVAL_STAGES &&
+		counts[1] == EVAL_STAGE_WEIGHTS;
+	valid = valid && fread(weights, sizeof(EvalWeights), 1, file) == 1;
+	fclose(file);
+	return valid;
+}
+
+/**
+ * @brief Writes weights to a file, in the byte order of the machine
+ *
+ * @param path The file, which is overwritten
+ * @param weights The weights
+ *
+ * @return Whether the whole file was written
+ */
+bool evalSaveWeights (const char* path, const EvalWeights* weights)  {
+	FILE* file = fopen(path, "wb");
+	uint32_t counts[2] = {EVAL_STAGES, EVAL_STAGE_WEIGHTS};
+	bool written;
+
+	if (file == NULL)  {
+		return false;
+	}
+	written = fwrite(weightsMagic, 1, 4, file) == 4 && fwrite(counts, sizeof(uint32_t), 2, file) == 2 && fwrite(weights, sizeof(EvalWeights), 1, file) == 1;
+	return fclose(file) == 0 && written;
+}
+
+/**
+ * @brief Scores a board too small for patterns with the hand-set evaluation
+ *
+ * @param pos The position being evaluated
+ * @param legal The legal moves of both colours
+ *
+ * @return The score for the side to move
+ */
+static int evaluateSmallBoard (const Position* pos, const LegalMoves* legal)  {
+	int side = pos->side, dim = pos->dim, score;
+	int cornerRow[4] = {0, 0, dim-1, dim-1}, cornerCol[4] = {0, dim-1, 0, dim-1};
+	const Bitboard* own = &pos->disc[side];
+	const Bitboard* opp = &pos->disc[1-side];
+
+	score = MOBILITY_WEIGHT*(legal->count[side] - legal->count[1-side]);
+	//Discs in the corners can never be flipped; a disc next to an empty corner lets the opponent take it
+	for (int c = 0; c < 4 && dim >= 4; c++)  {
+		int corner = cornerRow[c]*dim + cornerCol[c];
+		int xSquare = (cornerRow[c] == 0 ? 1 : dim-2)*dim + (cornerCol[c] == 0 ? 1 : dim-2);
+		if (testSquare(own, corner))  {
+			score += CORNER_WEIGHT;
+		}
+		else if (testSquare(opp, corner))  {
+			score -= CORNER_WEIGHT;
+		}
+		else if (testSquare(own, xSquare))  {
+			score -= X_SQUARE_WEIGHT;
+		}
+		else if (testSquare(opp, xSquare))  {
+			score += X_SQUARE_WEIGHT;
+		}
+	}
+	return (score + countSquares(own, pos->words) - countSquares(opp, pos->words))*EVAL_SCALE;
+}
+
+/**
+ * @brief Evaluates a position without searching any further
+ *
+ * @param pos The position being evaluated
+ * @param weights The weights to score it with
+ *
+ * @return The score of the position for the side to move, in EVAL_SCALE units per disc; positive if the side to move is ahead
+ */
+int evaluatePosition (const Position* pos, const EvalWeights* weights)  {
+	//Variable declaration
+	int black, white, score;
+	const int16_t* weight;
+	LegalMoves legal;
+
+	//Mobility; a side with more moves to choose from is rarely forced into a bad one
+	generateLegalMoves(pos, &legal);
+	//A position where neither side can move is a finished game, and is scored as one however the search reached it
+	if (legal.count[BLACK] == 0 && legal.count[WHITE] == 0)  {
+		return terminalScore(pos);
+	}
+	if (pos->dim < PATTERN_MIN_DIM)  {
+		return evaluateSmallBoard(pos, &legal);
+	}
+
+	black = countSquares(&pos->disc[BLACK], pos->words);
+	white = countSquares(&pos->disc[WHITE], pos->words);
+	weight = weights->weight[evalStage(pos->dim, black+white)];
+	score = weight[EVAL_MOBILITY]*(legal.count[BLACK] - legal.count[WHITE]) + weight[EVAL_DISCS]*(black - white) + (pos->side == BLACK ? weight[EVAL_TEMPO] : -weight[EVAL_TEMPO]);
+	for (int i = 0; i < PATTERN_INSTANCES; i++)  {
+		score += weight[patternInstanceOffset[i] + pos->pattern[i]];
+	}
+
+	score = score > EVAL_LIMIT ? EVAL_LIMIT : score < -EVAL_LIMIT ? -EVAL_LIMIT : score;
+	return pos->side == BLACK ? score : -score;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file eval.h
+ * @brief Static evaluation of a reversi position for the search
+ */
+
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+#include "pattern.h"
+
+//Evaluation units in one disc
+#define EVAL_SCALE 8
+
+//Stages of the game, by the share of the board covered, each with its own weights
+#define EVAL_STAGES 6
+
+//Weights of one stage: the table of every pattern shape, followed by one weight for each of the features below
+#define EVAL_MOBILITY PATTERN_WEIGHTS		//Black's legal moves less white's
+#define EVAL_DISCS (PATTERN_WEIGHTS+1)		//Black's discs less white's
+#define EVAL_TEMPO (PATTERN_WEIGHTS+2)		//1 with black to move, -1 with white to move
+#define EVAL_STAGE_WEIGHTS (PATTERN_WEIGHTS+3)
+
+/**
+ * @brief Every weight of the evaluation, in EVAL_SCALE units per disc, scoring a position for black
+ */
+typedef struct  {
+	int16_t weight[EVAL_STAGES][EVAL_STAGE_WEIGHTS];
+} EvalWeights;
+
+int evalStage (int dim, int discs);
+void evalDefaultWeights (EvalWeights* weights);
+bool evalLoadWeights (EvalWeights* weights, const char* path);
+bool evalSaveWeights (const char* path, const EvalWeights* weights);
+int evaluatePosition (const Position* pos, const EvalWeights* weights);
+
+#endif
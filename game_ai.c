@@ -10,6 +10,25 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include "reversi.h"
+#include "selfplay.h"
+#include "analyse.h"
+#include "record.h"
+#include "protocol.h"
+#include "endgame.h"
+
+/**
+ * @brief How the AI searches, as set up from the command line when the program starts
+ */
+typedef struct  {
+	ReversiEngine* engine;		//The threads, working memory and transposition table shared by every search in the game
+	bool showStats;				//Whether to print the statistics of every search and of the table
+	bool ponder;				//Whether the AI searches its next move while the user decides theirs
+	SearchLimits limits;		//How far every search goes; with a clock, clockTime is what is left on the AI's clock and goes down as the game is played
+	FILE* statsFile;			//File every search is written to as one line of JSON; NULL for none
+	GameRecord* record;			//Every move played so far, passes included, to be added to a record file when the game ends; NULL if the game is not recorded
+} AISettings;
+
 /**
  * @brief Sets all values in a 2-D array to be identical to another
  *
@@ -60,88 +79,46 @@ void printBoard (char** toPrint, int size)  {
 /**
  * @brief Makes a move at any location on the n x n board
  * 
- * Used both for making changes to the board as the two players play their respective turns, and for storing any changes that the AI makes in it's own memory for deciding its best move
+ * Used both for making changes to the board as the two players play their respective turns, and for testing how many discs a move would flip. The flips are found with the bitboard move 
+ * generator, so a test move never has to write to the board or restore it afterwards
  *
  * @param changeBoard The board that is used for recording any changes made in this function call
- * @param originalBoard Stores a copy of the game board if the AI is making changes in its own memory; if both board parameters are identical, the changes passes through to the board without restoration
+ * @param originalBoard If identical to changeBoard, the move is made on the board; otherwise the move is only tested and neither board is changed
  * @param row The first index of the location of the change
  * @param col The second index of the location of the change
  * @param colour The colour of the player making/testing the move 
  * @param bounds The size n of the n x n board
+ * @param moveScore The caller's vector of 8 scores, which receives the change in score in each direction
  *
- * @return The change in score caused by the move that the function performed
+ * @return The vector passed in as moveScore, holding the change in score caused by the move that the function performed
  */
-int* moveAtLocation (char** changeBoard, char** originalBoard, int row, int col, char colour, int bounds)  {
+int* moveAtLocation (char** changeBoard, char** originalBoard, int row, int col, char colour, int bounds, int* moveScore)  {
 	//Variable declaration 
-	char colourCheck; 
-	bool valid = false, lineOfOpp = false;
-	int* moveScore = (int*) malloc(8*sizeof(int)); 
-	int directionIndex, dump; 
-	
-	for (int i = 0; i < 8; i++)  {
-		moveScore[i] = 0;
-	}
-
-	//Stores the colour opposite to the one that called the function i.e. stores black if colour is 'W', and white if 'B'
-	if (colour == 'B')  {
-		colourCheck = 'W';
-	}
-	else  {
-		colourCheck = 'B';
-	}
+	Position pos;
+	Bitboard flips;
 
+	//Reads the board into bitboards and finds the discs flipped in each of the 8 directions, in the same Northwest to Southeast order as always
+	positionFromBoard(&pos, changeBoard, bounds, colour);
 	//Checks if the location is unoccupied; a move cannot be made on a location already occupied by either colour 
 	if (changeBoard[row][col] == 'U')  {
-		/* Two levels of for loops, each iterating from [-1,1] ignoring the condition where both values are at 0 (to avoid infinite looping). Each value increments, decrements, or doesn't change
-  		 * either vertically or horizontally; e.g. -1,-1 goes Northwest along the board; 0,1 goes East along the board
+		computeFlips(&pos, pos.side, row*bounds+col, &flips, moveScore);
+		/* Only writes the move onto the board when both arguments are the same board, i.e. when the move is an actual change to the game master board; a test move leaves the board untouched, so 
+		 * there is nothing to reset afterwards
 		 */
-		for (int vertical = -1; vertical <= 1; vertical++)  {
-			for (int horizontal = -1; horizontal <= 1; horizontal++)  {
-				directionIndex = ((horizontal-vertical)+3*(vertical+1)+(vertical == 0||vertical == 1))*(!(vertical == 0 && horizontal == 0))-(horizontal == 1 && vertical == 0);
-				//Counts from the location, using the direction vectors from above to traverse the board in one of 8 directions; loop does not iterate if the direction vectors are 0,0
-				for (int i = row+vertical, j = col+horizontal, count = 0; i >= 0 && j >= 0 && i < bounds && j < bounds 
-					&& !(horizontal == 0 && vertical == 0); i += vertical, j += horizontal, count++)  {
-					//If an opposite colour position is detected, it sets this boolean to true
-					if (changeBoard[i][j] == colourCheck)  {
-						lineOfOpp = true;
-					}
-					//If it detects an adjacent equivalent colour or an unoccupied space, it falsifies all conditions and stops checking
-					else if ((changeBoard[i][j] == colour && count == 0) || (changeBoard[i][j] == 'U'))  {
-						lineOfOpp = false;
-						valid = false;
-						break;
-					}
-					//If it has already seen an opposite colour line, and then detects an equivalent colour, it decides that the direction is valid and stops checking further
-					else  {
-						valid = true;
-						break;
-					}
-				}
-				//Makes the appropriate changes to the board, only if it is decided that the move is valid in the current direction
-				if (valid)  {
-					//Changes location of actual move to the input colour
-					changeBoard[row][col] = colour;
-					//Changes all colours in the current direction to match the input colour
-					for (int i = row+vertical, j = col+horizontal; changeBoard[i][j] != colour; i += vertical, j += horizontal)  {
-						changeBoard[i][j] = colour; 
-						//Increments the score for every colour change made
-						moveScore[directionIndex]++;		
-					}
-					//Sets validity of direction to false before iterating over the next direction vector 
-					valid = false;
-				}
+		if (changeBoard == originalBoard && anySquare(&flips, pos.words))  {
+			changeBoard[row][col] = colour;
+			for (int square = popSquare(&flips, pos.words); square != -1; square = popSquare(&flips, pos.words))  {
+				changeBoard[square/bounds][square%bounds] = colour;
 			}
 		}
 	}
 	//If the move is detected to be in an unoccupied position, it sets the change in score to -1; this value is used outside of this function to determine if a user input an invalid move
 	else  {
+		for (int i = 0; i < 8; i++)  {
+			moveScore[i] = 0;
+		}
 		moveScore[0] = -1;
 	}
-	
-	/* Resets the original configuration of the board, to allow the AI to continue checking for moves; if the move is an actual change in the game master board, this function is called such that
- 	 * both arguments passed to copyBoard are identical, ensuring that no reset is performed on a valid, input move
-         */
-	copyBoard(originalBoard, changeBoard, bounds);
 	//Returns change in score caused by the move at location
 	return moveScore;
 }
@@ -167,66 +144,36 @@ int scoreFromMove (int* movesVector)  {
 	return resultant;
 }
 
+/**
+ * @brief Checks if either side of a position has a legal move
+ *
+ * @param pos The position being checked
+ *
+ * @return Returns if a single legal move is available for either side or not
+ */
+bool positionHasMoves (const Position* pos)  {
+	LegalMoves legal;
+	generateLegalMoves(pos, &legal);
+	return legal.count[BLACK] > 0 || legal.count[WHITE] > 0;
+}
+
 /**
  * @brief Checks if both the players have any moves available to make 
  * 
- * Iterates through every location on the board and makes a test move, returning true if even one move is available
+ * Generates the legal moves of both colours in a single pass over the bitboards, returning true if even one move is available
  * 
  * @param gameBoard The board on which the game is played
- * @param testBoard The board used to test the various possible moves
+ * @param testBoard Not used; kept so existing callers do not change
  * @param size The size n of the n x n board
  *
  * @return Returns if a single legal move is available for either side or not
  */
 bool movesAvailable (char** gameBoard, char** testBoard, int size)  {
-	for (int i = 0; i < size; i++)  {
-		for (int j = 0; j < size; j++)  {
-			if (scoreFromMove(moveAtLocation(testBoard, gameBoard, i, j, 'W', size)) > 0 || scoreFromMove(moveAtLocation(testBoard, gameBoard, i, j, 'B', size)) > 0)  {
-				return true;
-			}
-		}
-	}
-	return false;
-}
+	Position pos;
 
-/**
- * @brief Determines the optimal move for the AI to make; 
- * 
- * The AI checks all positions from Northwest to Southeast, and records the Northwesternmost, highest scoring position that is valid as per the game rules
- *
- * @param testBoard Pointer to the board that the AI is testing its moves on
- * @param originalBoard Pointer to the game master board so the AI can reset the board as required; never used to make a change to the original board in this function
- * @param dimensions The size n of the n x n board
- * @param colour The colour of the player that is checking for its best move is passed here
- *
- * @return The location that recorded the highest possible score the player could make in this move
- */
-char* highestScoringMove (char** testBoard, char** originalBoard, int dimensions, char colour)  {
-	//Variable declaration
-	int highestScore = 0, temp = 0;
-	char* locations = (char*) malloc(2*sizeof(char));
-	int* movesVector;
-
-	//Iterates through every tile on the board that is being tested
-	for (int i = 0; i < dimensions; i++)  {
-		for (int j = 0; j < dimensions; j++)  {
-			//Calls function to test in all 8 directions at the specific point, and temporarily stores the sum of the scores in the stack
-			temp = scoreFromMove(moveAtLocation(testBoard, originalBoard, i, j, colour, dimensions));
-			//If the temporary variable is higher than the current highest score, it stores both the score and the position (as two characters like "aa" or "cd") of that move
-			if (temp > highestScore)  {
-				highestScore = temp;
-				//The addition of 'a' translates the numerical value within the matrices (i.e. 0-n, n <= 25) to character labels ('a'-'z')
-				locations[0] = i+'a';
-				locations[1] = j+'a';
-			}
-		}
-	}
-	//If highest score is returned to be 0, the player has no valid moves; returns '0' as the position to the stack that called this function
-	if (highestScore == 0)  {
-		locations[0] = '0';
-		locations[1] = '0';
-	}
-	return locations;
+	(void) testBoard;
+	positionFromBoard(&pos, gameBoard, size, 'B');
+	return positionHasMoves(&pos);
 }
 
 /**
@@ -268,123 +215,117 @@ char** setBoard (int dim)  {
 }
 
 /**
- * @brief Runs a recursive sequence to calculate the best possible move for the AI to play
- *
- * The function looks at the current location (the location is set by another function that calls this one) and it predicts the opponent's possible responses and assigns a weight to playing a move in the current location. For the 
- * sake of simplicity, the algorithm assumes that the opponent will always make their highest scoring move, calling a naive checker to predict future moves. It calculates and assigns weight by taking a dot product of the number of 
- * directions that are flipped by the move with the score in each of those directions, multiplied by a weight that prioritizes having more directions instead of higher points. Each move is also multiplied by a weight that lightens
- * the effect of predictions that are far in the future
+ * @brief Prints what a search did, including how fast each of its threads searched
  *
- * @param testBoard The AI's memory of a board on which it tests various possible moves
- * @param originalBoard The board on which the game is actually played; used both to make appropriate changes and to reset the memory board when necessary
- * @param dimensions The size n of the n x n board
- * @param colour The AI player's colour; necessary because validity is unique to the colour and locations occupied on the board
- * @param accuracyFactor The number of moves into the future that the algorithm predicts and counters moves for; also used to calculate weight of each prediction in the formula
- * @param distanceFromPresent Used to check if the algorithm has reached the number of moves it needs to or not
- *
- * @return Returns weighted score of the move
+ * @param result The result of the search
  */
-double predictionSequence (char** testBoard, char** originalBoard, int dimensions, char colour, int accuracyFactor, int distanceFromPresent)  {
-	//Variable declaration 
-	char passColour;
-	char* locations = (char*) malloc(2*sizeof(char));
-	char** newTestBoard = setBoard(dimensions);
-	int* movesVector = (int*) malloc(8*sizeof(int)); 
-	//Initializes a 0 vector for the moves; necessary to avoid memory leakage if no valid moves are available
-	for (int i = 0; i < 8; i++)  {
-		movesVector[i] = 0;
+void printSearchStats (const SearchResult* result)  {
+	double seconds = result->seconds > 0 ? result->seconds : 1e-9;
+
+	if (result->bookMove)  {
+		fprintf(stderr, "book move score %d\n", result->score);
+		return;
 	}
-	int directionWeight = 0;
-	double weightedMoveScores = 0.0, predictionAccuracy = 1.0-(distanceFromPresent*1.0/accuracyFactor); 
-	
-	//Every other prediction is for the opponent's move, causing the vaue to be subtracted from the weighted predictions
-	if (accuracyFactor%2 == 1)  {
-		predictionAccuracy *= -1;
+	if (result->solvedMove)  {
+		fprintf(stderr, "solved move score %d\n", result->score);
+		return;
 	}
-	
-	//The colour that's passed to the next iteration, allowing it to predict the opponent's move; always opposite of current colour
-	if (colour == 'B')  {
-		passColour = 'W';
+	if (result->ponderHit)  {
+		fprintf(stderr, "ponder hit, %.3fs after the reply\n", result->seconds);
 	}
-	else  {
-		passColour = 'B';
+	fprintf(stderr, "depth %d score %d nodes %llu time %.3fs nps %.0f threads %d\n", result->depth, result->score, (unsigned long long) result->nodes, result->seconds,
+		result->nodes/seconds, result->threads);
+	for (int i = 0; i < result->threads; i++)  {
+		fprintf(stderr, "  thread %d: nodes %llu nps %.0f\n", i, (unsigned long long) result->threadNodes[i], result->threadNodes[i]/seconds);
 	}
-	
-	//Base case; if it detects it's predicted as far into the future as available, or if both players have 0 valid moves, it returns 0 and stops predicting into the future
-	if (distanceFromPresent == accuracyFactor || !movesAvailable(originalBoard, testBoard, dimensions))  {
-		return 0;
-		
+	fprintf(stderr, "  arena %zu bytes per thread, heap allocations during search %llu\n", result->arenaBytes, (unsigned long long) result->heapAllocations);
+#ifdef ENGINE_STATS
+	fprintf(stderr, "  move generations %llu, evaluations %llu, table cutoffs %llu, beta cutoffs %llu (%.1f%% by the first move), endgame solves %llu (%llu nodes)\n",
+		(unsigned long long) result->stats.moveGenerations, (unsigned long long) result->stats.evaluations, (unsigned long long) result->stats.ttCutoffs,
+		(unsigned long long) result->stats.betaCutoffs, result->stats.betaCutoffs ? 100.0*result->stats.firstMoveCutoffs/result->stats.betaCutoffs : 0.0,
+		(unsigned long long) result->stats.endgameSolves, (unsigned long long) result->stats.endgameNodes);
+	for (int depth = 1; depth <= result->stats.iterations; depth++)  {
+		fprintf(stderr, "  iteration %d: nodes %llu time %.3fs\n", depth, (unsigned long long) result->stats.iterationNodes[depth], result->stats.iterationSeconds[depth]);
 	}
-	//If the base case hasn't been reached
-	else  {
-		//Stores the highest scoring move for the current board state 
-		locations = highestScoringMove(testBoard, originalBoard, dimensions, colour);
-		//Ensures the move is valid
-		if (locations[0] != '0')  {
-			//Frees the 0 vector from memory, and assigns the vector containing possible scores from the move only if the move is valid to begin with 
-			free(movesVector);
-			//Contains a vector with point change in all directions stored
-			movesVector = moveAtLocation(testBoard, testBoard, locations[0]-'a', locations[1]-'a', colour, dimensions);
-		}
-		//Creates a new state of the test board to pass it to the next call of the function
-		copyBoard(testBoard, newTestBoard, dimensions);
-		//Frees up heap memory storing the locations
-		free(locations);
-		//Creates a denominator to weigh the moves in each direction with
-		for (int i = 0; i < 8; i++)  {
-			if (movesVector[i] > 0)  {
-				directionWeight++;
-			}
-		}
-		directionWeight = 8 - directionWeight;
-		
-		//Multiplies the vector containing score with the scalar weights, and adds it to the weighted score
-		for (int i = 0; i < 8; i++)  {
-			weightedMoveScores += (1.0/directionWeight)*movesVector[i];
-		}
-		//Function calls itself for one move into the future
-		return (weightedMoveScores + predictionSequence (newTestBoard, testBoard, dimensions, passColour, accuracyFactor, distanceFromPresent + 1));
+#endif
+}
+
+/**
+ * @brief Prints how often the engine's moves came from its strong-solve database and its opening book, for each it has
+ *
+ * @param engine The engine
+ */
+void printBookStats (const ReversiEngine* engine)  {
+	BookStats stats;
+	SolvedStats solved;
+
+	reversiSolvedStats(engine, &solved);
+	if (solved.probes > 0)  {
+		fprintf(stderr, "solved probes %llu hits %llu (%.1f%%)\n", (unsigned long long) solved.probes, (unsigned long long) solved.hits, 100.0*solved.hits/solved.probes);
+	}
+	reversiBookStats(engine, &stats);
+	if (stats.probes > 0)  {
+		fprintf(stderr, "book probes %llu hits %llu (%.1f%%)\n", (unsigned long long) stats.probes, (unsigned long long) stats.hits, 100.0*stats.hits/stats.probes);
 	}
 }
 
+/**
+ * @brief Prints how often the AI pondered on the user's actual reply, if it pondered at all
+ *
+ * @param engine The engine
+ */
+void printPonderStats (const ReversiEngine* engine)  {
+	PonderStats stats;
+
+	reversiPonderStats(engine, &stats);
+	if (stats.ponders > 0)  {
+		fprintf(stderr, "ponders %llu hits %llu (%.1f%%)\n", (unsigned long long) stats.ponders, (unsigned long long) stats.hits, 100.0*stats.hits/stats.ponders);
+	}
+}
 
 /**
  * @brief Calculates the best possible move for the AI to make
  * 
- * Calls the prediction sequence for each location on the board, and scores both validity of moves and the weights, deciding what move is the best possible
+ * Runs an alpha-beta search with iterative deepening from the current board, looking ahead at the replies of both players, and returns the move at the head of the best line found
  *
- * @param testBoard The AI's memory of the board on which it tests moves 
+ * @param testBoard Not used; kept so existing callers do not change
  * @param originalBoard The board on which the game is played
  * @param dimensions Size n of the n x n board
  * @param colour The computer player's colour
+ * @param settings The engine to search with and the limits of the search; the AI's clock, if it has one, is updated
+ * @param locations The caller's two characters, which receive the location
+ *
+ * @return The locations passed in, holding the location of the best move, or '0' as the position if the player has no valid moves
  */
-char* bestMove (char** testBoard, char** originalBoard, int dimensions, char colour)  {
+char* bestMove (char** testBoard, char** originalBoard, int dimensions, char colour, AISettings* settings, char* locations)  {
 	//Variable declaration
-	int* movesVector;
-	double highestProbMove = 0.0, temp = 0.0;
-	char* locations = (char*) malloc(2*sizeof(char));
+	Position pos;
+	SearchResult result;
+	int move;
 	
-	//Iterates through every element on the board
-	for (int i = 0; i < dimensions; i++)  {
-		for (int j = 0; j < dimensions; j++)  {
-			//Initializes values as required for the check
-			temp = 0.0;
-			movesVector = moveAtLocation(testBoard, originalBoard, i, j, colour, dimensions);
-			//If the move is valid, it sets the temporary value to the weighted score obtained from the prediction sequence
-			if (scoreFromMove(movesVector) && movesVector[0] != -1)  {
-				temp = predictionSequence(testBoard, originalBoard, dimensions, colour, 15, 0);
-			}
-			//Compares the temporary value to the highest recorded values and stores it
-			if (temp > highestProbMove || (temp < 0 && highestProbMove == 0))  {
-				highestProbMove = temp;
-				locations[0] = i+'a';
-				locations[1] = j+'a';
-			}
-		}
+	(void) testBoard;
+	positionFromBoard(&pos, originalBoard, dimensions, colour);
+	//A forced pass needs no search, so it takes nothing off the AI's clock
+	move = reversiLegalMoves(&pos, NULL) == 0 ? PASS_MOVE : reversiSearch(settings->engine, &pos, &settings->limits, &result);
+	if (settings->showStats && move != PASS_MOVE)  {
+		printSearchStats(&result);
+	}
+	if (settings->statsFile != NULL && move != PASS_MOVE)  {
+		searchWriteJson(settings->statsFile, &result, dimensions);
+	}
+	//The time the search took comes off the AI's clock, and the increment goes back on
+	if (settings->limits.clockTime > 0 && move != PASS_MOVE)  {
+		settings->limits.clockTime += settings->limits.increment - result.seconds;
+		settings->limits.clockTime = settings->limits.clockTime > MIN_CLOCK_TIME ? settings->limits.clockTime : MIN_CLOCK_TIME;
 	}
 	
-	//Returns an invalid move if the highest weighted score remains 0.0
-	if (highestProbMove == 0.0)  {
+	//The addition of 'a' translates the square back into the row and column labels
+	if (move != PASS_MOVE)  {
+		locations[0] = move/dimensions+'a';
+		locations[1] = move%dimensions+'a';
+	}
+	//Returns an invalid move if there is no legal move to play
+	else  {
 		locations[0] = '0';
 		locations[1] = '0';
 	}
@@ -399,11 +340,25 @@ char* bestMove (char** testBoard, char** originalBoard, int dimensions, char col
  * @param sizePtr Pointer to the variable storing the size n of the n x n array
  * @param compPtr Pointer to the variable storing the colour of the computer player's tokens
  * @param playerPtr Pointer to the variable storing the colour of the user's tokens
+ *
+ * @return Whether a board size was given; false if the input ended before one was
  */
-void setGame (int* sizePtr, char* compPtr, char* playerPtr)  {
-	//Takes the size of the nxn board as an input 
+bool setGame (int* sizePtr, char* compPtr, char* playerPtr)  {
+	//Variable declaration
+	int read;
+
+	//Takes the size of the nxn board as an input, asking again until it is an even size the engine plays
 	printf("Enter the board dimension: ");
-	scanf("%d", sizePtr);
+	while ((read = scanf("%d", sizePtr)) != 1 || *sizePtr < REVERSI_MIN_DIM || *sizePtr > MAX_DIM || *sizePtr%2 != 0)  {
+		if (read == EOF)  {
+			return false;
+		}
+		//Skips whatever was typed instead of a number
+		if (read == 0 && scanf("%*s") == EOF)  {
+			return false;
+		}
+		printf("The board dimension must be even, from %d to %d: ", REVERSI_MIN_DIM, MAX_DIM);
+	}
 	
 	//Takes in computer player's colour as an input
 	printf("Computer plays (B/W) : ");
@@ -411,6 +366,7 @@ void setGame (int* sizePtr, char* compPtr, char* playerPtr)  {
 	
 	//Sets the player's colour to be opposite of the computer's 
 	*playerPtr = *compPtr == 'B' ? 'W' : 'B';
+	return true;
 }
 
 
@@ -428,24 +384,27 @@ void setGame (int* sizePtr, char* compPtr, char* playerPtr)  {
  * @param colourAI The colour of the AI as determined before this function is called
  * @param compScore Pointer to the computer's score in memory
  * @param plrScore Pointer to the player's score in memory
+ * @param settings How the AI searches
  *
  * @returns Whether or not a change was made in the current function call
  */
-bool playMove (char** gameBoard, char** compBoard, int size, char currentTurnColour, char colourAI, int* compScore, int* plrScore)  {
+bool playMove (char** gameBoard, char** compBoard, int size, char currentTurnColour, char colourAI, int* compScore, int* plrScore, AISettings* settings)  {
 	//Variable declaration
 	int changeInScore;
-	int *movesVector;
-	char* playerMove = malloc(2*sizeof(char));
-	bool changeMade = false;	
+	int movesVector[8];
+	char playerMove[2];
+	bool changeMade = false;
+	Position pos;
+	LegalMoves legal;	
 	
 	//If the AI is current playing, it calls the AI's prediction algorithm
 	if (currentTurnColour == colourAI)  {
 		//Stores the optimal move returned by helper function 
-		playerMove = bestMove(compBoard, gameBoard, size, colourAI);
+		bestMove(compBoard, gameBoard, size, colourAI, settings, playerMove);
 		//If the optimal move is within the range of the matrix, it performs an actual change
 		if (playerMove[0] >= 'a' && playerMove[0] <= 'z' && playerMove[1] >= 'a' && playerMove[1] <= 'z')  {	
 			//Performs change on board and stores the score
-			changeInScore = scoreFromMove(moveAtLocation(gameBoard, gameBoard, playerMove[0]-'a', playerMove[1]-'a', colourAI, size));
+			changeInScore = scoreFromMove(moveAtLocation(gameBoard, gameBoard, playerMove[0]-'a', playerMove[1]-'a', colourAI, size, movesVector));
 			//Adds change to the computer player's score; subtracts from user, and restores 1 point because the computer got that from occupying a 'U' position
 			*compScore += changeInScore;
 			*plrScore -= (changeInScore - 1);
@@ -454,19 +413,22 @@ bool playMove (char** gameBoard, char** compBoard, int size, char currentTurnCol
 			changeMade = true; 
 		}
 	}
-	//If the user is playing, it checks if the user has any valid moves, by using the AI's algorithm, without indicating to the user what the optimal move is 
+	//If the user is playing, it checks if the user has any valid moves from the legal move masks, without searching and without indicating to the user what the optimal move is 
 	else  {
-		//Stores optimal move for user
-		playerMove = bestMove(compBoard, gameBoard, size, currentTurnColour);
-		//If an optimal move exists, it allows the user to override its value with their own decided move
-		if (playerMove[0] >= 'a' && playerMove[0] <= 'z' && playerMove[1] >= 'a' && playerMove[1] <= 'z')  {
+		positionFromBoard(&pos, gameBoard, size, currentTurnColour);
+		generateLegalMoves(&pos, &legal);
+		//If a valid move exists, it allows the user to input their own decided move; with pondering, the AI searches its reply to the move it expects while waiting
+		if (legal.count[pos.side] > 0)  {
+			if (settings->ponder)  {
+				reversiPonder(settings->engine, &pos, &settings->limits);
+			}
 			//Stores user's input move
 			printf("Enter move for colour %c (RowCol): ", currentTurnColour);
 			for (int i = 0; i < 2; i++)  {
 				scanf(" %c", &playerMove[i]);
 			}
 			//Performs the input move and stores the change in score
-			movesVector = moveAtLocation(gameBoard, gameBoard, playerMove[0]-'a', playerMove[1]-'a', currentTurnColour, size);
+			moveAtLocation(gameBoard, gameBoard, playerMove[0]-'a', playerMove[1]-'a', currentTurnColour, size, movesVector);
 			changeInScore = scoreFromMove(movesVector);
 			//Modifies the user's and computer's score as dictated by the above change in score
 			if (changeInScore != 0 && movesVector[0] != -1)  {
@@ -480,6 +442,10 @@ bool playMove (char** gameBoard, char** compBoard, int size, char currentTurnCol
 			changeMade = true;
 		}
 	}
+	//Keeps the move for the game record; a turn without a change is a pass
+	if (settings->record != NULL && settings->record->moveCount < MAX_UNDO_MOVES)  {
+		settings->record->moves[settings->record->moveCount++] = changeMade ? (playerMove[0]-'a')*size + playerMove[1]-'a' : PASS_MOVE;
+	}
 	return changeMade; 
 }
 
@@ -497,8 +463,9 @@ bool playMove (char** gameBoard, char** compBoard, int size, char currentTurnCol
  * @param compColour The colour of the CPU player's tokens 
  * @param compScore Pointer to the computer player's score 
  * @param plrScore Pointer to the user's score
+ * @param settings How the AI searches
  */
-void playGame (char** gameMasterBoard, char** internalBoard, int dim, char plrColour, char compColour, int* compScore, int* plrScore)  {
+void playGame (char** gameMasterBoard, char** internalBoard, int dim, char plrColour, char compColour, int* compScore, int* plrScore, AISettings* settings)  {
 	//Variable declaration
 	int countOfNoChange = 0; 
 	int numOfTurns = 0; 
@@ -511,7 +478,7 @@ void playGame (char** gameMasterBoard, char** internalBoard, int dim, char plrCo
 		//All even numbered turns, numbered upwards from 0 are black token moves
 		if (numOfTurns%2 == 0)  {
 			//Counts how many moves went without a valid change from black player
-			boardChangedThisTurn = playMove(gameMasterBoard, internalBoard, dim, 'B', compColour, compScore, plrScore);
+			boardChangedThisTurn = playMove(gameMasterBoard, internalBoard, dim, 'B', compColour, compScore, plrScore, settings);
 			if (boardChangedThisTurn)  {
 				countOfNoChange = 0;
 				previousChangedColour = 'W';
@@ -523,7 +490,7 @@ void playGame (char** gameMasterBoard, char** internalBoard, int dim, char plrCo
 		//All odd numbered turns labelled upwards from 1 are white token moves
 		else  {
 			//Counts how many moves went without a valid change from white player
-			boardChangedThisTurn = playMove(gameMasterBoard, internalBoard, dim, 'W', compColour, compScore, plrScore);
+			boardChangedThisTurn = playMove(gameMasterBoard, internalBoard, dim, 'W', compColour, compScore, plrScore, settings);
 			if (boardChangedThisTurn)  {
 				countOfNoChange = 0;
 				previousChangedColour = 'B';
@@ -559,19 +526,274 @@ void playGame (char** gameMasterBoard, char** internalBoard, int dim, char plrCo
 	}
 }
 
+/**
+ * @brief Prints how well the transposition table served the game's searches
+ *
+ * Reports the hit rate of lookups, how often a hit turned out to belong to a different position, how often a store pushed out another position's entry from the same search, and how full the
+ * table is; a high collision rate or a nearly full table means the table is too small for the game being played
+ *
+ * @param table The transposition table
+ */
+void printTableStats (const TranspositionTable* table)  {
+	const TTStats* stats = &table->stats;
+
+	fprintf(stderr, "Transposition table: %zu MB, %llu entries\n", ttBytes(table)/(1024*1024), (unsigned long long) (ttBytes(table)/sizeof(TTEntry)));
+	fprintf(stderr, "  probes %llu, hits %llu (%.1f%%), false hits %llu (%.4f%% of hits)\n", (unsigned long long) stats->probes, (unsigned long long) stats->hits,
+		stats->probes ? 100.0*stats->hits/stats->probes : 0.0, (unsigned long long) stats->falseHits, stats->hits ? 100.0*stats->falseHits/stats->hits : 0.0);
+	fprintf(stderr, "  stores %llu, collisions %llu (%.1f%% of stores), %.1f%% full\n", (unsigned long long) stats->stores, (unsigned long long) stats->collisions,
+		stats->stores ? 100.0*stats->collisions/stats->stores : 0.0, ttUsage(table)/10.0);
+}
+
+/**
+ * @brief Adds a finished game to a binary record file
+ *
+ * The two turns without a move that end the game are not passes, so they are left out; a game the user lost with an invalid move is not finished, and is not added
+ *
+ * @param path The record file
+ * @param game The moves of the game
+ * @param board The final board
+ * @param dim The size n of the n x n board
+ * @param plrScore The user's score, -1 after an invalid move
+ */
+void saveGameRecord (const char* path, GameRecord* game, char** board, int dim, int plrScore)  {
+	Position pos;
+	FILE* file;
+
+	while (game->moveCount > 0 && game->moves[game->moveCount-1] == PASS_MOVE)  {
+		game->moveCount--;
+	}
+	if (plrScore == -1)  {
+		return;
+	}
+	positionFromBoard(&pos, board, dim, 'B');
+	game->dim = dim;
+	game->seed = 0;
+	game->discs[BLACK] = reversiDiscs(&pos, BLACK);
+	game->discs[WHITE] = reversiDiscs(&pos, WHITE);
+	file = recordAppend(path);
+	if (file == NULL || !recordWrite(file, game))  {
+		fprintf(stderr, "Could not add the game to %s\n", path);
+	}
+	if (file != NULL)  {
+		fclose(file);
+	}
+}
+
+/**
+ * @brief Reads a comma separated list of board sizes, such as 8,10,16
+ *
+ * @param list The list as given on the command line
+ * @param options Receives the sizes
+ */
+void readSizes (const char* list, SelfPlayOptions* options)  {
+	options->sizeCount = 0;
+	while (*list != '\0' && options->sizeCount < MAX_SELFPLAY_SIZES)  {
+		options->sizes[options->sizeCount++] = atoi(list);
+		while (*list != '\0' && *list != ',')  {
+			list++;
+		}
+		if (*list == ',')  {
+			list++;
+		}
+	}
+}
+
+/**
+ * @brief Plays engine-against-engine games without any terminal input, and reports how fast they were played
+ *
+ * @param engine The engine that plays both sides
+ * @param options The games to play
+ *
+ * @return The program's exit status
+ */
+int runSelfPlay (ReversiEngine* engine, const SelfPlayOptions* options)  {
+	SelfPlaySummary summary;
+
+	if (!selfPlay(engine, options, &summary))  {
+		fprintf(stderr, "Could not play the games; check the board sizes and the output file\n");
+		return 1;
+	}
+	printf("games %d moves %llu nodes %llu time %.3fs games/sec %.2f\n", summary.games, (unsigned long long) summary.moves, (unsigned long long) summary.nodes, summary.seconds,
+		summary.seconds > 0 ? summary.games/summary.seconds : 0.0);
+	printf("black wins %d white wins %d draws %d longest move %.3fs\n", summary.wins[BLACK], summary.wins[WHITE], summary.draws, summary.longestMove);
+	return 0;
+}
+
+/**
+ * @brief Searches every position of a file on a pool of engines, and reports how fast they were searched
+ *
+ * @param options The positions to search, and how
+ *
+ * @return The program's exit status
+ */
+int runAnalysis (const AnalysisOptions* options)  {
+	AnalysisSummary summary;
+	bool analysed = analysePositions(options, &summary);
+
+	//The results may be going to standard output, so the summary goes to standard error
+	fprintf(stderr, "positions %llu invalid %llu nodes %llu time %.3fs positions/sec %.1f workers %d\n", (unsigned long long) summary.positions, (unsigned long long) summary.invalid,
+		(unsigned long long) summary.nodes, summary.seconds, summary.seconds > 0 ? summary.positions/summary.seconds : 0.0, summary.workers);
+	if (!analysed)  {
+		fprintf(stderr, "Could not analyse the positions; check the input and output files\n");
+		return 1;
+	}
+	return 0;
+}
+
 /**
  * @brief Plays Reversi
  *
- * Calls the function to simulate a full game of reversi, linking all variables and function calls 
+ * Calls the function to simulate a full game of reversi, linking all variables and function calls. Accepts -hash followed by the size of the transposition table in megabytes, -threads followed 
+ * by the number of threads each search uses, -weights followed by a file of evaluation weights written by the trainer, -book followed by an opening book written by makebook, -solved followed by a strong-solve database written by solvedb, -endgame followed by the number of empty squares at which the AI starts solving the game exactly, -ponder to let the AI search while the user thinks, and -stats to print what every search did and how the table was used once the game ends. With -selfplay followed by a number of games, the engine
+ * plays itself instead, headless, on the sizes given with -sizes, from the seed given with -seed, writing the games to the file given with -out. With -analyse followed by a file of positions, every
+ * position is searched instead, on the number of engines given with -workers, and the best moves are written in input order to the file given with -out. With -records followed by a file,
+ * every finished game, played at the terminal or in self-play, is added to that binary record file, and with -statsjson followed by a file, every search the AI makes is written to it as a line of JSON.
+ * With -protocol, the engine stays running and answers the requests of the text protocol in protocol.c on its standard input instead
+ *
+ * Each search is limited by -depth followed by a number of moves, -movetime followed by milliseconds per move, -clock followed by the seconds on the AI's clock for the whole game, with -inc
+ * followed by the seconds added after every move, and -nodes followed by a number of positions; the first limit reached ends the search. With none of them the depth depends on the board size
  */
-int main (void)  {
+int main (int argc, char** argv)  {
 	//Variable declaration
-	int boardSize, computerScore = 2, playerScore = 2;
+	int boardSize, computerScore = 2, playerScore = 2, status;
 	char computerColour, playerColour;
+	ReversiConfig config = {REVERSI_DEFAULT_HASH_MEGABYTES, 1, NULL, NULL, NULL};
+	SearchLimits limits = {0, DEFAULT_ENDGAME_EMPTIES, 0, 0, 0, 0, NULL};
+	AISettings settings;
+	SelfPlayOptions selfPlayOptions = {0, {8}, 1, 1, DEFAULT_RANDOM_PLIES, {0}, NULL, NULL, NULL};
+	static GameRecord record;
+	AnalysisOptions analysisOptions = {NULL, NULL, 1, {0}, {0}};
+	bool headless = false, showStats = false, ponder = false, protocol = false;
 
+	//Reads the options from the command line
+	for (int i = 1; i < argc; i++)  {
+		if (strcmp(argv[i], "-hash") == 0 && i+1 < argc)  {
+			config.hashMegabytes = (size_t) atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc)  {
+			config.threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-weights") == 0 && i+1 < argc)  {
+			config.weightsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-book") == 0 && i+1 < argc)  {
+			config.bookPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-solved") == 0 && i+1 < argc)  {
+			config.solvedPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-endgame") == 0 && i+1 < argc)  {
+			limits.endgameEmpties = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-depth") == 0 && i+1 < argc)  {
+			limits.maxDepth = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-movetime") == 0 && i+1 < argc)  {
+			limits.moveTime = atof(argv[++i]) / 1000;
+		}
+		else if (strcmp(argv[i], "-clock") == 0 && i+1 < argc)  {
+			limits.clockTime = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-inc") == 0 && i+1 < argc)  {
+			limits.increment = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-nodes") == 0 && i+1 < argc)  {
+			limits.maxNodes = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-stats") == 0)  {
+			showStats = true;
+		}
+		else if (strcmp(argv[i], "-ponder") == 0)  {
+			ponder = true;
+		}
+		else if (strcmp(argv[i], "-protocol") == 0)  {
+			protocol = true;
+		}
+		else if (strcmp(argv[i], "-selfplay") == 0 && i+1 < argc)  {
+			headless = true;
+			selfPlayOptions.games = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-sizes") == 0 && i+1 < argc)  {
+			readSizes(argv[++i], &selfPlayOptions);
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc)  {
+			selfPlayOptions.seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-random") == 0 && i+1 < argc)  {
+			selfPlayOptions.randomPlies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-out") == 0 && i+1 < argc)  {
+			selfPlayOptions.outputPath = argv[++i];
+			analysisOptions.outputPath = selfPlayOptions.outputPath;
+		}
+		else if (strcmp(argv[i], "-statsjson") == 0 && i+1 < argc)  {
+			selfPlayOptions.statsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-records") == 0 && i+1 < argc)  {
+			selfPlayOptions.recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-analyse") == 0 && i+1 < argc)  {
+			analysisOptions.inputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-workers") == 0 && i+1 < argc)  {
+			analysisOptions.workers = atoi(argv[++i]);
+		}
+	}
+	settings.showStats = showStats;
+	settings.ponder = ponder;
+	settings.limits = limits;
+	settings.record = selfPlayOptions.recordPath != NULL ? &record : NULL;
+	settings.statsFile = NULL;
+	selfPlayOptions.limits = limits;
+	//Each worker sets up its own engine, so none is set up here
+	if (analysisOptions.inputPath != NULL)  {
+		analysisOptions.config = config;
+		analysisOptions.limits = limits;
+		return runAnalysis(&analysisOptions);
+	}
+
+	//Sets up the transposition table once, at its final size, and the search threads and their memory, before any input is taken
+	settings.engine = reversiCreate(&config);
+	if (settings.engine == NULL)  {
+		fprintf(stderr, "Could not set up a %zu MB transposition table and %d search threads%s%s%s%s%s%s\n", config.hashMegabytes, config.threads, config.weightsPath != NULL ? " with the weights in " : "",
+			config.weightsPath != NULL ? config.weightsPath : "", config.bookPath != NULL ? " with the book in " : "", config.bookPath != NULL ? config.bookPath : "",
+			config.solvedPath != NULL ? " with the database in " : "", config.solvedPath != NULL ? config.solvedPath : "");
+		return 1;
+	}
+	//The engine stays up between requests, keeping its table and book from one game to the next
+	if (protocol)  {
+		status = runProtocol(settings.engine, &settings.limits, stdin, stdout);
+		reversiFree(settings.engine);
+		return status;
+	}
+	if (headless)  {
+		status = runSelfPlay(settings.engine, &selfPlayOptions);
+		if (settings.showStats)  {
+			printTableStats(reversiTable(settings.engine));
+			printBookStats(settings.engine);
+		}
+		reversiFree(settings.engine);
+		return status;
+	}
 	
+	if (selfPlayOptions.statsPath != NULL)  {
+		settings.statsFile = fopen(selfPlayOptions.statsPath, "w");
+		if (settings.statsFile == NULL)  {
+			fprintf(stderr, "Could not write %s\n", selfPlayOptions.statsPath);
+			reversiFree(settings.engine);
+			return 1;
+		}
+	}
+
 	//Takes inputs of colours and board size from user
-	setGame(&boardSize, &computerColour, &playerColour);
+	if (!setGame(&boardSize, &computerColour, &playerColour))  {
+		fprintf(stderr, "No board dimension was given\n");
+		if (settings.statsFile != NULL)  {
+			fclose(settings.statsFile);
+		}
+		reversiFree(settings.engine);
+		return 1;
+	}
 
 	//Sets two identical boards, one for the AI's optimization algorithm, and the other for the game master
 	char** boardGameMaster = setBoard(boardSize);
@@ -579,8 +801,22 @@ int main (void)  {
 	//Prints out original configuration of board
 	printBoard(boardGameMaster, boardSize);
 	//Calls the function to play the game and passes all requisite values and pointers to it
-	playGame(boardGameMaster, boardAI, boardSize, playerColour, computerColour, &computerScore, &playerScore);
-	//Frees heap memory after game ends
+	playGame(boardGameMaster, boardAI, boardSize, playerColour, computerColour, &computerScore, &playerScore, &settings);
+	if (settings.record != NULL)  {
+		saveGameRecord(selfPlayOptions.recordPath, settings.record, boardGameMaster, boardSize, playerScore);
+	}
+	if (settings.showStats)  {
+		printTableStats(reversiTable(settings.engine));
+		printBookStats(settings.engine);
+		printPonderStats(settings.engine);
+	}
+	//Frees heap memory after game ends; each board is its block of squares plus its array of row pointers
+	free(boardGameMaster[0]);
 	free(boardGameMaster);
+	free(boardAI[0]);
 	free(boardAI);
+	if (settings.statsFile != NULL)  {
+		fclose(settings.statsFile);
+	}
+	reversiFree(settings.engine);
 }
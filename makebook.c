@@ -0,0 +1,180 @@
+/**
+ * @file makebook.c
+ * @brief Builds or extends an opening book from self-play game records
+ *
+ * Replays every game of the record files, binary or text, and adds, for each of its first moves, the position the move was played from, the move, and the final disc differential for the side that played it. An existing
+ * book at the output path is read first and its results are added to, so a book can be grown run by run; the new book then replaces the old one in a single rename
+ *
+ *   makebook.exe [-book FILE] [-plies N] [-min N] records...
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "reversi.h"
+#include "book.h"
+#include "record.h"
+
+//Defaults of the command line options
+#define DEFAULT_BOOK "book.bin"
+#define DEFAULT_BOOK_PLIES 16
+#define DEFAULT_MIN_GAMES 2
+
+/**
+ * @brief Every entry gathered so far, in one growing array
+ */
+typedef struct  {
+	BookEntry* entries;
+	size_t count;
+	size_t capacity;
+} EntryList;
+
+/**
+ * @brief Adds an entry, growing the list as needed
+ *
+ * @return Whether there was memory for it
+ */
+static bool addEntry (EntryList* list, const BookEntry* entry)  {
+	if (list->count == list->capacity)  {
+		size_t capacity = list->capacity > 0 ? 2*list->capacity : 1 << 16;
+		BookEntry* grown = (BookEntry*) realloc(list->entries, capacity*sizeof(BookEntry));
+		if (grown == NULL)  {
+			return false;
+		}
+		list->entries = grown;
+		list->capacity = capacity;
+	}
+	list->entries[list->count++] = *entry;
+	return true;
+}
+
+/**
+ * @brief The opening moves of the game being replayed, kept until the whole game is known to be legal
+ */
+typedef struct  {
+	const GameRecord* game;
+	int plies;						//The number of opening moves added
+	int count;
+	BookEntry entries[MAX_UNDO_MOVES];
+} Opening;
+
+/**
+ * @brief Keeps one opening move of a replayed game, for recordReplay
+ */
+static bool visitOpening (const Position* pos, int ply, int move, void* context)  {
+	Opening* opening = (Opening*) context;
+	const int* discs = opening->game->discs;
+
+	//Passes are forced, so they are never looked up
+	if (ply < opening->plies && move != PASS_MOVE)  {
+		opening->entries[opening->count].hash = pos->hash;
+		opening->entries[opening->count].move = (int16_t) move;
+		opening->entries[opening->count].games = 1;
+		opening->entries[opening->count].resultSum = pos->side == BLACK ? discs[BLACK] - discs[WHITE] : discs[WHITE] - discs[BLACK];
+		opening->count++;
+	}
+	return true;
+}
+
+/**
+ * @brief Replays one game and adds its first moves to the list
+ *
+ * The whole game is replayed and its final count checked before anything is added, so a record that is not a legal, finished game adds nothing
+ *
+ * @param list The entries
+ * @param game The game
+ * @param plies The number of opening moves added
+ *
+ * @return 1 if the game was added, 0 if it is not a legal, finished game, and -1 if there was no memory left
+ */
+static int addGame (EntryList* list, const GameRecord* game, int plies)  {
+	static Opening opening;
+
+	opening.game = game;
+	opening.plies = plies;
+	opening.count = 0;
+	if (recordReplay(game, visitOpening, &opening) != 1)  {
+		return 0;
+	}
+	for (int i = 0; i < opening.count; i++)  {
+		if (!addEntry(list, &opening.entries[i]))  {
+			return -1;
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Builds the book
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	const char* path = DEFAULT_BOOK;
+	int plies = DEFAULT_BOOK_PLIES, minGames = DEFAULT_MIN_GAMES, games = 0, skipped = 0, status;
+	EntryList list = {NULL, 0, 0};
+	static GameRecord game;
+	OpeningBook* existing;
+	size_t previous = 0;
+	bool read = true;
+
+	//Options come first, so the book to extend is known before any record is read
+	int first = 1;
+	for (; first < argc && argv[first][0] == '-'; first++)  {
+		if (strcmp(argv[first], "-book") == 0 && first+1 < argc)  {
+			path = argv[++first];
+		}
+		else if (strcmp(argv[first], "-plies") == 0 && first+1 < argc)  {
+			plies = atoi(argv[++first]);
+		}
+		else if (strcmp(argv[first], "-min") == 0 && first+1 < argc)  {
+			minGames = atoi(argv[++first]);
+		}
+	}
+
+	existing = bookOpen(path);
+	for (size_t i = 0; existing != NULL && i < existing->count && read; i++)  {
+		read = addEntry(&list, &existing->entries[i]);
+	}
+	if (existing != NULL)  {
+		previous = existing->count;
+		bookClose(existing);
+	}
+
+	for (int i = first; i < argc && read; i++)  {
+		RecordReader* reader = recordOpen(argv[i]);
+		if (reader == NULL)  {
+			fprintf(stderr, "Could not read %s\n", argv[i]);
+			read = false;
+			break;
+		}
+		while ((status = recordRead(reader, &game)) != 0)  {
+			status = status > 0 ? addGame(&list, &game, plies) : 0;
+			games += status > 0;
+			skipped += status == 0;
+			if (status < 0)  {
+				read = false;
+				break;
+			}
+		}
+		recordClose(reader);
+	}
+	if (!read)  {
+		fprintf(stderr, "Could not build the book\n");
+		free(list.entries);
+		return 1;
+	}
+
+	list.count = mergeBookEntries(list.entries, list.count);
+	status = bookWrite(path, list.entries, list.count, minGames) ? 0 : 1;
+	if (status == 0)  {
+		printf("games %d skipped %d entries %zu (%zu before) written to %s\n", games, skipped, list.count, previous, path);
+	}
+	else  {
+		fprintf(stderr, "Could not write %s\n", path);
+	}
+	free(list.entries);
+	return status;
+}
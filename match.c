@@ -0,0 +1,770 @@
+/**
+ * @file match.c
+ * @brief Plays two engines against each other in many games at once, until a sequential probability ratio test decides between them
+ *
+ * Each engine is a command that starts a program answering the line protocol of protocol.c, such as "./game.exe -protocol -weights new.bin", so two builds of the engine can be matched as well
+ * as two settings of one. Every worker runs its own copy of both engines for the whole match and plays one pair of games at a time: both games of a pair start from the same opening, a few
+ * random moves from the starting position, and each engine plays Black in one of them, so neither gains from a lopsided opening or from the first move. An opening is only kept if a short
+ * search scores it within a few discs of even, and no opening is used twice. Both engines are told to forget their stored results before every game.
+ *
+ * Every move is searched with the same time limit. An engine that exits, answers with an error or an illegal move, or has still not answered a while after its time is up loses the game, and
+ * is started again for the next one. After every pair one line gives the results so far from engine 1's side, the Elo difference they imply with its 95% error margin, and the log likelihood
+ * ratio of the test and its bounds:
+ *
+ *   pairs 12 games 24 +10 =4 -10 score 50.0% elo +0.0 +- 35.2 llr 0.12 (-2.94, 2.94)
+ *
+ * The test weighs the hypothesis that engine 1 is elo0 stronger than engine 2 against the hypothesis that it is elo1 stronger, with false positive and false negative rates alpha and beta, and
+ * stops the match as soon as the ratio leaves its bounds. The two games of a pair share an opening, so the error margin and the test treat each pair, rather than each game, as one result.
+ * Pairs still being played when the match stops are not counted
+ *
+ *   match.exe -engine1 CMD -engine2 CMD [-games N] [-concurrency N] [-movetime MS] [-size N] [-plies N] [-balance DISCS] [-weights FILE] [-seed N] [-elo0 E] [-elo1 E]
+ *             [-alpha A] [-beta B] [-out FILE]
+ *
+ * Exits with status 1 if an engine cannot be started, the openings cannot be found, or the games cannot be written
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "reversi.h"
+#include "record.h"
+#include "eval.h"
+#include "util.h"
+
+//Longest line sent to or read from an engine: a play request with the moves of a whole game, and the go request after it
+#define MAX_MATCH_LINE (64 + 3*MAX_UNDO_MOVES)
+
+//Most games played at once
+#define MAX_MATCH_WORKERS 256
+
+//Most random moves an opening can start with
+#define MAX_OPENING_PLIES 32
+//Random openings tried for every one kept, before the match gives up
+#define MAX_OPENING_TRIES 1000
+//Depth of the search that checks an opening is balanced
+#define BALANCE_DEPTH 6
+
+//Seconds an engine has to answer its first isready, with its table to set up and its files to load
+#define START_TIME 30.0
+//Seconds an engine may take past its time limit before it loses the game
+#define MOVE_GRACE 1.0
+//Seconds an engine has to exit once told to quit, before it is killed
+#define QUIT_TIME 1.0
+
+//Points engine 1 can score in a pair of games, in half points: 0 to 4
+#define PAIR_RESULTS 5
+//Pairs added to the count of every result before the statistics are taken, so a short run of identical results is not taken for certainty
+#define PAIR_PRIOR 0.25
+//Nearest the ends of the error interval come to a score of 0 or 1, where the Elo difference has no bound
+#define SCORE_CLAMP 1e-6
+
+/**
+ * @brief A running engine: its process and the pipes to its standard input and output
+ */
+typedef struct  {
+	const char* command;
+	pid_t pid;						//The engine's process; -1 when there is none
+	int requests;					//Written to with the engine's requests
+	int answers;					//Read for the engine's answers
+	char buffer[MAX_MATCH_LINE];	//Answers read but not yet taken, up to the end of a line
+	size_t length;
+	bool running;					//Whether the engine has answered everything asked of it so far; false once it has failed, until it is started again
+} MatchEngine;
+
+/**
+ * @brief The random moves both games of a pair start with
+ */
+typedef struct  {
+	uint64_t seed;					//The seed that picked the moves
+	int plies;
+	int moves[MAX_OPENING_PLIES];
+} MatchOpening;
+
+/**
+ * @brief The match, shared by every worker
+ *
+ * Everything above the lock is set before the workers start and only read after. Below it, everything is read and changed under the lock, except that stop is also read without it, atomically,
+ * between moves
+ */
+typedef struct  {
+	const char* commands[2];		//The commands that start each engine
+	int dim;
+	int moveTime;					//Milliseconds every move is searched for
+	MatchOpening* openings;			//One for every pair
+	int pairs;
+	double score0, score1;			//Engine 1's expected score per game under each hypothesis of the test
+	double lower, upper;			//Bounds of the log likelihood ratio that accept each hypothesis
+	FILE* output;					//File every finished game is written to; NULL for none
+	pthread_mutex_t lock;
+	int nextPair;					//Pairs handed to a worker
+	int played;						//Pairs finished and counted
+	int results[3];					//Games engine 1 lost, drew and won
+	int pairResults[PAIR_RESULTS];	//Pairs by the half points engine 1 scored in them
+	int decision;					//0 until the test decides; then 1 if it accepted elo0, 2 if it accepted elo1
+	bool stop;						//Whether workers should stop taking pairs and abandon the games they are playing
+	bool failed;					//Whether an engine could not be started again, or a game could not be written
+} Match;
+
+/**
+ * @brief One worker: a thread and the two engines it plays its games with
+ */
+typedef struct  {
+	Match* match;
+	MatchEngine engines[2];
+	pthread_t thread;
+} MatchWorker;
+
+//Held from making an engine's pipes until they are marked to close on exec, so no engine started by another thread inherits them
+static pthread_mutex_t spawnLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Sends an engine one or more requests
+ *
+ * @param engine The engine
+ * @param requests The requests, each ending with a newline
+ *
+ * @return Whether every byte was written; false if the engine has closed its input
+ */
+static bool sendRequests (MatchEngine* engine, const char* requests)  {
+	size_t length = strlen(requests), sent = 0;
+
+	while (sent < length)  {
+		ssize_t bytes = write(engine->requests, requests+sent, length-sent);
+		if (bytes < 0 && errno == EINTR)  {
+			continue;
+		}
+		if (bytes <= 0)  {
+			return false;
+		}
+		sent += bytes;
+	}
+	return true;
+}
+
+/**
+ * @brief Reads the next line an engine answers with
+ *
+ * @param engine The engine
+ * @param line Receives the line, without its newline; MAX_MATCH_LINE characters
+ * @param deadline The time, from secondsNow, by which the line must have arrived
+ *
+ * @return Whether a whole line arrived in time; false if it did not, if the engine exited, or if the line is too long to be an answer
+ */
+static bool readAnswer (MatchEngine* engine, char* line, double deadline)  {
+	struct pollfd ready;
+	char* end;
+
+	while ((end = (char*) memchr(engine->buffer, '\n', engine->length)) == NULL)  {
+		double left = deadline - secondsNow();
+		ssize_t bytes;
+		if (left <= 0 || engine->length == sizeof(engine->buffer))  {
+			return false;
+		}
+		ready.fd = engine->answers;
+		ready.events = POLLIN;
+		if (poll(&ready, 1, (int) (left*1000) + 1) <= 0)  {
+			continue;
+		}
+		bytes = read(engine->answers, engine->buffer + engine->length, sizeof(engine->buffer) - engine->length);
+		if (bytes < 0 && errno == EINTR)  {
+			continue;
+		}
+		if (bytes <= 0)  {
+			return false;
+		}
+		engine->length += bytes;
+	}
+	*end = '\0';
+	strcpy(line, engine->buffer);
+	engine->length -= end+1 - engine->buffer;
+	memmove(engine->buffer, end+1, engine->length);
+	return true;
+}
+
+/**
+ * @brief Tells an engine to quit and waits for it to exit, killing it if it does not; does nothing if the engine is not running
+ */
+static void stopEngine (MatchEngine* engine)  {
+	struct timespec pause = {0, 10000000};
+	double deadline = secondsNow() + QUIT_TIME;
+
+	if (engine->pid <= 0)  {
+		return;
+	}
+	sendRequests(engine, "quit\n");
+	close(engine->requests);
+	close(engine->answers);
+	while (waitpid(engine->pid, NULL, WNOHANG) == 0)  {
+		if (secondsNow() > deadline)  {
+			kill(engine->pid, SIGKILL);
+			waitpid(engine->pid, NULL, 0);
+			break;
+		}
+		nanosleep(&pause, NULL);
+	}
+	engine->pid = -1;
+	engine->running = false;
+}
+
+/**
+ * @brief Starts an engine and waits until it is ready for requests
+ *
+ * The command is run by the shell, which is replaced by the engine, so the engine itself can be killed if it stops answering. The engine's standard error stays the match's, so its messages
+ * are seen
+ *
+ * @param engine Receives the running engine
+ * @param command The command that starts it
+ *
+ * @return Whether the engine started and answered isready in time
+ */
+static bool startEngine (MatchEngine* engine, const char* command)  {
+	char* shell = (char*) malloc(strlen(command) + 6);
+	char line[MAX_MATCH_LINE];
+	int requests[2], answers[2];
+	bool piped;
+
+	engine->command = command;
+	engine->pid = -1;
+	engine->length = 0;
+	engine->running = false;
+	if (shell == NULL)  {
+		return false;
+	}
+	sprintf(shell, "exec %s", command);
+
+	pthread_mutex_lock(&spawnLock);
+	piped = pipe(requests) == 0;
+	if (piped && pipe(answers) != 0)  {
+		close(requests[0]);
+		close(requests[1]);
+		piped = false;
+	}
+	if (piped)  {
+		for (int i = 0; i < 2; i++)  {
+			fcntl(requests[i], F_SETFD, FD_CLOEXEC);
+			fcntl(answers[i], F_SETFD, FD_CLOEXEC);
+		}
+		engine->pid = fork();
+		if (engine->pid == 0)  {
+			dup2(requests[0], STDIN_FILENO);
+			dup2(answers[1], STDOUT_FILENO);
+			execl("/bin/sh", "sh", "-c", shell, (char*) NULL);
+			_exit(127);
+		}
+		close(requests[0]);
+		close(answers[1]);
+		engine->requests = requests[1];
+		engine->answers = answers[0];
+		if (engine->pid < 0)  {
+			close(engine->requests);
+			close(engine->answers);
+		}
+	}
+	pthread_mutex_unlock(&spawnLock);
+	free(shell);
+	if (engine->pid < 0)  {
+		return false;
+	}
+
+	if (sendRequests(engine, "isready\n"))  {
+		double deadline = secondsNow() + START_TIME;
+		while (readAnswer(engine, line, deadline))  {
+			if (strcmp(line, "readyok") == 0)  {
+				engine->running = true;
+				return true;
+			}
+		}
+	}
+	stopEngine(engine);
+	return false;
+}
+
+/**
+ * @brief Asks an engine for its move in a game
+ *
+ * @param match The match
+ * @param engine The engine to move
+ * @param game The moves of the game so far
+ * @param sent The number of the game's moves the engine has been sent; advanced past those sent now
+ * @param failure Receives why the engine gave no move, if it did not
+ *
+ * @return The move the engine played, which may not be legal, or NO_MOVE if it gave none
+ */
+static int askMove (const Match* match, MatchEngine* engine, const GameRecord* game, int* sent, const char** failure)  {
+	char line[MAX_MATCH_LINE];
+	char name[3];
+	size_t length = 0;
+	double deadline;
+
+	//Plays the moves the engine has not seen yet on its position, then starts its search
+	if (*sent < game->moveCount)  {
+		length += sprintf(line, "play");
+		for (; *sent < game->moveCount; (*sent)++)  {
+			reversiMoveName(game->moves[*sent], game->dim, name);
+			length += sprintf(line+length, " %s", name);
+		}
+		line[length++] = '\n';
+	}
+	sprintf(line+length, "go movetime %d\n", match->moveTime);
+	if (!sendRequests(engine, line))  {
+		*failure = "exited";
+		return NO_MOVE;
+	}
+
+	deadline = secondsNow() + match->moveTime/1000.0 + MOVE_GRACE;
+	while (readAnswer(engine, line, deadline))  {
+		if (strncmp(line, "error", 5) == 0)  {
+			*failure = "answered with an error";
+			return NO_MOVE;
+		}
+		if (strncmp(line, "bestmove ", 9) == 0)  {
+			if (line[9] == '\0' || line[10] == '\0' || (line[11] != ' ' && line[11] != '\0'))  {
+				*failure = "answered with a move it did not name";
+				return NO_MOVE;
+			}
+			return reversiParseMove(line+9, game->dim);
+		}
+	}
+	*failure = "did not answer in time, or exited";
+	return NO_MOVE;
+}
+
+/**
+ * @brief Plays one game of a pair
+ *
+ * @param worker The worker, with both engines running
+ * @param opening The moves the game starts with
+ * @param black The engine playing Black: 0 for engine 1, 1 for engine 2
+ * @param game Receives the game
+ * @param complete Receives whether the game was played to its end, rather than lost by an engine that failed
+ *
+ * @return The points engine 1 scored, in half points: 2 for a win, 1 for a draw and 0 for a loss; -1 if the match stopped before the game was over
+ */
+static int playMatchGame (MatchWorker* worker, const MatchOpening* opening, int black, GameRecord* game, bool* complete)  {
+	Match* match = worker->match;
+	int legal[MAX_SQUARES];
+	int sent[2] = {0, 0};
+	char request[64];
+	const char* failure = NULL;
+	int player = -1, difference;
+	Position pos;
+
+	reversiNewPosition(&pos, match->dim);
+	game->dim = match->dim;
+	game->seed = opening->seed;
+	game->moveCount = 0;
+	for (int i = 0; i < opening->plies; i++)  {
+		reversiPlay(&pos, opening->moves[i]);
+		game->moves[game->moveCount++] = opening->moves[i];
+	}
+	sprintf(request, "newgame %d\nclearhash\n", match->dim);
+	for (int i = 0; i < 2 && failure == NULL; i++)  {
+		if (!sendRequests(&worker->engines[i], request))  {
+			player = i;
+			failure = "exited";
+		}
+	}
+
+	while (failure == NULL && !reversiGameOver(&pos))  {
+		int move = PASS_MOVE;
+		if (__atomic_load_n(&match->stop, __ATOMIC_RELAXED))  {
+			return -1;
+		}
+		//A side with no legal move passes without asking its engine
+		if (reversiLegalMoves(&pos, legal) > 0)  {
+			player = pos.side == BLACK ? black : 1-black;
+			move = askMove(match, &worker->engines[player], game, &sent[player], &failure);
+			if (failure == NULL && (move == NO_MOVE || !reversiPlay(&pos, move)))  {
+				failure = "played an illegal move";
+			}
+			if (failure != NULL)  {
+				break;
+			}
+		}
+		else  {
+			reversiPlay(&pos, move);
+		}
+		game->moves[game->moveCount++] = move;
+	}
+
+	*complete = failure == NULL;
+	if (failure != NULL)  {
+		worker->engines[player].running = false;
+		fprintf(stderr, "Engine %d loses a game after %d moves: it %s\n", player+1, game->moveCount, failure);
+		return player == 0 ? 0 : 2;
+	}
+	game->discs[BLACK] = reversiDiscs(&pos, BLACK);
+	game->discs[WHITE] = reversiDiscs(&pos, WHITE);
+	difference = black == 0 ? game->discs[BLACK] - game->discs[WHITE] : game->discs[WHITE] - game->discs[BLACK];
+	return difference > 0 ? 2 : (difference == 0 ? 1 : 0);
+}
+
+/**
+ * @brief The Elo difference at which the stronger side scores a given share of the points
+ */
+static double eloFromScore (double score)  {
+	return -400*log10(1/score - 1);
+}
+
+/**
+ * @brief The share of the points the side elo stronger than its opponent is expected to score
+ */
+static double scoreFromElo (double elo)  {
+	return 1/(1 + pow(10, -elo/400));
+}
+
+/**
+ * @brief Counts a finished pair, writes its games, prints the results so far and runs the test; called under the lock
+ *
+ * @param match The match
+ * @param points The half points engine 1 scored in each game of the pair
+ * @param games The games
+ * @param complete Whether each game was played to its end; games lost by an engine that failed are not written
+ */
+static void countPair (Match* match, const int* points, const GameRecord* games, const bool* complete)  {
+	double mean = 0, variance = 0, pairs, margin, llr;
+
+	match->played++;
+	match->pairResults[points[0]+points[1]]++;
+	for (int i = 0; i < 2; i++)  {
+		match->results[points[i]]++;
+		if (match->output != NULL && complete[i])  {
+			recordWriteText(match->output, &games[i]);
+		}
+	}
+
+	//The mean and variance of engine 1's score per game, taking each pair as one result
+	pairs = match->played + PAIR_RESULTS*PAIR_PRIOR;
+	for (int i = 0; i < PAIR_RESULTS; i++)  {
+		mean += (match->pairResults[i] + PAIR_PRIOR) * (i/4.0);
+	}
+	mean /= pairs;
+	for (int i = 0; i < PAIR_RESULTS; i++)  {
+		variance += (match->pairResults[i] + PAIR_PRIOR) * (i/4.0 - mean)*(i/4.0 - mean);
+	}
+	variance /= pairs;
+	margin = 1.96*sqrt(variance/pairs);
+	margin = (eloFromScore(fmin(mean+margin, 1-SCORE_CLAMP)) - eloFromScore(fmax(mean-margin, SCORE_CLAMP))) / 2;
+
+	//The generalised test, taking the scores of the pairs as normally distributed
+	llr = pairs * (match->score1 - match->score0) * (2*mean - match->score0 - match->score1) / (2*variance);
+	if (llr >= match->upper)  {
+		match->decision = 2;
+	}
+	else if (llr <= match->lower)  {
+		match->decision = 1;
+	}
+	if (match->decision != 0 || match->played == match->pairs)  {
+		__atomic_store_n(&match->stop, true, __ATOMIC_RELAXED);
+	}
+
+	printf("pairs %d games %d +%d =%d -%d score %.1f%% elo %+.1f +- %.1f llr %.2f (%.2f, %.2f)\n", match->played, 2*match->played, match->results[2], match->results[1], match->results[0],
+		100*mean, eloFromScore(mean), margin, llr, match->lower, match->upper);
+	fflush(stdout);
+}
+
+/**
+ * @brief Starts again any of a worker's engines that failed in its last game
+ *
+ * @param worker The worker
+ *
+ * @return Whether both engines are running; if one could not be started, the match is stopped
+ */
+static bool restartEngines (MatchWorker* worker)  {
+	Match* match = worker->match;
+
+	for (int i = 0; i < 2; i++)  {
+		if (worker->engines[i].running)  {
+			continue;
+		}
+		stopEngine(&worker->engines[i]);
+		if (!startEngine(&worker->engines[i], match->commands[i]))  {
+			fprintf(stderr, "Could not start engine %d again: %s\n", i+1, match->commands[i]);
+			pthread_mutex_lock(&match->lock);
+			match->failed = true;
+			__atomic_store_n(&match->stop, true, __ATOMIC_RELAXED);
+			pthread_mutex_unlock(&match->lock);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Plays pairs of games until every pair has been handed out or the match stops
+ *
+ * @param argument The worker, with both engines running
+ *
+ * @return NULL
+ */
+static void* matchWorker (void* argument)  {
+	MatchWorker* worker = (MatchWorker*) argument;
+	Match* match = worker->match;
+	GameRecord* games = (GameRecord*) malloc(2*sizeof(GameRecord));
+	int points[2];
+	bool complete[2];
+
+	while (games != NULL)  {
+		int pair;
+		pthread_mutex_lock(&match->lock);
+		pair = match->nextPair;
+		if (match->stop || pair == match->pairs)  {
+			pthread_mutex_unlock(&match->lock);
+			break;
+		}
+		match->nextPair++;
+		pthread_mutex_unlock(&match->lock);
+
+		//Engine 1 plays Black in the first game of the pair, and White in the second
+		for (int i = 0; i < 2 && games != NULL; i++)  {
+			if (!restartEngines(worker) || (points[i] = playMatchGame(worker, &match->openings[pair], i, &games[i], &complete[i])) < 0)  {
+				free(games);
+				games = NULL;
+			}
+		}
+
+		//A pair that ends after the test has decided is not counted, so the results are the ones the test decided on
+		if (games != NULL)  {
+			pthread_mutex_lock(&match->lock);
+			if (!match->stop)  {
+				countPair(match, points, games, complete);
+			}
+			pthread_mutex_unlock(&match->lock);
+		}
+	}
+	free(games);
+	return NULL;
+}
+
+/**
+ * @brief Picks the opening of every pair: random moves from the starting position, kept only if the game is not over, the position has not been used, and a short search finds it balanced
+ *
+ * @param match The match; receives the openings
+ * @param plies The number of random moves in each opening, passes included
+ * @param balance Openings the search scores more than this many discs from even for either side are not used; 0 to use every opening
+ * @param seed The seed of the first opening tried; each one tried after it has the next seed
+ * @param weightsPath Evaluation weights the search uses; NULL for the hand-set weights
+ *
+ * @return Whether an opening was found for every pair
+ */
+static bool pickOpenings (Match* match, int plies, int balance, uint64_t seed, const char* weightsPath)  {
+	ReversiConfig config = {0, 1, weightsPath, NULL, NULL};
+	SearchLimits limits = {BALANCE_DEPTH, 0, 0, 0, 0, 0, NULL};
+	SearchResult result;
+	ReversiEngine* engine = balance > 0 ? reversiCreate(&config) : NULL;
+	int legal[MAX_SQUARES];
+	size_t capacity = 1;
+	uint64_t* used;
+	int pair = 0;
+
+	//The hashes of the openings already used, in an open-addressed set with room to spare; a hash of 0 marks an empty slot
+	while (capacity < 2 * (size_t) match->pairs)  {
+		capacity *= 2;
+	}
+	used = (uint64_t*) calloc(capacity, sizeof(uint64_t));
+	match->openings = (MatchOpening*) malloc(match->pairs * sizeof(MatchOpening));
+	if (used == NULL || match->openings == NULL || (balance > 0 && engine == NULL))  {
+		free(used);
+		reversiFree(engine);
+		return false;
+	}
+
+	for (int tries = 0; pair < match->pairs && tries < MAX_OPENING_TRIES*match->pairs; tries++, seed++)  {
+		MatchOpening* opening = &match->openings[pair];
+		uint64_t random = seed;
+		size_t slot;
+		Position pos;
+
+		reversiNewPosition(&pos, match->dim);
+		opening->seed = seed;
+		opening->plies = 0;
+		while (opening->plies < plies && !reversiGameOver(&pos))  {
+			int count = reversiLegalMoves(&pos, legal);
+			int move = count > 0 ? legal[nextRandom(&random) % count] : PASS_MOVE;
+			reversiPlay(&pos, move);
+			opening->moves[opening->plies++] = move;
+		}
+		if (reversiGameOver(&pos))  {
+			continue;
+		}
+		for (slot = pos.hash & (capacity-1); used[slot] != 0 && used[slot] != pos.hash; slot = (slot+1) & (capacity-1))  {
+		}
+		if (used[slot] == pos.hash)  {
+			continue;
+		}
+		if (engine != NULL)  {
+			reversiNewGame(engine);
+			reversiSearch(engine, &pos, &limits, &result);
+			if (abs(result.score) > balance*EVAL_SCALE)  {
+				continue;
+			}
+		}
+		used[slot] = pos.hash;
+		pair++;
+	}
+
+	free(used);
+	reversiFree(engine);
+	return pair == match->pairs;
+}
+
+/**
+ * @brief Plays the match
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	static Match match;
+	static MatchWorker workers[MAX_MATCH_WORKERS];
+	const char* outputPath = NULL;
+	const char* weightsPath = NULL;
+	const char* decisions[3] = {"undecided", "accepted elo0", "accepted elo1"};
+	int games = 1000, workerCount = (int) sysconf(_SC_NPROCESSORS_ONLN), plies = 8, balance = 4, started = 0;
+	uint64_t seed = 1;
+	double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05, start;
+	bool ready = true;
+	Position pos;
+
+	match.dim = 8;
+	match.moveTime = 100;
+	for (int i = 1; i < argc; i++)  {
+		if (strcmp(argv[i], "-engine1") == 0 && i+1 < argc)  {
+			match.commands[0] = argv[++i];
+		}
+		else if (strcmp(argv[i], "-engine2") == 0 && i+1 < argc)  {
+			match.commands[1] = argv[++i];
+		}
+		else if (strcmp(argv[i], "-games") == 0 && i+1 < argc)  {
+			games = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-concurrency") == 0 && i+1 < argc)  {
+			workerCount = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-movetime") == 0 && i+1 < argc)  {
+			match.moveTime = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-size") == 0 && i+1 < argc)  {
+			match.dim = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-plies") == 0 && i+1 < argc)  {
+			plies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-balance") == 0 && i+1 < argc)  {
+			balance = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-weights") == 0 && i+1 < argc)  {
+			weightsPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc)  {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-elo0") == 0 && i+1 < argc)  {
+			elo0 = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-elo1") == 0 && i+1 < argc)  {
+			elo1 = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-alpha") == 0 && i+1 < argc)  {
+			alpha = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-beta") == 0 && i+1 < argc)  {
+			beta = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-out") == 0 && i+1 < argc)  {
+			outputPath = argv[++i];
+		}
+	}
+	if (match.commands[0] == NULL || match.commands[1] == NULL || games < 1 || match.moveTime < 1 || !reversiNewPosition(&pos, match.dim) || plies < 0 || plies > MAX_OPENING_PLIES ||
+		elo1 <= elo0 || alpha <= 0 || alpha >= 1 || beta <= 0 || beta >= 1)  {
+		fprintf(stderr, "Usage: match.exe -engine1 CMD -engine2 CMD [-games N] [-concurrency N] [-movetime MS] [-size N] [-plies N] [-balance DISCS] [-weights FILE] [-seed N]\n"
+			"                 [-elo0 E] [-elo1 E] [-alpha A] [-beta B] [-out FILE]\n"
+			"Each engine command must start a program answering the engine protocol, such as \"./game.exe -protocol\"; elo1 must be above elo0, and at most %d opening plies\n",
+			MAX_OPENING_PLIES);
+		return 1;
+	}
+
+	//Every game is a pair of games, and there is no use in more workers than pairs
+	match.pairs = (games+1) / 2;
+	workerCount = workerCount < 1 ? 1 : (workerCount < MAX_MATCH_WORKERS ? workerCount : MAX_MATCH_WORKERS);
+	workerCount = workerCount < match.pairs ? workerCount : match.pairs;
+	match.score0 = scoreFromElo(elo0);
+	match.score1 = scoreFromElo(elo1);
+	match.lower = log(beta / (1-alpha));
+	match.upper = log((1-beta) / alpha);
+	pthread_mutex_init(&match.lock, NULL);
+
+	if (!pickOpenings(&match, plies, balance, seed, weightsPath))  {
+		fprintf(stderr, "Could not find %d different openings of %d plies within %d discs of even; use more plies, a wider balance or fewer games\n", match.pairs, plies, balance);
+		return 1;
+	}
+	if (outputPath != NULL)  {
+		match.output = fopen(outputPath, "w");
+		if (match.output == NULL)  {
+			fprintf(stderr, "Could not write %s\n", outputPath);
+			return 1;
+		}
+	}
+	//An engine that exits must not end the match when a request is written to it
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("engine 1: %s\nengine 2: %s\n", match.commands[0], match.commands[1]);
+	printf("pairs %d size %d plies %d movetime %dms concurrency %d elo0 %.1f elo1 %.1f alpha %.3f beta %.3f\n", match.pairs, match.dim, plies, match.moveTime, workerCount, elo0, elo1, alpha, beta);
+	fflush(stdout);
+
+	//No engine is running yet; a worker whose first engine fails to start must not stop a second one that never was
+	for (int i = 0; i < workerCount; i++)  {
+		workers[i].engines[0].pid = -1;
+		workers[i].engines[1].pid = -1;
+	}
+	start = secondsNow();
+	for (; ready && started < workerCount; started++)  {
+		MatchWorker* worker = &workers[started];
+		worker->match = &match;
+		for (int e = 0; e < 2 && ready; e++)  {
+			ready = startEngine(&worker->engines[e], match.commands[e]);
+			if (!ready)  {
+				fprintf(stderr, "Could not start engine %d: %s\n", e+1, match.commands[e]);
+			}
+		}
+		if (ready && pthread_create(&worker->thread, NULL, matchWorker, worker) != 0)  {
+			ready = false;
+		}
+		if (!ready)  {
+			stopEngine(&worker->engines[0]);
+			stopEngine(&worker->engines[1]);
+			break;
+		}
+	}
+	if (!ready)  {
+		pthread_mutex_lock(&match.lock);
+		match.failed = true;
+		__atomic_store_n(&match.stop, true, __ATOMIC_RELAXED);
+		pthread_mutex_unlock(&match.lock);
+	}
+	for (int i = 0; i < started; i++)  {
+		pthread_join(workers[i].thread, NULL);
+		stopEngine(&workers[i].engines[0]);
+		stopEngine(&workers[i].engines[1]);
+	}
+	pthread_mutex_destroy(&match.lock);
+
+	if (match.output != NULL && (ferror(match.output) | fclose(match.output)) != 0)  {
+		fprintf(stderr, "Could not write %s\n", outputPath);
+		match.failed = true;
+	}
+	printf("games %d +%d =%d -%d sprt %s time %.1fs\n", 2*match.played, match.results[2], match.results[1], match.results[0], decisions[match.decision], secondsNow() - start);
+	free(match.openings);
+	return match.failed ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file order.c
+ * @brief Move ordering: which moves of a position the search tries first
+ *
+ * Alpha-beta cuts a position off as soon as one move is good enough, so the sooner the best move is tried the less of the tree is searched. Each move is given one key, from these sources in
+ * order of trust:
+ *
+ *   table move   the best move the transposition table holds for the position, from an earlier iteration or another move order; always first
+ *   killers      the last two moves that caused a cut off at the same ply elsewhere in the tree; a move that refutes one line often refutes its siblings too
+ *   mobility     how many replies the move leaves the opponent, fewest first; only where enough depth is left below to repay making the move
+ *   squares      a fixed priority for every square: corners, which can never be flipped, first, then the edges, and last the squares next to a corner, which give it away
+ *   history      how often, and how deep, the move has caused cut offs anywhere in the search so far
+ *
+ * Moves with equal keys keep their order from Northwest to Southeast. Each thread keeps its own killers and history, cleared at the start of every search
+ */
+
+#include <string.h>
+
+#include "order.h"
+
+//Keys of the table move and of the killers; above any key the other sources can give
+#define TABLE_MOVE_KEY (1 << 30)
+#define KILLER_KEY (1 << 28)
+
+//Weights of the other sources in a move's key
+#define MOBILITY_WEIGHT 16
+#define PRIORITY_WEIGHT 4
+//History is divided by this and capped, so it breaks ties between moves the other sources find alike rather than overruling them
+#define HISTORY_DIVISOR 16
+#define MAX_HISTORY_KEY 64
+//History halves once any entry reaches this, so the moves of recent cut offs count most
+#define HISTORY_LIMIT (1 << 24)
+
+//Priority of each kind of square
+#define CORNER_PRIORITY 6
+#define EDGE_PRIORITY 2
+#define INNER_EDGE_PRIORITY -1
+#define C_SQUARE_PRIORITY -3
+#define X_SQUARE_PRIORITY -5
+
+/**
+ * @brief Distance of a row or column from the nearest edge of the board
+ */
+static inline int edgeDistance (int index, int dim)  {
+	return index < dim-1-index ? index : dim-1-index;
+}
+
+/**
+ * @brief Clears the killers and history and sets up the square priorities for a new search
+ *
+ * @param ordering The tables
+ * @param dim The size n of the n x n board searched
+ */
+void orderingInit (MoveOrdering* ordering, int dim)  {
+	ordering->dim = dim;
+	for (int ply = 0; ply < MAX_PLY; ply++)  {
+		for (int slot = 0; slot < KILLER_SLOTS; slot++)  {
+			ordering->killers[ply][slot] = NO_MOVE;
+		}
+	}
+	memset(ordering->history, 0, sizeof(ordering->history));
+
+	for (int row = 0; row < dim; row++)  {
+		for (int col = 0; col < dim; col++)  {
+			int rowEdge = edgeDistance(row, dim), colEdge = edgeDistance(col, dim), priority = 0;
+			if (rowEdge == 0 && colEdge == 0)  {
+				priority = CORNER_PRIORITY;
+			}
+			else if (rowEdge == 1 && colEdge == 1)  {
+				priority = X_SQUARE_PRIORITY;
+			}
+			else if ((rowEdge == 0 && colEdge == 1) || (rowEdge == 1 && colEdge == 0))  {
+				priority = C_SQUARE_PRIORITY;
+			}
+			else if (rowEdge == 0 || colEdge == 0)  {
+				priority = EDGE_PRIORITY;
+			}
+			else if (rowEdge == 1 || colEdge == 1)  {
+				priority = INNER_EDGE_PRIORITY;
+			}
+			ordering->priority[row*dim + col] = (int8_t) priority;
+		}
+	}
+}
+
+/**
+ * @brief Counts the replies the opponent would have after a move
+ *
+ * On an 8 x 8 board this works on the bare words; on any other board the move is made and taken back
+ */
+static int repliesAfter (Position* pos, UndoStack* undo, int move)  {
+	Bitboard replies;
+	int count;
+
+	if (pos->dim == 8)  {
+		uint64_t own = pos->disc[pos->side].word[0], opp = pos->disc[1-pos->side].word[0];
+		uint64_t flips = computeFlips8x8(own, opp, move);
+		return __builtin_popcountll(generateMoves8x8(opp & ~flips, own | flips | 1ULL << move));
+	}
+	makeMove(pos, move, undo);
+	generateMoves(pos, pos->side, &replies);
+	count = countSquares(&replies, pos->words);
+	unmakeMove(pos, undo);
+	return count;
+}
+
+/**
+ * @brief Sorts moves by their keys, highest first, keeping the order of moves with equal keys
+ *
+ * @param moves The moves, sorted in place
+ * @param keys The key of each move, sorted along with it
+ * @param count The number of moves
+ */
+void sortMoves (int* moves, int* keys, int count)  {
+	//Move lists are short, and usually close to sorted already
+	for (int i = 1; i < count; i++)  {
+		int move = moves[i], key = keys[i], j = i;
+		while (j > 0 && keys[j-1] < key)  {
+			moves[j] = moves[j-1];
+			keys[j] = keys[j-1];
+			j--;
+		}
+		moves[j] = move;
+		keys[j] = key;
+	}
+}
+
+/**
+ * @brief Puts the moves of a position in the order they should be searched
+ *
+ * @param ordering The thread's tables
+ * @param pos The position; moves made on it to count the replies are taken back
+ * @param undo The stack those moves are recorded on
+ * @param moves The legal moves, sorted in place
+ * @param count The number of moves
+ * @param ply The number of moves made since the root
+ * @param depth The depth left to search below the position
+ * @param ttMove The best move the transposition table holds for the position, or NO_MOVE
+ */
+void orderMoves (const MoveOrdering* ordering, Position* pos, UndoStack* undo, int* moves, int count, int ply, int depth, int ttMove)  {
+	int keys[MAX_SQUARES];
+	const int32_t* history = ordering->history[pos->side];
+
+	for (int i = 0; i < count; i++)  {
+		int move = moves[i], key, historyKey;
+		if (move == ttMove)  {
+			keys[i] = TABLE_MOVE_KEY;
+			continue;
+		}
+		if (move == ordering->killers[ply][0])  {
+			keys[i] = KILLER_KEY + 1;
+			continue;
+		}
+		if (move == ordering->killers[ply][1])  {
+			keys[i] = KILLER_KEY;
+			continue;
+		}
+		historyKey = history[move] / HISTORY_DIVISOR;
+		key = PRIORITY_WEIGHT*ordering->priority[move] + (historyKey < MAX_HISTORY_KEY ? historyKey : MAX_HISTORY_KEY);
+		if (depth >= MOBILITY_ORDER_DEPTH)  {
+			key -= MOBILITY_WEIGHT*repliesAfter(pos, undo, move);
+		}
+		keys[i] = key;
+	}
+	sortMoves(moves, keys, count);
+}
+
+/**
+ * @brief Learns from a move that caused a cut off
+ *
+ * @param ordering The thread's tables
+ * @param side The colour that played the move
+ * @param ply The number of moves made since the root
+ * @param depth The depth left to search below the position; deeper cut offs save more, and count for more
+ * @param move The move
+ */
+void orderingCutoff (MoveOrdering* ordering, int side, int ply, int depth, int move)  {
+	int32_t* history = ordering->history[side];
+
+	if (ordering->killers[ply][0] != move)  {
+		ordering->killers[ply][1] = ordering->killers[ply][0];
+		ordering->killers[ply][0] = move;
+	}
+	history[move] += depth*depth;
+	if (history[move] >= HISTORY_LIMIT)  {
+		for (int colour = 0; colour < 2; colour++)  {
+			for (int square = 0; square < ordering->dim*ordering->dim; square++)  {
+				ordering->history[colour][square] /= 2;
+			}
+		}
+	}
+}
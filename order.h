@@ -0,0 +1,39 @@
+/**
+ * @file order.h
+ * @brief Move ordering: which moves of a position the search tries first
+ */
+
+#ifndef ORDER_H
+#define ORDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+#include "search.h"
+
+//Killer moves kept for each ply
+#define KILLER_SLOTS 2
+
+//Remaining depth at or above which each move is also scored by the opponent's replies after it
+#define MOBILITY_ORDER_DEPTH 2
+
+/**
+ * @brief What a thread has learned about good moves during one search
+ *
+ * Moves are given a key from several sources and tried from the highest key down: the transposition table's move, then the killer moves of the ply, then every other move by how few replies it
+ * leaves the opponent, the priority of its square, and how often it has caused cut offs anywhere in the search
+ */
+typedef struct  {
+	int dim;									//The size of the board the tables are for
+	int killers[MAX_PLY][KILLER_SLOTS];			//The last distinct moves that caused a cut off at each ply, newest first; NO_MOVE when empty
+	int32_t history[2][MAX_SQUARES];			//For each colour and square, the squares of the depths of the cut offs the move has caused
+	int8_t priority[MAX_SQUARES];				//A fixed value for every square: corners highest, then edges, with the squares next to the corners lowest
+} MoveOrdering;
+
+void orderingInit (MoveOrdering* ordering, int dim);
+void orderMoves (const MoveOrdering* ordering, Position* pos, UndoStack* undo, int* moves, int count, int ply, int depth, int ttMove);
+void sortMoves (int* moves, int* keys, int count);
+void orderingCutoff (MoveOrdering* ordering, int side, int ply, int depth, int move);
+
+#endif
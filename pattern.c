@@ -0,0 +1,145 @@
+/**
+ * @file pattern.c
+ * @brief Patterns of squares around each corner, and the table indices of their contents, kept up to date as moves are made
+ *
+ * A position's pattern indices are computed in full once, when it is set up, and from then on makeMove and applyMove add or take away one power of 3 for each disc placed or turned over in a
+ * pattern. Only the squares near the corners belong to any pattern, so most flips cost a single comparison
+ */
+
+#include <pthread.h>
+
+#include "pattern.h"
+
+//Squares of each pattern at the top left corner, as (row, column), lowest digit first; the other corners reflect them
+static const int slotRow[PATTERN_SLOTS][PATTERN_MAX_LENGTH] = {
+	{0, 0, 0, 1, 1, 1, 2, 2, 2},
+	{0, 0, 0, 0, 0, 1, 1, 1, 1, 1},
+	{0, 1, 2, 3, 4, 0, 1, 2, 3, 4},
+	{0, 1, 2, 3, 4}
+};
+static const int slotCol[PATTERN_SLOTS][PATTERN_MAX_LENGTH] = {
+	{0, 1, 2, 0, 1, 2, 0, 1, 2},
+	{0, 1, 2, 3, 4, 0, 1, 2, 3, 4},
+	{0, 0, 0, 0, 0, 1, 1, 1, 1, 1},
+	{0, 1, 2, 3, 4}
+};
+static const int slotType[PATTERN_SLOTS] = {PATTERN_CORNER, PATTERN_EDGE, PATTERN_EDGE, PATTERN_DIAGONAL};
+
+//Squares in each shape of pattern, and where its table starts among the weights of every shape
+const int patternLength[PATTERN_TYPES] = {9, 10, 5};
+const int patternTypeOffset[PATTERN_TYPES] = {0, 19683, 19683 + 59049};
+
+//The shape of each pattern, and where its table starts, pattern by pattern; the patterns of corner k are numbered from k*PATTERN_SLOTS
+const int patternInstanceType[PATTERN_INSTANCES] = {
+	PATTERN_CORNER, PATTERN_EDGE, PATTERN_EDGE, PATTERN_DIAGONAL, PATTERN_CORNER, PATTERN_EDGE, PATTERN_EDGE, PATTERN_DIAGONAL,
+	PATTERN_CORNER, PATTERN_EDGE, PATTERN_EDGE, PATTERN_DIAGONAL, PATTERN_CORNER, PATTERN_EDGE, PATTERN_EDGE, PATTERN_DIAGONAL
+};
+const int patternInstanceOffset[PATTERN_INSTANCES] = {
+	0, 19683, 19683, 19683 + 59049, 0, 19683, 19683, 19683 + 59049, 0, 19683, 19683, 19683 + 59049, 0, 19683, 19683, 19683 + 59049
+};
+
+static PatternLinks links[MAX_DIM+1];
+//Makes sure the patterns of every size are laid out exactly once, whichever thread sets up the first position
+static pthread_once_t linksOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Returns the patterns of a board size
+ *
+ * Only reads the table; the tables of every size are built by computePatternIndices when the first position of any size is set up, before any search can use them
+ *
+ * @param dim The size n of the n x n board
+ */
+const PatternLinks* patternLinks (int dim)  {
+	return &links[dim];
+}
+
+/**
+ * @brief Lays out the patterns of a board size
+ *
+ * @param dim The size n of the n x n board
+ */
+static void buildPatternLinks (int dim)  {
+	PatternLinks* table = &links[dim];
+	int count[MAX_SQUARES+1];
+
+	memset(count, 0, sizeof(count));
+	//Boards too small for patterns keep every square unlinked
+	if (dim >= PATTERN_MIN_DIM)  {
+		for (int instance = 0; instance < PATTERN_INSTANCES; instance++)  {
+			int corner = instance / PATTERN_SLOTS, slot = instance % PATTERN_SLOTS;
+			for (int i = 0; i < patternLength[slotType[slot]]; i++)  {
+				int row = corner & 2 ? dim-1-slotRow[slot][i] : slotRow[slot][i];
+				int col = corner & 1 ? dim-1-slotCol[slot][i] : slotCol[slot][i];
+				table->square[instance][i] = (uint16_t) (row*dim + col);
+				count[row*dim + col]++;
+			}
+		}
+	}
+
+	//Counts the links of every square, then fills them in square by square
+	table->offset[0] = 0;
+	for (int square = 0; square < MAX_SQUARES; square++)  {
+		table->offset[square+1] = (uint16_t) (table->offset[square] + count[square]);
+		count[square] = table->offset[square];
+	}
+	if (dim >= PATTERN_MIN_DIM)  {
+		for (int instance = 0; instance < PATTERN_INSTANCES; instance++)  {
+			int power = 1;
+			for (int i = 0; i < patternLength[patternInstanceType[instance]]; i++, power *= 3)  {
+				PatternLink* link = &table->link[count[table->square[instance][i]]++];
+				link->instance = (uint8_t) instance;
+				link->power = (uint16_t) power;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Lays out the patterns of every board size at once, so threads that later set up positions of sizes not yet played only ever read the tables
+ */
+static void buildAllPatternLinks (void)  {
+	for (int dim = 0; dim <= MAX_DIM; dim++)  {
+		buildPatternLinks(dim);
+	}
+}
+
+/**
+ * @brief Computes every pattern index of a position from its discs
+ *
+ * Called whenever a position is set up from scratch; moves keep the indices up to date from then on
+ *
+ * @param pos The position
+ */
+void computePatternIndices (Position* pos)  {
+	const PatternLinks* table = &links[pos->dim];
+
+	pthread_once(&linksOnce, buildAllPatternLinks);
+	memset(pos->pattern, 0, sizeof(pos->pattern));
+	for (int square = 0; square < pos->dim*pos->dim; square++)  {
+		if (testSquare(&pos->disc[BLACK], square))  {
+			placePatternDisc(pos, table, square, BLACK);
+		}
+		else if (testSquare(&pos->disc[WHITE], square))  {
+			placePatternDisc(pos, table, square, WHITE);
+		}
+	}
+}
+
+/**
+ * @brief Finds the index of a pattern's contents with the colours of every disc swapped
+ *
+ * @param type The shape of the pattern
+ * @param index The index of its contents
+ *
+ * @return The index with every digit 1 turned into 2 and every 2 into 1
+ */
+int swapPatternColours (int type, int index)  {
+	int swapped = 0, power = 1;
+
+	for (int i = 0; i < patternLength[type]; i++, power *= 3)  {
+		int digit = index % 3;
+		swapped += (digit == 0 ? 0 : 3-digit)*power;
+		index /= 3;
+	}
+	return swapped;
+}
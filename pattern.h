@@ -0,0 +1,92 @@
+/**
+ * @file pattern.h
+ * @brief Patterns of squares around each corner, and the table indices of their contents, kept up to date as moves are made
+ *
+ * Every corner of a board of at least PATTERN_MIN_DIM squares a side carries the same PATTERN_SLOTS patterns: the 3 x 3 block in the corner, the 2 x 5 block along each of its two edges, and the
+ * first 5 squares of its diagonal. The contents of a pattern are read as a number in base 3, one digit per square (0 empty, 1 black, 2 white), which indexes the pattern's table of weights. The
+ * patterns of the other corners are reflections of those of the first, with their squares listed in the reflected order, so all eight 2 x 5 blocks share one table, and so on
+ */
+
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <stdint.h>
+
+#include "bitboard.h"
+
+//Smallest board that patterns are kept for; on smaller boards the patterns of the corners would cover most of the board several times over
+#define PATTERN_MIN_DIM 6
+
+//Patterns at each corner, and the most squares in one pattern
+#define PATTERN_SLOTS 4
+#define PATTERN_MAX_LENGTH 10
+
+//The shapes of pattern, each with its own table of weights
+#define PATTERN_CORNER 0	//3 x 3 block in the corner
+#define PATTERN_EDGE 1		//2 x 5 block along an edge from the corner
+#define PATTERN_DIAGONAL 2	//The first 5 squares of the corner's diagonal
+#define PATTERN_TYPES 3
+
+//Entries in the tables of every shape, back to back
+#define PATTERN_WEIGHTS (19683 + 59049 + 243)
+
+/**
+ * @brief One pattern a square belongs to
+ */
+typedef struct  {
+	uint8_t instance;	//The pattern, numbered corner by corner
+	uint16_t power;		//The value of the square's digit in the pattern's index: a power of 3
+} PatternLink;
+
+/**
+ * @brief Where every pattern of one board size lies, and which patterns each square belongs to
+ *
+ * The links of square s are link[offset[s]] up to link[offset[s+1]]; a square far from every corner has none, so a disc flipped there costs nothing
+ */
+typedef struct  {
+	uint16_t square[PATTERN_INSTANCES][PATTERN_MAX_LENGTH];		//The squares of each pattern, lowest digit first
+	uint16_t offset[MAX_SQUARES+1];
+	PatternLink link[PATTERN_INSTANCES*PATTERN_MAX_LENGTH];
+} PatternLinks;
+
+extern const int patternLength[PATTERN_TYPES];
+extern const int patternTypeOffset[PATTERN_TYPES];
+extern const int patternInstanceType[PATTERN_INSTANCES];
+extern const int patternInstanceOffset[PATTERN_INSTANCES];
+
+const PatternLinks* patternLinks (int dim);
+void computePatternIndices (Position* pos);
+int swapPatternColours (int type, int index);
+
+/**
+ * @brief Updates the pattern indices of a position for a disc placed on an empty square
+ *
+ * @param pos The position, which must be at least PATTERN_MIN_DIM squares a side for it to have patterns
+ * @param links The patterns of the position's board size
+ * @param square The square
+ * @param colour The colour of the new disc
+ */
+static inline void placePatternDisc (Position* pos, const PatternLinks* links, int square, int colour)  {
+	for (int l = links->offset[square]; l < links->offset[square+1]; l++)  {
+		pos->pattern[links->link[l].instance] += (colour+1)*links->link[l].power;
+	}
+}
+
+/**
+ * @brief Updates the pattern indices of a position for a disc turned over to a colour
+ *
+ * @param pos The position
+ * @param links The patterns of the position's board size
+ * @param square The square of the disc
+ * @param colour The colour the disc now shows
+ */
+static inline void flipPatternDisc (Position* pos, const PatternLinks* links, int square, int colour)  {
+	//White is digit 2 and black digit 1, so turning a disc white adds one power of 3 and turning it black takes one away
+	const int sign = colour == WHITE ? 1 : -1;
+
+	for (int l = links->offset[square]; l < links->offset[square+1]; l++)  {
+		pos->pattern[links->link[l].instance] += sign*links->link[l].power;
+	}
+}
+
+#endif
@@ -0,0 +1,340 @@
+/**
+ * @file protocol.c
+ * @brief A long-running engine driven by a line-based text protocol on its standard input and output
+ *
+ * The engine is set up once and answers requests for as long as its input stays open, so its transposition table, opening book and search threads stay warm from one game to the next.
+ * Every request is one line, a command followed by its arguments:
+ *
+ *   newgame [size]            start a game from the starting position (default 8 x 8); the table is kept
+ *   setboard squares side     set the position: the squares row by row as B, W or U, then the side to move, B or W
+ *   play move...              play moves on the position, as row and column letters, with "--" for a pass
+ *   go [limits]               search the position; the limits are depth N, movetime MS, nodes N, clock S, inc S, endgame N and infinite, and with none the engine's defaults apply
+ *   stop                      end the current search early; it answers as usual with the best move found so far
+ *   board                     print the position
+ *   stats                     print the searches made, and how the table, book and strong-solve database have been used
+ *   clearhash                 forget every stored result
+ *   isready                   answer readyok, once every earlier request has been read
+ *   quit                      stop any search and exit; at the end of the input, a search still running is finished first
+ *
+ * A search runs on its own thread, so stop, isready and quit are answered while it goes; any other request waits for it to finish. Every search ends with one line:
+ *
+ *   bestmove move score S depth D nodes N time T pv move...
+ *
+ * A request that cannot be carried out is answered with a line starting "error", and changes nothing
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "protocol.h"
+
+//Longest request: setboard with the squares of the largest board, or play with the moves of a whole game
+#define MAX_PROTOCOL_LINE (64 + MAX_SQUARES + 3*MAX_UNDO_MOVES)
+
+//Characters that separate the words of a request
+#define PROTOCOL_SPACE " \t\r\n"
+
+/**
+ * @brief The engine, the position it is given, and the search running on it, if any
+ */
+typedef struct  {
+	ReversiEngine* engine;
+	const SearchLimits* defaults;	//The limits of a search given none
+	FILE* output;
+	pthread_mutex_t outputLock;		//Keeps the lines of the search thread and the reading thread whole
+	Position pos;
+	SearchLimits limits;			//The limits of the current search
+	SearchResult result;
+	pthread_t thread;
+	bool started;					//Whether a search thread has been started and not yet joined
+	bool cancel;					//Set to stop the current search; read and written atomically
+	uint64_t searches;				//Searches answered since the engine started
+	uint64_t nodes;					//Positions visited by those searches
+} ProtocolState;
+
+/**
+ * @brief Writes one line of the answer, keeping it whole against lines from the other thread
+ */
+static void answer (ProtocolState* state, const char* format, const char* text)  {
+	pthread_mutex_lock(&state->outputLock);
+	fprintf(state->output, format, text);
+	fflush(state->output);
+	pthread_mutex_unlock(&state->outputLock);
+}
+
+/**
+ * @brief Searches the position on the search thread and writes the best move once the search is over
+ *
+ * @param argument The protocol's state
+ *
+ * @return NULL
+ */
+static void* searchThread (void* argument)  {
+	ProtocolState* state = (ProtocolState*) argument;
+	SearchResult* result = &state->result;
+	char name[3];
+	int move = reversiSearch(state->engine, &state->pos, &state->limits, result);
+
+	pthread_mutex_lock(&state->outputLock);
+	reversiMoveName(move, state->pos.dim, name);
+	fprintf(state->output, "bestmove %s score %d depth %d nodes %llu time %.3f pv", name, result->score, result->depth, (unsigned long long) result->nodes, result->seconds);
+	for (int i = 0; i < result->pvLength; i++)  {
+		reversiMoveName(result->pv[i], state->pos.dim, name);
+		fprintf(state->output, " %s", name);
+	}
+	fprintf(state->output, "\n");
+	fflush(state->output);
+	state->searches++;
+	state->nodes += result->nodes;
+	pthread_mutex_unlock(&state->outputLock);
+	return NULL;
+}
+
+/**
+ * @brief Waits for the current search, if there is one, to write its answer
+ */
+static void waitForSearch (ProtocolState* state)  {
+	if (state->started)  {
+		pthread_join(state->thread, NULL);
+		state->started = false;
+	}
+}
+
+/**
+ * @brief Reads the limits of a go request, starting from none
+ *
+ * @param state The protocol's state; receives the limits
+ * @param save The rest of the request, for strtok_r
+ *
+ * @return Whether every limit was understood
+ */
+static bool readLimits (ProtocolState* state, char** save)  {
+	SearchLimits* limits = &state->limits;
+	bool given = false;
+
+	memset(limits, 0, sizeof(SearchLimits));
+	limits->endgameEmpties = state->defaults->endgameEmpties;
+	for (char* word = strtok_r(NULL, PROTOCOL_SPACE, save); word != NULL; word = strtok_r(NULL, PROTOCOL_SPACE, save))  {
+		char* value;
+		if (strcmp(word, "infinite") == 0)  {
+			//Deeper than any search goes, so only stop ends it
+			limits->maxDepth = MAX_PLY;
+			given = true;
+			continue;
+		}
+		value = strtok_r(NULL, PROTOCOL_SPACE, save);
+		if (value == NULL)  {
+			return false;
+		}
+		if (strcmp(word, "depth") == 0)  {
+			limits->maxDepth = atoi(value);
+		}
+		else if (strcmp(word, "movetime") == 0)  {
+			limits->moveTime = atof(value) / 1000;
+		}
+		else if (strcmp(word, "nodes") == 0)  {
+			limits->maxNodes = strtoull(value, NULL, 10);
+		}
+		else if (strcmp(word, "clock") == 0)  {
+			limits->clockTime = atof(value) > MIN_CLOCK_TIME ? atof(value) : MIN_CLOCK_TIME;
+		}
+		else if (strcmp(word, "inc") == 0)  {
+			limits->increment = atof(value);
+		}
+		else if (strcmp(word, "endgame") == 0)  {
+			limits->endgameEmpties = atoi(value);
+			continue;
+		}
+		else  {
+			return false;
+		}
+		given = true;
+	}
+	if (!given)  {
+		const SearchLimits* defaults = state->defaults;
+		limits->maxDepth = defaults->maxDepth;
+		limits->moveTime = defaults->moveTime;
+		limits->maxNodes = defaults->maxNodes;
+		limits->clockTime = defaults->clockTime;
+		limits->increment = defaults->increment;
+	}
+	limits->cancel = &state->cancel;
+	return true;
+}
+
+/**
+ * @brief Plays a list of moves on the position, all or none of them
+ *
+ * @param state The protocol's state
+ * @param save The rest of the request, for strtok_r
+ *
+ * @return Whether every move was legal; if one is not, the position is left as it was
+ */
+static bool playMoves (ProtocolState* state, char** save)  {
+	Position pos = state->pos;
+
+	for (char* word = strtok_r(NULL, PROTOCOL_SPACE, save); word != NULL; word = strtok_r(NULL, PROTOCOL_SPACE, save))  {
+		int move = reversiParseMove(word, pos.dim);
+		if (move == NO_MOVE || strlen(word) != 2 || !reversiPlay(&pos, move))  {
+			return false;
+		}
+	}
+	state->pos = pos;
+	return true;
+}
+
+/**
+ * @brief Reads the squares and side to move of a setboard request
+ *
+ * @param state The protocol's state; receives the position
+ * @param save The rest of the request, for strtok_r
+ *
+ * @return Whether the request held a position
+ */
+static bool setBoardRequest (ProtocolState* state, char** save)  {
+	char* squares = strtok_r(NULL, PROTOCOL_SPACE, save);
+	char* side = strtok_r(NULL, PROTOCOL_SPACE, save);
+	int dim = 0;
+
+	if (squares == NULL || side == NULL || side[1] != '\0')  {
+		return false;
+	}
+	//The board size follows from the number of squares
+	while ((size_t) ((dim+1)*(dim+1)) <= strlen(squares))  {
+		dim++;
+	}
+	return reversiSetPosition(&state->pos, dim, squares, side[0]);
+}
+
+/**
+ * @brief Writes how many searches the engine has answered, and how its table, book and strong-solve database have been used
+ */
+static void writeStats (ProtocolState* state)  {
+	TranspositionTable* table = reversiTable(state->engine);
+	BookStats book;
+	SolvedStats solved;
+
+	reversiBookStats(state->engine, &book);
+	reversiSolvedStats(state->engine, &solved);
+	pthread_mutex_lock(&state->outputLock);
+	fprintf(state->output, "stats searches %llu nodes %llu ttprobes %llu tthits %llu ttstores %llu ttfull %.1f bookprobes %llu bookhits %llu solvedprobes %llu solvedhits %llu\n", (unsigned long long) state->searches,
+		(unsigned long long) state->nodes, (unsigned long long) table->stats.probes, (unsigned long long) table->stats.hits, (unsigned long long) table->stats.stores, ttUsage(table)/10.0,
+		(unsigned long long) book.probes, (unsigned long long) book.hits, (unsigned long long) solved.probes, (unsigned long long) solved.hits);
+	fflush(state->output);
+	pthread_mutex_unlock(&state->outputLock);
+}
+
+/**
+ * @brief Carries out every request other than stop, isready and quit, once any search has finished
+ *
+ * @param state The protocol's state
+ * @param command The first word of the request
+ * @param save The rest of the request, for strtok_r
+ */
+static void handleRequest (ProtocolState* state, const char* command, char** save)  {
+	char squares[MAX_SQUARES+1];
+
+	if (strcmp(command, "newgame") == 0)  {
+		char* size = strtok_r(NULL, PROTOCOL_SPACE, save);
+		Position pos;
+		if (reversiNewPosition(&pos, size != NULL ? atoi(size) : PROTOCOL_DEFAULT_DIM))  {
+			state->pos = pos;
+		}
+		else  {
+			answer(state, "error %s: not a board size the engine plays\n", command);
+		}
+	}
+	else if (strcmp(command, "setboard") == 0)  {
+		if (!setBoardRequest(state, save))  {
+			answer(state, "error %s: expected the squares as B, W or U, then the side to move\n", command);
+		}
+	}
+	else if (strcmp(command, "play") == 0)  {
+		if (!playMoves(state, save))  {
+			answer(state, "error %s: not a legal move; no move was played\n", command);
+		}
+	}
+	else if (strcmp(command, "go") == 0)  {
+		if (!readLimits(state, save))  {
+			answer(state, "error %s: expected depth, movetime, nodes, clock, inc or endgame with a number, or infinite\n", command);
+		}
+		else  {
+			state->cancel = false;
+			state->started = pthread_create(&state->thread, NULL, searchThread, state) == 0;
+			if (!state->started)  {
+				answer(state, "error %s: could not start the search\n", command);
+			}
+		}
+	}
+	else if (strcmp(command, "board") == 0)  {
+		reversiPositionString(&state->pos, squares);
+		pthread_mutex_lock(&state->outputLock);
+		fprintf(state->output, "board %s %c\n", squares, colourChar(state->pos.side));
+		fflush(state->output);
+		pthread_mutex_unlock(&state->outputLock);
+	}
+	else if (strcmp(command, "stats") == 0)  {
+		writeStats(state);
+	}
+	else if (strcmp(command, "clearhash") == 0)  {
+		reversiNewGame(state->engine);
+	}
+	else  {
+		answer(state, "error %s: unknown command\n", command);
+	}
+}
+
+/**
+ * @brief Answers requests until quit or the end of the input
+ *
+ * @param engine The engine every search is made with; its table and book are kept from game to game
+ * @param defaults The limits of a search given none
+ * @param input The requests
+ * @param output The answers
+ *
+ * @return The program's exit status
+ */
+int runProtocol (ReversiEngine* engine, const SearchLimits* defaults, FILE* input, FILE* output)  {
+	//Variable declaration
+	static char line[MAX_PROTOCOL_LINE];
+	static ProtocolState state;
+	char* save;
+	char* command;
+
+	state.engine = engine;
+	state.defaults = defaults;
+	state.output = output;
+	state.started = false;
+	pthread_mutex_init(&state.outputLock, NULL);
+	reversiNewPosition(&state.pos, PROTOCOL_DEFAULT_DIM);
+
+	while (fgets(line, sizeof(line), input) != NULL)  {
+		command = strtok_r(line, PROTOCOL_SPACE, &save);
+		if (command == NULL)  {
+			continue;
+		}
+		if (strcmp(command, "quit") == 0)  {
+			__atomic_store_n(&state.cancel, true, __ATOMIC_RELAXED);
+			break;
+		}
+		else if (strcmp(command, "stop") == 0)  {
+			__atomic_store_n(&state.cancel, true, __ATOMIC_RELAXED);
+			waitForSearch(&state);
+		}
+		else if (strcmp(command, "isready") == 0)  {
+			answer(&state, "%s\n", "readyok");
+		}
+		//Every other request changes or reads what the search is using, so it waits for the search to finish
+		else  {
+			waitForSearch(&state);
+			handleRequest(&state, command, &save);
+		}
+	}
+
+	waitForSearch(&state);
+	pthread_mutex_destroy(&state.outputLock);
+	return 0;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file protocol.h
+ * @brief A long-running engine driven by a line-based text protocol on its standard input and output
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdio.h>
+
+#include "reversi.h"
+
+//Board size of a new game when none is given
+#define PROTOCOL_DEFAULT_DIM 8
+
+int runProtocol (ReversiEngine* engine, const SearchLimits* defaults, FILE* input, FILE* output);
+
+#endif
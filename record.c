@@ -0,0 +1,288 @@
+/**
+ * @file record.c
+ * @brief Game records: finished games as their moves, appended to compact binary files and read back, from binary or text files, to be replayed
+ *
+ * A binary record file is a RecordFileHeader followed by its games, each a RecordGameHeader and then its moves: one byte a move on boards of up to 15 x 15, two bytes on larger boards, with
+ * every bit set for a pass. Games are only ever added at the end of a file, each with a single write, so a file can be added to by every run that plays games and read while it grows. A
+ * text record file has one game per line, as self-play writes them with -out:
+ *
+ *   size seed blackDiscs whiteDiscs move move ...
+ *
+ * Files of either kind are read with the same functions, which tell them apart by the first bytes, and every game is replayed on the engine's bitboards, one legal move at a time
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "record.h"
+#include "arena.h"
+
+//First bytes of a binary record file
+static const char recordMagic[4] = {'R', 'V', 'G', 'R'};
+
+//Longest line of a text record: the header, then 3 characters for each move
+#define MAX_RECORD_LINE (64 + 3*MAX_UNDO_MOVES)
+
+//Bytes kept in memory from a record file being read, so a scan of a large file makes few reads
+#define RECORD_BUFFER_BYTES (1 << 20)
+
+/**
+ * @brief Opens a binary record file for adding games at its end, creating it if it does not exist
+ *
+ * @param path The file
+ *
+ * @return The open file, or NULL if it cannot be opened or already holds something other than binary records of this version
+ */
+FILE* recordAppend (const char* path)  {
+	RecordFileHeader header;
+	FILE* file = fopen(path, "a+b");
+	size_t read;
+
+	if (file == NULL)  {
+		return NULL;
+	}
+	//Reads from the start; every write still goes to the end
+	rewind(file);
+	read = fread(&header, 1, sizeof(RecordFileHeader), file);
+	if (read == 0 && feof(file))  {
+		memset(&header, 0, sizeof(RecordFileHeader));
+		memcpy(header.magic, recordMagic, 4);
+		header.version = RECORD_VERSION;
+		if (fwrite(&header, sizeof(RecordFileHeader), 1, file) == 1 && fflush(file) == 0)  {
+			return file;
+		}
+	}
+	else if (read == sizeof(RecordFileHeader) && memcmp(header.magic, recordMagic, 4) == 0 && header.version == RECORD_VERSION)  {
+		return file;
+	}
+	fclose(file);
+	return NULL;
+}
+
+/**
+ * @brief Adds a game at the end of a binary record file
+ *
+ * @param file The file, opened with recordAppend
+ * @param game The game
+ *
+ * @return Whether the game was written
+ */
+bool recordWrite (FILE* file, const GameRecord* game)  {
+	uint8_t bytes[sizeof(RecordGameHeader) + 2*MAX_UNDO_MOVES];
+	RecordGameHeader header;
+	bool wide = game->dim*game->dim > RECORD_BYTE_SQUARES;
+	size_t length = sizeof(RecordGameHeader);
+
+	if (game->dim < REVERSI_MIN_DIM || game->dim > MAX_DIM || game->moveCount < 0 || game->moveCount > MAX_UNDO_MOVES)  {
+		return false;
+	}
+	memset(&header, 0, sizeof(RecordGameHeader));
+	header.seed = game->seed;
+	header.moves = (uint16_t) game->moveCount;
+	header.discs[BLACK] = (uint16_t) game->discs[BLACK];
+	header.discs[WHITE] = (uint16_t) game->discs[WHITE];
+	header.dim = (uint8_t) game->dim;
+	memcpy(bytes, &header, sizeof(RecordGameHeader));
+	for (int i = 0; i < game->moveCount; i++)  {
+		if (wide)  {
+			uint16_t word = game->moves[i] == PASS_MOVE ? RECORD_PASS_WORD : (uint16_t) game->moves[i];
+			memcpy(bytes+length, &word, 2);
+			length += 2;
+		}
+		else  {
+			bytes[length++] = game->moves[i] == PASS_MOVE ? RECORD_PASS_BYTE : (uint8_t) game->moves[i];
+		}
+	}
+	//One write for the whole game, so a file cut short by a crash loses at most its last game
+	return fwrite(bytes, 1, length, file) == length && fflush(file) == 0;
+}
+
+/**
+ * @brief Writes a game as one line of a text record file
+ *
+ * @param file The file
+ * @param game The game
+ */
+void recordWriteText (FILE* file, const GameRecord* game)  {
+	char name[3];
+
+	fprintf(file, "%d %llu %d %d", game->dim, (unsigned long long) game->seed, game->discs[BLACK], game->discs[WHITE]);
+	for (int i = 0; i < game->moveCount; i++)  {
+		reversiMoveName(game->moves[i], game->dim, name);
+		fprintf(file, " %s", name);
+	}
+	fprintf(file, "\n");
+}
+
+/**
+ * @brief Reads a game from one line of a text record file, without replaying it
+ *
+ * @param line The line, which is split up as it is read
+ * @param game Receives the game
+ *
+ * @return Whether the line is a game on a board the engine plays, with every move a square of the board or a pass
+ */
+bool recordParseText (char* line, GameRecord* game)  {
+	char* save;
+	char* token[4];
+
+	for (int i = 0; i < 4; i++)  {
+		token[i] = strtok_r(i == 0 ? line : NULL, " \t\r\n", &save);
+		if (token[i] == NULL)  {
+			return false;
+		}
+	}
+	game->dim = atoi(token[0]);
+	game->seed = strtoull(token[1], NULL, 10);
+	game->discs[BLACK] = atoi(token[2]);
+	game->discs[WHITE] = atoi(token[3]);
+	game->moveCount = 0;
+	if (game->dim < REVERSI_MIN_DIM || game->dim > MAX_DIM || game->discs[BLACK] < 0 || game->discs[WHITE] < 0)  {
+		return false;
+	}
+	for (char* move = strtok_r(NULL, " \t\r\n", &save); move != NULL; move = strtok_r(NULL, " \t\r\n", &save))  {
+		if (game->moveCount == MAX_UNDO_MOVES)  {
+			return false;
+		}
+		game->moves[game->moveCount] = reversiParseMove(move, game->dim);
+		if (game->moves[game->moveCount++] == NO_MOVE)  {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Opens a record file for reading, binary or text
+ *
+ * @param path The file
+ *
+ * @return The reader, or NULL if the file cannot be read or is a binary record file of another version
+ */
+RecordReader* recordOpen (const char* path)  {
+	RecordReader* reader = (RecordReader*) engineMalloc(sizeof(RecordReader));
+	RecordFileHeader header;
+	size_t read;
+
+	if (reader == NULL)  {
+		return NULL;
+	}
+	reader->file = fopen(path, "rb");
+	reader->text = (char*) engineMalloc(MAX_RECORD_LINE);
+	reader->line = 0;
+	if (reader->file == NULL || reader->text == NULL)  {
+		recordClose(reader);
+		return NULL;
+	}
+	setvbuf(reader->file, NULL, _IOFBF, RECORD_BUFFER_BYTES);
+	read = fread(&header, 1, sizeof(RecordFileHeader), reader->file);
+	reader->binary = read == sizeof(RecordFileHeader) && memcmp(header.magic, recordMagic, 4) == 0;
+	if (reader->binary && header.version != RECORD_VERSION)  {
+		recordClose(reader);
+		return NULL;
+	}
+	if (!reader->binary)  {
+		rewind(reader->file);
+	}
+	return reader;
+}
+
+/**
+ * @brief Reads the next game of a record file, without replaying it
+ *
+ * Comments and empty lines of a text file are passed over. A binary game on a board the engine does not play cannot be told apart from a damaged file, so the rest of the file is not read
+ *
+ * @param reader The file
+ * @param game Receives the game
+ *
+ * @return 1 if a game was read, 0 at the end of the file, and -1 if the next line or game is not one the engine can replay
+ */
+int recordRead (RecordReader* reader, GameRecord* game)  {
+	uint8_t moves[2*MAX_UNDO_MOVES];
+	RecordGameHeader header;
+	size_t length;
+	bool wide;
+
+	if (!reader->binary)  {
+		while (fgets(reader->text, MAX_RECORD_LINE, reader->file) != NULL)  {
+			reader->line++;
+			if (reader->text[0] != '#' && strspn(reader->text, " \t\r\n") != strlen(reader->text))  {
+				return recordParseText(reader->text, game) ? 1 : -1;
+			}
+		}
+		return 0;
+	}
+
+	length = fread(&header, 1, sizeof(RecordGameHeader), reader->file);
+	if (length == 0)  {
+		return 0;
+	}
+	if (length != sizeof(RecordGameHeader) || header.dim < REVERSI_MIN_DIM || header.dim > MAX_DIM || header.moves > MAX_UNDO_MOVES)  {
+		fseek(reader->file, 0, SEEK_END);
+		return -1;
+	}
+	wide = header.dim*header.dim > RECORD_BYTE_SQUARES;
+	length = (size_t) header.moves * (wide ? 2 : 1);
+	if (fread(moves, 1, length, reader->file) != length)  {
+		return -1;
+	}
+	game->dim = header.dim;
+	game->seed = header.seed;
+	game->discs[BLACK] = header.discs[BLACK];
+	game->discs[WHITE] = header.discs[WHITE];
+	game->moveCount = header.moves;
+	for (int i = 0; i < game->moveCount; i++)  {
+		if (wide)  {
+			uint16_t word;
+			memcpy(&word, moves + 2*i, 2);
+			game->moves[i] = word == RECORD_PASS_WORD ? PASS_MOVE : word;
+		}
+		else  {
+			game->moves[i] = moves[i] == RECORD_PASS_BYTE ? PASS_MOVE : moves[i];
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Closes a record file opened for reading
+ */
+void recordClose (RecordReader* reader)  {
+	if (reader == NULL)  {
+		return;
+	}
+	if (reader->file != NULL)  {
+		fclose(reader->file);
+	}
+	engineFree(reader->text);
+	engineFree(reader);
+}
+
+/**
+ * @brief Replays a game from the starting position, checking every move and the final count
+ *
+ * @param game The game
+ * @param visit If not NULL, called with every position before its move is played, and with the move
+ * @param context Passed on to visit
+ *
+ * @return 1 if the game was replayed to its end, 0 if a move is not legal or the game does not end with the discs it records, and -1 if visit stopped the replay. Every position is visited
+ *         before the game is known to be legal, so a caller that keeps what it is shown should only keep it once the replay has returned 1
+ */
+int recordReplay (const GameRecord* game, RecordVisitor visit, void* context)  {
+	Position pos;
+
+	if (!reversiNewPosition(&pos, game->dim))  {
+		return 0;
+	}
+	for (int ply = 0; ply < game->moveCount; ply++)  {
+		if (visit != NULL && !visit(&pos, ply, game->moves[ply], context))  {
+			return -1;
+		}
+		if (!reversiPlay(&pos, game->moves[ply]))  {
+			return 0;
+		}
+	}
+	return reversiGameOver(&pos) && reversiDiscs(&pos, BLACK) == game->discs[BLACK] && reversiDiscs(&pos, WHITE) == game->discs[WHITE];
+}
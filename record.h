@@ -0,0 +1,78 @@
+/**
+ * @file record.h
+ * @brief Game records: finished games as their moves, appended to compact binary files and read back, from binary or text files, to be replayed
+ */
+
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "reversi.h"
+
+//Version of the file layout, stored after the magic bytes
+#define RECORD_VERSION 1
+
+//Boards with at most this many squares store each move in one byte, with the byte RECORD_PASS_BYTE for a pass; larger boards store each move in two bytes, with RECORD_PASS_WORD for a pass
+#define RECORD_BYTE_SQUARES 255
+#define RECORD_PASS_BYTE 0xFF
+#define RECORD_PASS_WORD 0xFFFF
+
+/**
+ * @brief The start of a binary record file, followed directly by its games
+ */
+typedef struct  {
+	char magic[4];
+	uint16_t version;
+	uint16_t reserved;
+} RecordFileHeader;
+
+/**
+ * @brief The start of one game in a binary record file, followed directly by its moves
+ *
+ * Stored in the byte order of the machine that wrote it, as the opening book is
+ */
+typedef struct  {
+	uint64_t seed;			//The seed that picked the game's random opening moves; 0 for a game played from the terminal
+	uint16_t moves;			//The number of moves, passes included
+	uint16_t discs[2];		//Final disc count of each colour, indexed by BLACK and WHITE
+	uint8_t dim;			//The size n of the n x n board
+	uint8_t reserved;
+} RecordGameHeader;
+
+/**
+ * @brief One finished game
+ */
+typedef struct  {
+	int dim;
+	uint64_t seed;
+	int discs[2];			//Final disc count of each colour, indexed by BLACK and WHITE
+	int moveCount;
+	int moves[MAX_UNDO_MOVES];	//Every move in order, passes included as PASS_MOVE
+} GameRecord;
+
+/**
+ * @brief A record file being read, one game at a time
+ */
+typedef struct  {
+	FILE* file;
+	bool binary;			//Whether the file is binary; otherwise it holds one game per line, as self-play writes them with -out
+	uint64_t line;			//The number of the last line read from a text file
+	char* text;				//The line being read from a text file
+} RecordReader;
+
+//Called for every position of a replayed game, before its move is played; returning false stops the replay
+typedef bool (*RecordVisitor) (const Position* pos, int ply, int move, void* context);
+
+FILE* recordAppend (const char* path);
+bool recordWrite (FILE* file, const GameRecord* game);
+void recordWriteText (FILE* file, const GameRecord* game);
+bool recordParseText (char* line, GameRecord* game);
+RecordReader* recordOpen (const char* path);
+int recordRead (RecordReader* reader, GameRecord* game);
+void recordClose (RecordReader* reader);
+int recordReplay (const GameRecord* game, RecordVisitor visit, void* context);
+
+#endif
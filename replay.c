@@ -0,0 +1,231 @@
+/**
+ * @file replay.c
+ * @brief Replays game record files, checking every game, and converts them between text and binary
+ *
+ * Every game of every file, binary or text, is replayed move by move from the starting position, and must end with the disc counts it records; the count of games and moves and the moves
+ * replayed per second are printed at the end. The games that replay can also be added to a binary record file, or written out as text
+ *
+ * With -selftest, no files are given: random finished games on boards whose moves take one byte in a binary record and on boards whose moves take two are written to a binary and a text record
+ * file, read back, compared with the games written and replayed
+ *
+ *   replay.exe [-out FILE] [-text] records...
+ *   replay.exe -selftest GAMES
+ *
+ * Exits with status 1 if a file cannot be read or written, or if any game does not replay or, in the self-test, does not come back as it was written
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "reversi.h"
+#include "record.h"
+#include "util.h"
+
+//Boards the self-test plays on: the first two store each move in one byte, the last in two
+static const int selfTestSizes[] = {4, 8, 16};
+
+/**
+ * @brief Plays a game of random legal moves to its end
+ *
+ * @param game Receives the game
+ * @param dim The size n of the n x n board
+ * @param seed The seed that picks the moves; the same seed always gives the same game
+ */
+static void playRandomGame (GameRecord* game, int dim, uint64_t seed)  {
+	int legal[MAX_SQUARES];
+	int legalCount, move;
+	uint64_t random = seed;
+	Position pos;
+
+	reversiNewPosition(&pos, dim);
+	game->dim = dim;
+	game->seed = seed;
+	game->moveCount = 0;
+	while (!reversiGameOver(&pos))  {
+		legalCount = reversiLegalMoves(&pos, legal);
+		move = legalCount == 0 ? PASS_MOVE : legal[nextRandom(&random) % legalCount];
+		reversiPlay(&pos, move);
+		game->moves[game->moveCount++] = move;
+	}
+	game->discs[BLACK] = reversiDiscs(&pos, BLACK);
+	game->discs[WHITE] = reversiDiscs(&pos, WHITE);
+}
+
+/**
+ * @brief Checks whether two records hold the same game
+ */
+static bool sameGame (const GameRecord* a, const GameRecord* b)  {
+	return a->dim == b->dim && a->seed == b->seed && a->discs[BLACK] == b->discs[BLACK] && a->discs[WHITE] == b->discs[WHITE] && a->moveCount == b->moveCount &&
+		memcmp(a->moves, b->moves, a->moveCount*sizeof(int)) == 0;
+}
+
+/**
+ * @brief Reads a record file written by the self-test back, checking every game against the one written
+ *
+ * @param path The file
+ * @param games The number of games written on each board of selfTestSizes; game i of a board has seed i+1
+ *
+ * @return The number of games missing, changed or not replaying, or -1 if the file cannot be read
+ */
+static int checkSelfTestFile (const char* path, int games)  {
+	static GameRecord expected, game;
+	RecordReader* reader = recordOpen(path);
+	int wrong = 0;
+
+	if (reader == NULL)  {
+		return -1;
+	}
+	for (size_t size = 0; size < sizeof(selfTestSizes)/sizeof(selfTestSizes[0]); size++)  {
+		for (int i = 0; i < games; i++)  {
+			playRandomGame(&expected, selfTestSizes[size], (uint64_t) i+1);
+			if (recordRead(reader, &game) != 1 || !sameGame(&game, &expected) || recordReplay(&game, NULL, NULL) != 1)  {
+				fprintf(stderr, "%s: the %d x %d game with seed %d did not come back as written\n", path, selfTestSizes[size], selfTestSizes[size], i+1);
+				wrong++;
+			}
+		}
+	}
+	if (recordRead(reader, &game) != 0)  {
+		fprintf(stderr, "%s: holds more games than were written\n", path);
+		wrong++;
+	}
+	recordClose(reader);
+	return wrong;
+}
+
+/**
+ * @brief Writes random games to a binary and a text record file in the temporary directory, and checks that both give every game back
+ *
+ * @param games The number of games on each board of selfTestSizes
+ *
+ * @return Whether every game came back as it was written
+ */
+static bool selfTest (int games)  {
+	static GameRecord game;
+	char binaryPath[] = "/tmp/replay-binary-XXXXXX", textPath[] = "/tmp/replay-text-XXXXXX";
+	int binaryFile = mkstemp(binaryPath), textFile = mkstemp(textPath), binaryWrong = -1, textWrong = -1;
+	FILE* binary = NULL;
+	FILE* text = NULL;
+	uint64_t moves = 0, passes = 0;
+	bool written = true;
+
+	if (binaryFile >= 0)  {
+		close(binaryFile);
+		binary = recordAppend(binaryPath);
+	}
+	if (textFile >= 0)  {
+		text = fdopen(textFile, "w");
+	}
+	if (binary == NULL || text == NULL)  {
+		fprintf(stderr, "Could not create the record files of the self-test\n");
+		written = false;
+	}
+	for (size_t size = 0; size < sizeof(selfTestSizes)/sizeof(selfTestSizes[0]) && written; size++)  {
+		for (int i = 0; i < games && written; i++)  {
+			playRandomGame(&game, selfTestSizes[size], (uint64_t) i+1);
+			for (int j = 0; j < game.moveCount; j++)  {
+				passes += game.moves[j] == PASS_MOVE;
+			}
+			moves += game.moveCount;
+			written = recordWrite(binary, &game);
+			recordWriteText(text, &game);
+		}
+	}
+	if (binary != NULL && fclose(binary) != 0)  {
+		written = false;
+	}
+	if (text != NULL && fclose(text) != 0)  {
+		written = false;
+	}
+	if (written)  {
+		binaryWrong = checkSelfTestFile(binaryPath, games);
+		textWrong = checkSelfTestFile(textPath, games);
+	}
+	if (binaryFile >= 0)  {
+		unlink(binaryPath);
+	}
+	if (textFile >= 0)  {
+		unlink(textPath);
+	}
+	fprintf(stderr, "selftest games %d on each of", games);
+	for (size_t size = 0; size < sizeof(selfTestSizes)/sizeof(selfTestSizes[0]); size++)  {
+		fprintf(stderr, " %dx%d", selfTestSizes[size], selfTestSizes[size]);
+	}
+	fprintf(stderr, " moves %llu passes %llu wrong binary %d text %d\n", (unsigned long long) moves, (unsigned long long) passes, binaryWrong, textWrong);
+	return written && binaryWrong == 0 && textWrong == 0;
+}
+
+/**
+ * @brief Replays the record files
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	static GameRecord game;
+	const char* outputPath = NULL;
+	bool text = false, read = true;
+	FILE* output = NULL;
+	uint64_t games = 0, moves = 0, invalid = 0;
+	int status, first = 1;
+	double start, seconds;
+
+	for (; first < argc && argv[first][0] == '-'; first++)  {
+		if (strcmp(argv[first], "-out") == 0 && first+1 < argc)  {
+			outputPath = argv[++first];
+		}
+		else if (strcmp(argv[first], "-text") == 0)  {
+			text = true;
+		}
+		else if (strcmp(argv[first], "-selftest") == 0 && first+1 < argc)  {
+			return selfTest(atoi(argv[++first])) ? 0 : 1;
+		}
+	}
+	if (outputPath != NULL)  {
+		output = recordAppend(outputPath);
+		if (output == NULL)  {
+			fprintf(stderr, "Could not add to %s; it must be a binary record file\n", outputPath);
+			return 1;
+		}
+	}
+
+	start = secondsNow();
+	for (int i = first; i < argc && read; i++)  {
+		RecordReader* reader = recordOpen(argv[i]);
+		uint64_t entry = 0;
+		if (reader == NULL)  {
+			fprintf(stderr, "Could not read %s\n", argv[i]);
+			read = false;
+			break;
+		}
+		while ((status = recordRead(reader, &game)) != 0)  {
+			entry++;
+			if (status < 0 || recordReplay(&game, NULL, NULL) != 1)  {
+				invalid++;
+				fprintf(stderr, "%s: game %llu does not replay\n", argv[i], (unsigned long long) entry);
+				continue;
+			}
+			games++;
+			moves += game.moveCount;
+			if (output != NULL && !recordWrite(output, &game))  {
+				fprintf(stderr, "Could not add to %s\n", outputPath);
+				read = false;
+				break;
+			}
+			if (text)  {
+				recordWriteText(stdout, &game);
+			}
+		}
+		recordClose(reader);
+	}
+	seconds = secondsNow() - start;
+
+	if (output != NULL && fclose(output) != 0)  {
+		read = false;
+	}
+	fprintf(stderr, "games %llu moves %llu invalid %llu time %.3fs moves/sec %.0f\n", (unsigned long long) games, (unsigned long long) moves, (unsigned long long) invalid, seconds,
+		seconds > 0 ? moves/seconds : 0.0);
+	return read && invalid == 0 ? 0 : 1;
+}
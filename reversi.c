@@ -0,0 +1,539 @@
+/**
+ * @file reversi.c
+ * @brief The engine as a library: positions, legal moves, playing moves and searching, with no terminal input or output
+ *
+ * An engine owns a transposition table and a search context, both set up once in reversiCreate. Positions belong to the caller and are plain values, so any number of games can be played with one
+ * engine, one after another. Before searching, an engine looks a position up in its strong-solve database and then in its opening book, if it has them, and plays the move it finds there
+ *
+ * While the opponent thinks, an engine can ponder: it guesses the reply, and searches the position after it on a thread of its own. The next search picks the ponder up if the guess was right, and
+ * cancels it otherwise
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "reversi.h"
+#include "arena.h"
+#include "pattern.h"
+#include "util.h"
+
+struct ReversiEngine  {
+	TranspositionTable* tt;
+	EvalWeights* weights;
+	SearchContext* search;
+	OpeningBook* book;		//NULL without a book
+	BookStats bookStats;
+	SolvedDatabase* solved;	//NULL without a strong-solve database
+	SolvedStats solvedStats;
+	pthread_t ponderThread;
+	pthread_mutex_t ponderLock;
+	pthread_cond_t ponderFinished;	//Signalled when the ponder search returns
+	bool pondering;			//Whether a ponder thread has been started and not yet joined
+	bool ponderDone;		//Whether the ponder search has returned
+	bool ponderCancel;		//Stops the ponder search
+	Position ponderPos;		//The position pondered on: the position the ponder began from, after the expected reply
+	SearchLimits ponderLimits;
+	SearchResult ponderResult;
+	double ponderStart;		//When the ponder search started
+	PonderStats ponderStats;
+};
+
+/**
+ * @brief Sets up an engine
+ *
+ * @param config The size of the transposition table, the number of threads and the files of evaluation weights, of the opening book and of the strong-solve database; NULL for the defaults
+ *
+ * @return The engine, or NULL if its table or threads could not be set up, or its weights, book or database could not be read
+ */
+ReversiEngine* reversiCreate (const ReversiConfig* config)  {
+	size_t megabytes = config != NULL && config->hashMegabytes > 0 ? config->hashMegabytes : REVERSI_DEFAULT_HASH_MEGABYTES;
+	int threads = config != NULL && config->threads > 0 ? config->threads : 1;
+	ReversiEngine* engine = (ReversiEngine*) engineMalloc(sizeof(ReversiEngine));
+	pthread_condattr_t attributes;
+
+	if (engine == NULL)  {
+		return NULL;
+	}
+	//The ponder's deadline is read from the monotonic clock, so the condition waits on it too
+	pthread_mutex_init(&engine->ponderLock, NULL);
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&engine->ponderFinished, &attributes);
+	pthread_condattr_destroy(&attributes);
+	engine->pondering = false;
+	memset(&engine->ponderStats, 0, sizeof(PonderStats));
+	engine->tt = ttCreate(megabytes);
+	engine->weights = (EvalWeights*) engineMalloc(sizeof(EvalWeights));
+	engine->search = NULL;
+	engine->book = config != NULL && config->bookPath != NULL ? bookOpen(config->bookPath) : NULL;
+	memset(&engine->bookStats, 0, sizeof(BookStats));
+	engine->solved = config != NULL && config->solvedPath != NULL ? solvedOpen(config->solvedPath) : NULL;
+	memset(&engine->solvedStats, 0, sizeof(SolvedStats));
+	if (engine->weights != NULL)  {
+		evalDefaultWeights(engine->weights);
+		if (config == NULL || config->weightsPath == NULL || evalLoadWeights(engine->weights, config->weightsPath))  {
+			engine->search = engine->tt != NULL ? searchContextCreate(threads, engine->tt, engine->weights) : NULL;
+		}
+	}
+	if (engine->search == NULL || (config != NULL && config->bookPath != NULL && engine->book == NULL) || (config != NULL && config->solvedPath != NULL && engine->solved == NULL))  {
+		reversiFree(engine);
+		return NULL;
+	}
+	return engine;
+}
+
+/**
+ * @brief Stops an engine's threads and frees everything it set up
+ */
+void reversiFree (ReversiEngine* engine)  {
+	if (engine == NULL)  {
+		return;
+	}
+	reversiStopPondering(engine);
+	pthread_mutex_destroy(&engine->ponderLock);
+	pthread_cond_destroy(&engine->ponderFinished);
+	if (engine->search != NULL)  {
+		searchContextFree(engine->search);
+	}
+	if (engine->tt != NULL)  {
+		ttFree(engine->tt);
+	}
+	if (engine->weights != NULL)  {
+		engineFree(engine->weights);
+	}
+	bookClose(engine->book);
+	solvedClose(engine->solved);
+	engineFree(engine);
+}
+
+/**
+ * @brief Forgets every stored result, so a game searches exactly as it would on a freshly created engine
+ */
+void reversiNewGame (ReversiEngine* engine)  {
+	reversiStopPondering(engine);
+	searchContextClear(engine->search);
+}
+
+/**
+ * @brief The transposition table an engine searches with, for reporting how it was used
+ */
+TranspositionTable* reversiTable (const ReversiEngine* engine)  {
+	return engine->tt;
+}
+
+/**
+ * @brief How often an engine's searches found their move in its opening book
+ */
+void reversiBookStats (const ReversiEngine* engine, BookStats* stats)  {
+	*stats = engine->bookStats;
+}
+
+/**
+ * @brief How often an engine's searches found their move in its strong-solve database
+ */
+void reversiSolvedStats (const ReversiEngine* engine, SolvedStats* stats)  {
+	*stats = engine->solvedStats;
+}
+
+/**
+ * @brief Sets up the starting position of a game
+ *
+ * @param pos The position being set up
+ * @param dim The size n of the n x n board
+ *
+ * @return Whether the board size is one the engine can play on
+ */
+bool reversiNewPosition (Position* pos, int dim)  {
+	if (dim < REVERSI_MIN_DIM || dim > MAX_DIM)  {
+		return false;
+	}
+	positionInit(pos, dim);
+	return true;
+}
+
+/**
+ * @brief Sets up a position from a row by row list of its squares
+ *
+ * @param pos The position being set up
+ * @param dim The size n of the n x n board
+ * @param squares The n*n squares, row by row, each 'B', 'W' or 'U' as on the game board
+ * @param colour The colour to move, 'B' or 'W'
+ *
+ * @return Whether the board size and every square are valid; the position is only set up if they are
+ */
+bool reversiSetPosition (Position* pos, int dim, const char* squares, char colour)  {
+	if (dim < REVERSI_MIN_DIM || dim > MAX_DIM || (colour != 'B' && colour != 'W') || strlen(squares) != (size_t) (dim*dim))  {
+		return false;
+	}
+	for (int i = 0; i < dim*dim; i++)  {
+		if (squares[i] != 'B' && squares[i] != 'W' && squares[i] != 'U')  {
+			return false;
+		}
+	}
+	positionInit(pos, dim);
+	clearBitboard(&pos->disc[BLACK]);
+	clearBitboard(&pos->disc[WHITE]);
+	for (int i = 0; i < dim*dim; i++)  {
+		if (squares[i] != 'U')  {
+			setSquare(&pos->disc[colourIndex(squares[i])], i);
+		}
+	}
+	pos->side = colourIndex(colour);
+	pos->hash = computeHash(pos);
+	computePatternIndices(pos);
+	return true;
+}
+
+/**
+ * @brief Writes a position's squares row by row, in the form reversiSetPosition reads
+ *
+ * @param pos The position
+ * @param squares Receives the n*n squares and a terminating null; must have room for MAX_SQUARES+1 characters
+ */
+void reversiPositionString (const Position* pos, char* squares)  {
+	int count = pos->dim*pos->dim;
+
+	for (int i = 0; i < count; i++)  {
+		squares[i] = testSquare(&pos->disc[BLACK], i) ? 'B' : testSquare(&pos->disc[WHITE], i) ? 'W' : 'U';
+	}
+	squares[count] = '\0';
+}
+
+/**
+ * @brief Lists the legal moves of the side to move
+ *
+ * @param pos The position
+ * @param moves If not NULL, receives the squares of the legal moves from Northwest to Southeast; must have room for MAX_SQUARES moves
+ *
+ * @return The number of legal moves; 0 if the side to move has to pass, or the game is over
+ */
+int reversiLegalMoves (const Position* pos, int* moves)  {
+	Bitboard mask;
+	int count = 0;
+
+	generateMoves(pos, pos->side, &mask);
+	if (moves == NULL)  {
+		return countSquares(&mask, pos->words);
+	}
+	for (int square = popSquare(&mask, pos->words); square != -1; square = popSquare(&mask, pos->words))  {
+		moves[count++] = square;
+	}
+	return count;
+}
+
+/**
+ * @brief Plays a move for the side to move
+ *
+ * @param pos The position the move is played on; left unchanged if the move is not legal
+ * @param move The square of the move, or PASS_MOVE, which is only legal when the side to move has no legal move and the game is not over
+ *
+ * @return Whether the move was legal and has been played
+ */
+bool reversiPlay (Position* pos, int move)  {
+	Bitboard flips;
+	LegalMoves legal;
+
+	if (move == PASS_MOVE)  {
+		generateLegalMoves(pos, &legal);
+		if (legal.count[pos->side] > 0 || legal.count[1-pos->side] == 0)  {
+			return false;
+		}
+	}
+	else  {
+		if (move < 0 || move >= pos->dim*pos->dim || computeFlips(pos, pos->side, move, &flips, NULL) == 0)  {
+			return false;
+		}
+		applyMove(pos, pos->side, move, &flips);
+	}
+	passTurn(pos);
+	return true;
+}
+
+/**
+ * @brief Checks whether neither side has a legal move
+ */
+bool reversiGameOver (const Position* pos)  {
+	LegalMoves legal;
+	generateLegalMoves(pos, &legal);
+	return legal.count[BLACK] == 0 && legal.count[WHITE] == 0;
+}
+
+/**
+ * @brief Counts the discs of one colour
+ *
+ * @param pos The position
+ * @param colour BLACK or WHITE
+ */
+int reversiDiscs (const Position* pos, int colour)  {
+	return countSquares(&pos->disc[colour], pos->words);
+}
+
+/**
+ * @brief Picks how many moves deep to search on a board when no depth is given
+ *
+ * Larger boards have many more moves to choose from in every position, so they are searched less deeply to keep each move quick
+ *
+ * @param dim The size n of the n x n board
+ *
+ * @return The depth, in moves
+ */
+int reversiDefaultDepth (int dim)  {
+	if (dim <= 8)  {
+		return 8;
+	}
+	else if (dim <= 12)  {
+		return 6;
+	}
+	return 4;
+}
+
+/**
+ * @brief Runs the ponder search on its own thread, and signals when it returns
+ */
+static void* ponderThread (void* argument)  {
+	ReversiEngine* engine = (ReversiEngine*) argument;
+	Position root = engine->ponderPos;
+
+	searchPosition(engine->search, &root, &engine->ponderLimits, &engine->ponderResult);
+	pthread_mutex_lock(&engine->ponderLock);
+	engine->ponderDone = true;
+	pthread_cond_signal(&engine->ponderFinished);
+	pthread_mutex_unlock(&engine->ponderLock);
+	return NULL;
+}
+
+/**
+ * @brief Guesses the opponent's reply: the best move the transposition table holds for the position, which the engine's own last search will usually have stored, or else its first legal move
+ */
+static int expectedReply (ReversiEngine* engine, const Position* pos)  {
+	int moves[MAX_SQUARES];
+	Bitboard flips;
+	TTData data;
+	TTStats stats;
+
+	memset(&stats, 0, sizeof(TTStats));
+	if (ttProbe(engine->tt, pos->hash, &data, &stats) && data.move >= 0 && data.move < pos->dim*pos->dim && computeFlips(pos, pos->side, data.move, &flips, NULL) != 0)  {
+		return data.move;
+	}
+	return reversiLegalMoves(pos, moves) > 0 ? moves[0] : PASS_MOVE;
+}
+
+/**
+ * @brief Starts searching, in the background, the position the engine expects to be given next
+ *
+ * Plays the opponent's expected reply and searches the engine's own move after it, with the depth and node limits given but no time limit, until the next reversiSearch or reversiStopPondering.
+ * Nothing is started if the opponent has no move, if the engine would have no move after the reply, or if the strong-solve database or the opening book already holds one. The engine must not be used for anything else until
+ * the ponder is picked up or stopped
+ *
+ * @param engine The engine
+ * @param pos The position with the opponent to move
+ * @param limits The limits the engine's next search will be given
+ *
+ * @return Whether a ponder search was started
+ */
+bool reversiPonder (ReversiEngine* engine, const Position* pos, const SearchLimits* limits)  {
+	Position next = *pos;
+	int move, score;
+
+	reversiStopPondering(engine);
+	move = expectedReply(engine, pos);
+	if (move == PASS_MOVE || !reversiPlay(&next, move) || reversiLegalMoves(&next, NULL) == 0)  {
+		return false;
+	}
+	if ((engine->solved != NULL && solvedLookup(engine->solved, &next, &move, &score)) || (engine->book != NULL && bookLookup(engine->book, &next, &move, &score)))  {
+		return false;
+	}
+
+	engine->ponderPos = next;
+	engine->ponderLimits = *limits;
+	//A search with only a time limit ponders until it is picked up
+	engine->ponderLimits.moveTime = 0;
+	engine->ponderLimits.clockTime = 0;
+	engine->ponderLimits.increment = 0;
+	engine->ponderLimits.cancel = &engine->ponderCancel;
+	//With no limit at all, pondering stops at the default depth
+	if (limits->maxDepth <= 0 && limits->moveTime <= 0 && limits->clockTime <= 0 && limits->maxNodes == 0)  {
+		engine->ponderLimits.maxDepth = reversiDefaultDepth(next.dim);
+	}
+	engine->ponderDone = false;
+	engine->ponderCancel = false;
+	engine->ponderStart = secondsNow();
+	if (pthread_create(&engine->ponderThread, NULL, ponderThread, engine) != 0)  {
+		return false;
+	}
+	engine->pondering = true;
+	engine->ponderStats.ponders++;
+	return true;
+}
+
+/**
+ * @brief Cancels the engine's ponder search, if it has one, and waits for its thread to finish
+ */
+void reversiStopPondering (ReversiEngine* engine)  {
+	if (!engine->pondering)  {
+		return;
+	}
+	__atomic_store_n(&engine->ponderCancel, true, __ATOMIC_RELAXED);
+	pthread_join(engine->ponderThread, NULL);
+	engine->pondering = false;
+}
+
+/**
+ * @brief Finishes a ponder search that was searching the position the engine has now been given
+ *
+ * The search is given the move's share of time as if it had started when the ponder did, so a ponder that has already run that long answers at once; otherwise it stops there unless it finishes
+ * first. Depth and node limits were already set on it
+ *
+ * @return Whether the ponder found a move
+ */
+static bool finishPonder (ReversiEngine* engine, const Position* pos, const SearchLimits* limits, SearchResult* result)  {
+	double start = secondsNow(), soft, hard;
+	struct timespec until;
+
+	searchPlanTime(limits, pos, engine->ponderStart, &soft, &hard);
+	until.tv_sec = (time_t) soft;
+	until.tv_nsec = (long) ((soft - (double) until.tv_sec)*1e9);
+	pthread_mutex_lock(&engine->ponderLock);
+	while (!engine->ponderDone)  {
+		if (soft <= 0)  {
+			pthread_cond_wait(&engine->ponderFinished, &engine->ponderLock);
+		}
+		else if (pthread_cond_timedwait(&engine->ponderFinished, &engine->ponderLock, &until) != 0 && secondsNow() >= soft)  {
+			break;
+		}
+	}
+	pthread_mutex_unlock(&engine->ponderLock);
+	reversiStopPondering(engine);
+
+	if (engine->ponderResult.move == PASS_MOVE)  {
+		return false;
+	}
+	*result = engine->ponderResult;
+	result->seconds = secondsNow() - start;
+	result->ponderHit = true;
+	engine->ponderStats.hits++;
+	return true;
+}
+
+/**
+ * @brief How often an engine pondered, and how often it had pondered on the position it was then given
+ */
+void reversiPonderStats (const ReversiEngine* engine, PonderStats* stats)  {
+	*stats = engine->ponderStats;
+}
+
+/**
+ * @brief Searches for the best move of the side to move
+ *
+ * @param engine The engine to search with; results stored by earlier searches are reused
+ * @param pos The position being searched; it is left unchanged
+ * @param limits How far the search may go; with no depth, time or node limit at all, it goes to reversiDefaultDepth of the board size
+ * @param result Receives everything the search found
+ *
+ * @return The best move, or PASS_MOVE if the side to move has no legal move; a finished game is not searched, nor is a position the engine's strong-solve database or opening book has a move
+ *         for, and a side that has to pass is searched from the position after its pass.
+ *         If the engine was pondering on this position, the ponder search is carried on instead of starting a new one; any other ponder is cancelled
+ */
+int reversiSearch (ReversiEngine* engine, const Position* pos, const SearchLimits* limits, SearchResult* result)  {
+	Position root = *pos;
+	SearchLimits bounded = *limits;
+	int move, score;
+
+	if (engine->pondering)  {
+		if (pos->hash == engine->ponderPos.hash && pos->dim == engine->ponderPos.dim && pos->side == engine->ponderPos.side && finishPonder(engine, pos, limits, result))  {
+			return result->move;
+		}
+		reversiStopPondering(engine);
+	}
+	//A finished game is scored by its discs; a side that has to pass is given the opponent's score after the pass, found by searching that position
+	if (reversiLegalMoves(pos, NULL) == 0)  {
+		if (reversiGameOver(pos))  {
+			memset(result, 0, sizeof(SearchResult));
+			result->score = terminalScore(pos);
+		}
+		else  {
+			passTurn(&root);
+			reversiSearch(engine, &root, limits, result);
+			result->score = -result->score;
+			result->pvLength -= result->pvLength == MAX_PLY;
+			memmove(result->pv+1, result->pv, result->pvLength*sizeof(int));
+			result->pv[0] = PASS_MOVE;
+			result->pvLength++;
+		}
+		result->move = PASS_MOVE;
+		return PASS_MOVE;
+	}
+	//A solved position's move and result are exact, so the database is asked before the book
+	if (engine->solved != NULL && pos->dim <= SOLVED_MAX_DIM)  {
+		engine->solvedStats.probes++;
+		if (solvedLookup(engine->solved, pos, &move, &score))  {
+			engine->solvedStats.hits++;
+			memset(result, 0, sizeof(SearchResult));
+			result->move = move;
+			result->score = scoreFromDifference(score);
+			result->solvedMove = true;
+			result->pvLength = 1;
+			result->pv[0] = move;
+			return move;
+		}
+	}
+	if (engine->book != NULL)  {
+		engine->bookStats.probes++;
+		if (bookLookup(engine->book, pos, &move, &score))  {
+			engine->bookStats.hits++;
+			memset(result, 0, sizeof(SearchResult));
+			result->move = move;
+			result->score = score*EVAL_SCALE;
+			result->bookMove = true;
+			result->pvLength = 1;
+			result->pv[0] = move;
+			return move;
+		}
+	}
+	if (bounded.maxDepth <= 0 && bounded.moveTime <= 0 && bounded.clockTime <= 0 && bounded.maxNodes == 0)  {
+		bounded.maxDepth = reversiDefaultDepth(pos->dim);
+	}
+	searchPosition(engine->search, &root, &bounded, result);
+	return result->move;
+}
+
+/**
+ * @brief Writes a move as its row and column letters, as the game takes it as input
+ *
+ * @param move The square of the move, or PASS_MOVE, which is written as "--"
+ * @param dim The size n of the n x n board
+ * @param name Receives the two letters and a terminating null
+ */
+void reversiMoveName (int move, int dim, char* name)  {
+	if (move == PASS_MOVE)  {
+		name[0] = '-';
+		name[1] = '-';
+	}
+	else  {
+		name[0] = move/dim+'a';
+		name[1] = move%dim+'a';
+	}
+	name[2] = '\0';
+}
+
+/**
+ * @brief Reads a move written by reversiMoveName
+ *
+ * @param name The row and column letters, or "--" for a pass
+ * @param dim The size n of the n x n board
+ *
+ * @return The square of the move, PASS_MOVE, or NO_MOVE if the name is not a square of the board
+ */
+int reversiParseMove (const char* name, int dim)  {
+	if (name[0] == '-' && name[1] == '-')  {
+		return PASS_MOVE;
+	}
+	if (name[0] < 'a' || name[0] >= 'a'+dim || name[1] < 'a' || name[1] >= 'a'+dim)  {
+		return NO_MOVE;
+	}
+	return (name[0]-'a')*dim + name[1]-'a';
+}
@@ -0,0 +1,73 @@
+/**
+ * @file reversi.h
+ * @brief The engine as a library: positions, legal moves, playing moves and searching, with no terminal input or output
+ *
+ * Everything the interactive game and the headless modes need goes through these functions, so a program can play or analyse any number of games without touching the board arrays of game_ai.c
+ */
+
+#ifndef REVERSI_H
+#define REVERSI_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bitboard.h"
+#include "search.h"
+#include "tt.h"
+#include "book.h"
+#include "solved.h"
+
+//Size of the transposition table, in megabytes, when the configuration does not give one
+#define REVERSI_DEFAULT_HASH_MEGABYTES 64
+
+//Smallest board that has a centre to start from
+#define REVERSI_MIN_DIM 2
+
+/**
+ * @brief How an engine is set up
+ */
+typedef struct  {
+	size_t hashMegabytes;	//Size of the transposition table; 0 for the default
+	int threads;			//Threads each search uses; 0 for 1
+	const char* weightsPath;	//File of evaluation weights written by the trainer; NULL for the hand-set weights
+	const char* bookPath;		//Opening book written by the book builder; NULL to search every move
+	const char* solvedPath;		//Strong-solve database written by solvedb; NULL to search every move
+} ReversiConfig;
+
+/**
+ * @brief How often an engine pondered during its opponent's turns, and how often the opponent then played the reply it pondered on
+ */
+typedef struct  {
+	uint64_t ponders;		//Ponder searches started
+	uint64_t hits;			//Searches answered by carrying on a ponder search
+} PonderStats;
+
+//A transposition table and the search threads and memory that use it; set up once and reused for every search
+typedef struct ReversiEngine ReversiEngine;
+
+ReversiEngine* reversiCreate (const ReversiConfig* config);
+void reversiFree (ReversiEngine* engine);
+void reversiNewGame (ReversiEngine* engine);
+TranspositionTable* reversiTable (const ReversiEngine* engine);
+void reversiBookStats (const ReversiEngine* engine, BookStats* stats);
+void reversiSolvedStats (const ReversiEngine* engine, SolvedStats* stats);
+bool reversiPonder (ReversiEngine* engine, const Position* pos, const SearchLimits* limits);
+void reversiStopPondering (ReversiEngine* engine);
+void reversiPonderStats (const ReversiEngine* engine, PonderStats* stats);
+
+bool reversiNewPosition (Position* pos, int dim);
+bool reversiSetPosition (Position* pos, int dim, const char* squares, char colour);
+void reversiPositionString (const Position* pos, char* squares);
+int reversiLegalMoves (const Position* pos, int* moves);
+bool reversiPlay (Position* pos, int move);
+bool reversiGameOver (const Position* pos);
+int reversiDiscs (const Position* pos, int colour);
+
+int reversiDefaultDepth (int dim);
+int reversiSearch (ReversiEngine* engine, const Position* pos, const SearchLimits* limits, SearchResult* result);
+
+void reversiMoveName (int move, int dim, char* name);
+int reversiParseMove (const char* name, int dim);
+
+#endif
@@ -0,0 +1,847 @@
+/**
+ * @file search.c
+ * @brief Alpha-beta negamax search with iterative deepening
+ *
+ * Each iteration searches one move deeper than the last. The principal variation of the previous iteration is searched first at every node along it, which is usually the best line again, so
+ * alpha-beta can cut off most of the remaining moves as soon as possible. Away from the principal variation, the moves are ordered by order.c, with the best move stored in the transposition table
+ * first, and a stored score that is deep enough ends the search of a position without searching it again. Where much depth is left and the table holds no move, every move is first searched to a
+ * fraction of that depth, and the moves are ordered by those scores instead
+ *
+ * With more than one thread the search runs as Lazy SMP: every helper thread runs the same iterative deepening on its own copy of the position, sharing only the transposition table. Helpers start
+ * at alternating depths and try the root moves in a rotated order, so they fill the table with results the main thread has not reached yet. The main thread's result is the one returned, and the
+ * helpers are stopped as soon as it finishes
+ *
+ * The helper threads and all of the memory every thread searches with are set up once, in searchContextCreate. Each thread takes its position, undo stack and move lists from its own arena, which is
+ * reset at the start of every search, so a search makes no heap allocations at all
+ *
+ * Built with ENGINE_STATS defined, every thread also counts what it does, from move generations and evaluations to cutoffs and the nodes and time of each iteration, and the counts are added up
+ * into the result; without it, the counting is not compiled in at all
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "search.h"
+#include "eval.h"
+#include "endgame.h"
+#include "arena.h"
+#include "order.h"
+#include "util.h"
+
+//Depth stored with results the endgame solver found exactly; deeper than any search, so they always settle the position
+#define SOLVED_DEPTH 255
+
+//Remaining depth at or above which the moves of a position with no table move are ordered by a shallow search of each; below it the static ordering does as well for less
+#define SHALLOW_ORDER_DEPTH 8
+//The shallow search goes this fraction of the remaining depth
+#define SHALLOW_ORDER_DIVISOR 2
+
+//Nodes the main thread visits between checks of its clock and node limit
+#define POLL_NODES 256
+//Seconds kept back from every time limit for waking and stopping the threads and returning the move
+#define MOVE_OVERHEAD 0.002
+//Fewest moves a clock is shared between, so the last moves of a game are not given the whole clock
+#define MIN_MOVES_TO_GO 4
+//Most of the remaining clock one move may use
+#define MAX_CLOCK_FRACTION 0.4
+//A move may run this many times over its share of the clock when an iteration is still going
+#define HARD_LIMIT_FACTOR 3.0
+//No new iteration is started once this fraction of a move's share of the time has passed; the next one would rarely finish
+#define SOFT_LIMIT_FRACTION 0.5
+
+/**
+ * @brief The state of one search
+ */
+typedef struct  {
+	int thread;						//0 for the main thread, which reports the result; 1 and up for helpers
+	bool* stop;						//Set once the search must finish; the thread then unwinds without using any result in progress
+	bool aborted;					//Whether this thread has seen the stop flag
+	double deadline;				//Monotonic time at which the main thread stops the search; 0 for none, as for every helper
+	double softDeadline;			//Monotonic time after which the main thread starts no new iteration; 0 for none
+	uint64_t maxNodes;				//Nodes after which the main thread stops the search; 0 for no limit
+	const bool* cancel;				//Stops the search once another thread sets it; NULL for none, as for every helper
+	uint64_t nextPoll;				//Node count at which the deadline and node limit are next checked
+	int rootCount;					//The number of legal moves at the root, found by the first iteration
+	int rootBest;					//The best score among the root moves searched so far in the current iteration
+	Position* pos;					//The position being searched; every move made on it is taken back
+	UndoStack* undo;				//The moves made on the position between the root and the current node
+	int (*moveLists)[MAX_SQUARES];	//One list of moves for each ply
+	TranspositionTable* tt;			//Results shared between iterations, and between positions reached by different move orders; may be NULL
+	const EvalWeights* weights;		//The weights positions are evaluated with
+	int endgameEmpties;				//Most empty squares a position can have and still be solved exactly
+	bool solving;					//Whether the root has at most endgameEmpties empty squares, so every move is solved exactly
+	EndgameSolver endgame;
+	MoveOrdering ordering;			//The thread's killer moves and history
+	TTStats ttStats;
+	uint64_t nodes;					//The number of positions visited
+#ifdef ENGINE_STATS
+	SearchStats stats;
+#endif
+	bool followPv;					//Whether the current node lies on the previous iteration's principal variation
+	int previousPvLength;
+	int previousPv[MAX_PLY];		//The principal variation of the last completed iteration
+	int pvLength[MAX_PLY];
+	int pv[MAX_PLY][MAX_PLY];		//Triangular table; row ply holds the best line found from the node at that ply
+} Searcher;
+
+/**
+ * @brief Checks the main thread's deadline, node limit and cancel flag every POLL_NODES nodes, and stops every thread once any of them is reached
+ */
+static inline void pollLimits (Searcher* s)  {
+	if (s->nodes >= s->nextPoll)  {
+		s->nextPoll = s->nodes + POLL_NODES;
+		if ((s->maxNodes > 0 && s->nodes >= s->maxNodes) || (s->deadline > 0 && secondsNow() >= s->deadline) || (s->cancel != NULL && __atomic_load_n(s->cancel, __ATOMIC_RELAXED)))  {
+			__atomic_store_n(s->stop, true, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/**
+ * @brief Scores a finished game
+ *
+ * @param pos The position at the end of the game
+ *
+ * @return SCORE_WIN plus the disc differential if the side to move won, minus SCORE_WIN plus the differential if it lost, and 0 for a draw
+ */
+int terminalScore (const Position* pos)  {
+	return scoreFromDifference(countSquares(&pos->disc[pos->side], pos->words) - countSquares(&pos->disc[1-pos->side], pos->words));
+}
+
+/**
+ * @brief Converts the final disc differential of a game into a score
+ *
+ * @param difference The final disc differential for the side to move
+ *
+ * @return SCORE_WIN plus the differential for a win, minus SCORE_WIN plus the differential for a loss, and 0 for a draw
+ */
+int scoreFromDifference (int difference)  {
+	if (difference > 0)  {
+		return SCORE_WIN + difference;
+	}
+	else if (difference < 0)  {
+		return -SCORE_WIN + difference;
+	}
+	return 0;
+}
+
+/**
+ * @brief Solves a position exactly with the endgame solver, converting the search window into disc differentials and the result back into a score
+ *
+ * The window is narrowed to the differentials whose scores fall inside it, so the solver cuts off exactly where the search would
+ *
+ * @param s The state of the search
+ * @param alpha The score the side to move is already guaranteed elsewhere
+ * @param beta The score the opponent is already guaranteed elsewhere
+ * @param passed Whether the previous move was a pass
+ *
+ * @return The score of the position for the side to move, or a bound on it outside the window
+ */
+static int solveExactly (Searcher* s, int alpha, int beta, bool passed)  {
+	//The largest differential scoring at most alpha, and the smallest scoring at least beta
+	int low = alpha >= SCORE_WIN ? alpha-SCORE_WIN : alpha >= 0 ? 0 : (alpha+SCORE_WIN < -1 ? alpha+SCORE_WIN : -1);
+	int high = beta <= -SCORE_WIN ? beta+SCORE_WIN : beta <= 0 ? 0 : (beta-SCORE_WIN > 1 ? beta-SCORE_WIN : 1);
+	int difference;
+
+	//The solver polls the same limits itself, counting its nodes from 0
+	s->endgame.nodes = 0;
+	s->endgame.deadline = s->deadline;
+	s->endgame.cancel = s->cancel;
+	s->endgame.maxNodes = s->maxNodes > 0 ? (s->maxNodes > s->nodes ? s->maxNodes - s->nodes : 1) : 0;
+	difference = solveEndgame(&s->endgame, low, high, passed);
+	s->nodes += s->endgame.nodes;
+	STAT(s->stats.endgameSolves++; s->stats.endgameNodes += s->endgame.nodes);
+	if (s->endgame.aborted)  {
+		s->aborted = true;
+		return 0;
+	}
+	return scoreFromDifference(difference);
+}
+
+/**
+ * @brief Stores a move followed by the best line from the node below it as the best line of the current node
+ */
+static void updatePv (Searcher* s, int ply, int move)  {
+	s->pv[ply][ply] = move;
+	for (int i = ply+1; i < s->pvLength[ply+1]; i++)  {
+		s->pv[ply][i] = s->pv[ply+1][i];
+	}
+	s->pvLength[ply] = s->pvLength[ply+1] > ply+1 ? s->pvLength[ply+1] : ply+1;
+}
+
+/**
+ * @brief Rotates a list of moves in place so that it starts from a given index
+ */
+static void rotateMoves (int* moves, int count, int shift)  {
+	//Three reversals rotate the list without any extra memory
+	for (int part = 0; part < 3; part++)  {
+		int low = part == 1 ? shift : 0, high = part == 0 ? shift-1 : count-1;
+		while (low < high)  {
+			int swap = moves[low];
+			moves[low++] = moves[high];
+			moves[high--] = swap;
+		}
+	}
+}
+
+static int negamax (Searcher* s, int depth, int ply, int alpha, int beta, bool passed);
+
+/**
+ * @brief Orders the moves of a position with much depth left and no table move by a shallow search of each
+ *
+ * The shallow searches store their results in the table like any other, so the full search of each move then starts with a table move below it as well
+ *
+ * @param s The state of the search
+ * @param moves The legal moves, sorted in place
+ * @param count The number of moves
+ * @param depth The depth left to search below the position
+ * @param ply The number of moves made since the root
+ */
+static void shallowOrder (Searcher* s, int* moves, int count, int depth, int ply)  {
+	int keys[MAX_SQUARES];
+	bool followPv = s->followPv;
+
+	s->followPv = false;
+	for (int i = 0; i < count && !s->aborted; i++)  {
+		makeMove(s->pos, moves[i], s->undo);
+		keys[i] = -negamax(s, depth/SHALLOW_ORDER_DIVISOR, ply+1, -SCORE_INFINITY, SCORE_INFINITY, false);
+		unmakeMove(s->pos, s->undo);
+	}
+	s->followPv = followPv;
+	//An aborted search leaves some moves without a key, and its caller discards the position anyway
+	if (!s->aborted)  {
+		sortMoves(moves, keys, count);
+	}
+}
+
+/**
+ * @brief Searches a position to a fixed depth with alpha-beta pruning
+ *
+ * @param s The state of the search
+ * @param depth The number of moves left to search; passes do not use up depth
+ * @param ply The number of moves (including passes) made since the root
+ * @param alpha The score the side to move is already guaranteed elsewhere
+ * @param beta The score the opponent is already guaranteed elsewhere; anything at or above it will not be allowed
+ * @param passed Whether the previous move was a pass, in which case having no move ends the game
+ *
+ * @return The score of the position for the side to move
+ */
+static int negamax (Searcher* s, int depth, int ply, int alpha, int beta, bool passed)  {
+	//Variable declaration
+	Position* pos = s->pos;
+	Bitboard moveMask;
+	int* moves = s->moveLists[ply];
+	int count = 0, best = -SCORE_INFINITY, bestMove = NO_MOVE, ttMove = NO_MOVE, alphaOriginal = alpha, score;
+	bool pvNode = s->followPv;
+	TTData entry;
+
+	s->nodes++;
+	s->pvLength[ply] = ply;
+	pollLimits(s);
+	if (s->aborted || __atomic_load_n(s->stop, __ATOMIC_RELAXED))  {
+		s->aborted = true;
+		return 0;
+	}
+	//Once the root is close enough to the end, and wherever the remaining depth reaches the end anyway, the final disc count is solved exactly instead of estimated; solved results are stored,
+	//so later iterations do not solve the same positions again
+	if (ply > 0 && (s->solving || depth >= countEmpties(pos)) && countEmpties(pos) <= s->endgameEmpties)  {
+		s->followPv = false;
+		if (s->tt != NULL && ttProbe(s->tt, pos->hash, &entry, &s->ttStats) && entry.depth == SOLVED_DEPTH)  {
+			if (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && entry.score >= beta) || (entry.bound == BOUND_UPPER && entry.score <= alpha))  {
+				STAT(s->stats.ttCutoffs++);
+				return entry.score;
+			}
+		}
+		score = solveExactly(s, alpha, beta, passed);
+		if (s->tt != NULL && !s->aborted)  {
+			ttStore(s->tt, pos->hash, SOLVED_DEPTH, score <= alpha ? BOUND_UPPER : score >= beta ? BOUND_LOWER : BOUND_EXACT, score, NO_MOVE, &s->ttStats);
+		}
+		return score;
+	}
+	if (depth <= 0 || ply >= MAX_PLY-1)  {
+		s->followPv = false;
+		STAT(s->stats.evaluations++);
+		return evaluatePosition(pos, s->weights);
+	}
+
+	//A result stored from at least as deep a search settles the position, unless it is on the principal variation, whose moves are still needed to continue the line
+	if (s->tt != NULL && ttProbe(s->tt, pos->hash, &entry, &s->ttStats))  {
+		ttMove = entry.move;
+		if (ply > 0 && !pvNode && entry.depth >= depth)  {
+			if (entry.bound == BOUND_EXACT || (entry.bound == BOUND_LOWER && entry.score >= beta) || (entry.bound == BOUND_UPPER && entry.score <= alpha))  {
+				STAT(s->stats.ttCutoffs++);
+				return entry.score;
+			}
+		}
+	}
+
+	generateMoves(pos, pos->side, &moveMask);
+	STAT(s->stats.moveGenerations++);
+	for (int square = popSquare(&moveMask, pos->words); square != -1; square = popSquare(&moveMask, pos->words))  {
+		moves[count++] = square;
+	}
+
+	//With no legal move the side to move passes, unless the opponent has just passed as well, which ends the game
+	if (count == 0)  {
+		if (passed)  {
+			s->followPv = false;
+			return terminalScore(pos);
+		}
+		if (ttMove != NO_MOVE && ttMove != PASS_MOVE)  {
+			s->ttStats.falseHits++;
+		}
+		STAT(s->stats.passes++);
+		makeMove(pos, PASS_MOVE, s->undo);
+		score = -negamax(s, depth, ply+1, -beta, -alpha, true);
+		unmakeMove(pos, s->undo);
+		if (s->aborted)  {
+			return 0;
+		}
+		updatePv(s, ply, PASS_MOVE);
+		if (s->tt != NULL)  {
+			ttStore(s->tt, pos->hash, depth, score <= alphaOriginal ? BOUND_UPPER : score >= beta ? BOUND_LOWER : BOUND_EXACT, score, PASS_MOVE, &s->ttStats);
+		}
+		return score;
+	}
+
+	//A stored move that is not legal here means the entry belonged to a different position with the same hash
+	if (ttMove != NO_MOVE)  {
+		int i = 0;
+		while (i < count && moves[i] != ttMove)  {
+			i++;
+		}
+		if (i == count)  {
+			s->ttStats.falseHits++;
+			ttMove = NO_MOVE;
+		}
+	}
+	if (depth >= SHALLOW_ORDER_DEPTH && count > 1 && ttMove == NO_MOVE)  {
+		shallowOrder(s, moves, count, depth, ply);
+		if (s->aborted)  {
+			return 0;
+		}
+	}
+	else  {
+		orderMoves(&s->ordering, pos, s->undo, moves, count, ply, depth, ttMove);
+	}
+
+	//Brings the previous iteration's move to the front while following its principal variation
+	if (pvNode)  {
+		s->followPv = false;
+		for (int i = 0; i < count && ply < s->previousPvLength; i++)  {
+			if (moves[i] == s->previousPv[ply])  {
+				moves[i] = moves[0];
+				moves[0] = s->previousPv[ply];
+				s->followPv = true;
+				break;
+			}
+		}
+	}
+
+	//Helpers rotate the root moves after the first, so each of them starts on a different part of the tree
+	if (ply == 0 && s->thread > 0 && count > 2)  {
+		rotateMoves(moves+1, count-1, s->thread % (count-1));
+	}
+	if (ply == 0)  {
+		s->rootCount = count;
+	}
+
+	for (int i = 0; i < count; i++)  {
+		//Only the first move searched can continue the previous principal variation
+		if (i > 0)  {
+			s->followPv = false;
+		}
+		makeMove(pos, moves[i], s->undo);
+		score = -negamax(s, depth-1, ply+1, -beta, -alpha, false);
+		unmakeMove(pos, s->undo);
+		if (s->aborted)  {
+			return 0;
+		}
+		if (score > best)  {
+			best = score;
+			bestMove = moves[i];
+			updatePv(s, ply, moves[i]);
+			if (ply == 0)  {
+				s->rootBest = score;
+			}
+			if (score > alpha)  {
+				alpha = score;
+				//The opponent will never allow this position, so the remaining moves need not be searched
+				if (alpha >= beta)  {
+					STAT(s->stats.betaCutoffs++; s->stats.firstMoveCutoffs += i == 0; s->stats.cutoffMoves += i+1);
+					orderingCutoff(&s->ordering, pos->side, ply, depth, moves[i]);
+					break;
+				}
+			}
+		}
+	}
+
+	if (s->tt != NULL)  {
+		ttStore(s->tt, pos->hash, depth, best <= alphaOriginal ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT, best, bestMove, &s->ttStats);
+	}
+	return best;
+}
+
+/**
+ * @brief Runs iterative deepening for one thread
+ *
+ * Searches to depth 1, 2, ... up to the limit, starting each iteration from the principal variation of the one before, and stops early if the game is already over in the position, or if the soft
+ * time limit has passed. Of an iteration cut short by the stop flag, only the best root move found before the stop is kept, and only if one was searched completely
+ *
+ * @param s The state of the thread's search
+ * @param maxDepth The deepest iteration to search
+ * @param result Receives the best move, its score and the principal variation of the deepest completed iteration
+ */
+static void iterativeDeepening (Searcher* s, int maxDepth, SearchResult* result)  {
+	int score;
+
+	result->move = PASS_MOVE;
+	result->score = 0;
+	result->depth = 0;
+	result->bookMove = false;
+	result->solvedMove = false;
+	result->ponderHit = false;
+	result->pvLength = 0;
+	s->rootCount = 0;
+
+	//Helpers with an odd number start one move deeper than the main thread
+	for (int depth = 1 + (s->thread & 1); depth <= maxDepth; depth++)  {
+		s->followPv = true;
+		STAT(s->stats.iterations = depth; s->stats.iterationNodes[depth] = s->nodes; s->stats.iterationSeconds[depth] = secondsNow());
+		score = negamax(s, depth, 0, -SCORE_INFINITY, SCORE_INFINITY, false);
+		STAT(s->stats.iterationNodes[depth] = s->nodes - s->stats.iterationNodes[depth]; s->stats.iterationSeconds[depth] = secondsNow() - s->stats.iterationSeconds[depth]);
+		if (s->aborted)  {
+			//The root is searched with a full window, so a move that beat the previous best before the stop is better at the new depth as well
+			if (s->pvLength[0] > 0)  {
+				result->score = s->rootBest;
+				result->pvLength = s->pvLength[0];
+				for (int i = 0; i < s->pvLength[0]; i++)  {
+					result->pv[i] = s->pv[0][i];
+				}
+				result->move = result->pv[0];
+			}
+			//Stopped before even one root move was searched: the first move in the root's order is the best guess there is
+			else if (result->move == PASS_MOVE && s->rootCount > 0)  {
+				result->pvLength = 1;
+				result->pv[0] = s->moveLists[0][0];
+				result->move = result->pv[0];
+			}
+			break;
+		}
+
+		//Keeps the completed iteration, and its principal variation for the next one to start from
+		result->score = score;
+		result->depth = depth;
+		result->pvLength = s->pvLength[0];
+		for (int i = 0; i < s->pvLength[0]; i++)  {
+			result->pv[i] = s->pv[0][i];
+			s->previousPv[i] = s->pv[0][i];
+		}
+		s->previousPvLength = s->pvLength[0];
+		result->move = result->pvLength > 0 ? result->pv[0] : PASS_MOVE;
+
+		//A finished game cannot be searched any deeper, and once every root move has been solved exactly neither can the position
+		if (score >= SCORE_WIN || score <= -SCORE_WIN || (score == 0 && result->pvLength == 0))  {
+			break;
+		}
+		if (s->solving && result->move != PASS_MOVE)  {
+			break;
+		}
+		//Past the soft limit the next iteration would rarely finish before the hard one
+		if (s->softDeadline > 0 && secondsNow() >= s->softDeadline)  {
+			break;
+		}
+	}
+}
+
+//Bytes in each thread's arena; enough for its endgame table, searcher, position, undo stack and move lists
+#define WORKER_ARENA_BYTES (ENDGAME_TABLE_ENTRIES*sizeof(EndgameEntry) + sizeof(Searcher) + sizeof(Position) + sizeof(UndoStack) + MAX_PLY*MAX_SQUARES*sizeof(int) + 5*64)
+
+/**
+ * @brief One thread of a search, with the memory it searches with
+ */
+typedef struct  {
+	SearchContext* context;
+	int index;					//0 for the thread that called searchPosition; helpers are numbered from 1
+	Arena arena;				//Rewound to searchMark at the start of every search
+	EndgameEntry* endgameTable;	//Kept from search to search at the front of the arena
+	size_t searchMark;			//Where the memory of each search starts in the arena
+	Searcher* searcher;
+	SearchResult result;
+	uint64_t allocations;		//Heap allocations the thread made during its last search
+	pthread_t handle;
+} Worker;
+
+/**
+ * @brief The threads, memory and transposition table that searches are run with
+ */
+struct SearchContext  {
+	int threads;
+	TranspositionTable* tt;
+	const EvalWeights* weights;
+	Worker* workers;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;		//Signalled when a new search starts, or when the helpers must exit
+	pthread_cond_t idle;		//Signalled when the last helper finishes its part of a search
+	uint64_t generation;		//Counts the searches started, so a helper can tell when there is a new one
+	int running;				//Helpers still searching the current position
+	bool quit;
+	bool stop;					//Set to stop every thread of the current search
+	int maxDepth;
+};
+
+/**
+ * @brief Gives a thread a fresh copy of the root position and empty working memory for a new search
+ *
+ * Everything comes from the thread's arena, so nothing is allocated on the heap
+ */
+static void prepareWorker (Worker* worker, const Position* root, const SearchLimits* limits)  {
+	Searcher* s;
+
+	arenaRewind(&worker->arena, worker->searchMark);
+	s = (Searcher*) arenaAlloc(&worker->arena, sizeof(Searcher));
+	s->pos = (Position*) arenaAlloc(&worker->arena, sizeof(Position));
+	s->undo = (UndoStack*) arenaAlloc(&worker->arena, sizeof(UndoStack));
+	s->moveLists = (int (*)[MAX_SQUARES]) arenaAlloc(&worker->arena, MAX_PLY*MAX_SQUARES*sizeof(int));
+	*s->pos = *root;
+	clearUndoStack(s->undo);
+	s->thread = worker->index;
+	s->stop = &worker->context->stop;
+	s->aborted = false;
+	s->deadline = 0;
+	s->softDeadline = 0;
+	s->maxNodes = 0;
+	s->cancel = NULL;
+	s->nextPoll = POLL_NODES;
+	s->tt = worker->context->tt;
+	s->weights = worker->context->weights;
+	s->endgameEmpties = limits->endgameEmpties;
+	s->solving = countEmpties(root) <= limits->endgameEmpties;
+	s->endgame.pos = s->pos;
+	s->endgame.undo = s->undo;
+	s->endgame.table = worker->endgameTable;
+	s->endgame.stop = s->stop;
+	s->endgame.aborted = false;
+	s->endgame.deadline = 0;
+	s->endgame.maxNodes = 0;
+	s->endgame.cancel = NULL;
+	s->endgame.nodes = 0;
+	orderingInit(&s->ordering, root->dim);
+	memset(&s->ttStats, 0, sizeof(TTStats));
+	s->nodes = 0;
+	STAT(memset(&s->stats, 0, sizeof(SearchStats)));
+	s->previousPvLength = 0;
+	worker->searcher = s;
+}
+
+/**
+ * @brief Entry point of a helper thread
+ *
+ * Sleeps until a search starts, joins in until the search is stopped, and goes back to sleep; exits when the context is freed
+ */
+static void* helperThread (void* argument)  {
+	Worker* worker = (Worker*) argument;
+	SearchContext* context = worker->context;
+	uint64_t seen = 0, allocations;
+
+	pthread_mutex_lock(&context->lock);
+	while (true)  {
+		while (!context->quit && context->generation == seen)  {
+			pthread_cond_wait(&context->wake, &context->lock);
+		}
+		if (context->quit)  {
+			break;
+		}
+		seen = context->generation;
+		pthread_mutex_unlock(&context->lock);
+
+		allocations = heapAllocations();
+		iterativeDeepening(worker->searcher, context->maxDepth, &worker->result);
+		worker->allocations = heapAllocations() - allocations;
+
+		pthread_mutex_lock(&context->lock);
+		if (--context->running == 0)  {
+			pthread_cond_signal(&context->idle);
+		}
+	}
+	pthread_mutex_unlock(&context->lock);
+	return NULL;
+}
+
+/**
+ * @brief Sets up everything a series of searches needs: the helper threads, and an arena of working memory for every thread
+ *
+ * This is the only place the search allocates memory; searches run with the context afterwards make no heap allocations
+ *
+ * @param threads The number of threads each search uses, counting the one that calls searchPosition; 1 searches on the calling thread only, and always gives the same result
+ * @param tt The transposition table the searches share, or NULL to search without one; a parallel search without a table gains nothing from its helpers
+ * @param weights The evaluation weights every search uses; they must outlive the context
+ *
+ * @return The new context, or NULL if its memory could not be allocated
+ */
+SearchContext* searchContextCreate (int threads, TranspositionTable* tt, const EvalWeights* weights)  {
+	SearchContext* context = (SearchContext*) engineMalloc(sizeof(SearchContext));
+
+	if (context == NULL)  {
+		return NULL;
+	}
+	threads = threads < 1 ? 1 : threads > MAX_THREADS ? MAX_THREADS : threads;
+	context->workers = (Worker*) engineMalloc(threads*sizeof(Worker));
+	if (context->workers == NULL)  {
+		engineFree(context);
+		return NULL;
+	}
+	context->tt = tt;
+	context->weights = weights;
+	context->generation = 0;
+	context->running = 0;
+	context->quit = false;
+	context->stop = false;
+	pthread_mutex_init(&context->lock, NULL);
+	pthread_cond_init(&context->wake, NULL);
+	pthread_cond_init(&context->idle, NULL);
+
+	context->threads = 0;
+	for (int i = 0; i < threads; i++)  {
+		Worker* worker = &context->workers[i];
+		worker->context = context;
+		worker->index = i;
+		worker->allocations = 0;
+		if (!arenaInit(&worker->arena, WORKER_ARENA_BYTES))  {
+			break;
+		}
+		worker->endgameTable = (EndgameEntry*) arenaAlloc(&worker->arena, ENDGAME_TABLE_ENTRIES*sizeof(EndgameEntry));
+		memset(worker->endgameTable, 0, ENDGAME_TABLE_ENTRIES*sizeof(EndgameEntry));
+		worker->searchMark = arenaMark(&worker->arena);
+		//Helpers that cannot be started are left out, and the search runs with fewer threads
+		if (i > 0 && pthread_create(&worker->handle, NULL, helperThread, worker) != 0)  {
+			arenaRelease(&worker->arena);
+			break;
+		}
+		context->threads++;
+	}
+	if (context->threads == 0)  {
+		searchContextFree(context);
+		return NULL;
+	}
+	return context;
+}
+
+/**
+ * @brief Stops the helper threads and frees everything a context set up; the transposition table is left to its owner
+ */
+void searchContextFree (SearchContext* context)  {
+	if (context == NULL)  {
+		return;
+	}
+	pthread_mutex_lock(&context->lock);
+	context->quit = true;
+	pthread_cond_broadcast(&context->wake);
+	pthread_mutex_unlock(&context->lock);
+	for (int i = 0; i < context->threads; i++)  {
+		if (i > 0)  {
+			pthread_join(context->workers[i].handle, NULL);
+		}
+		arenaRelease(&context->workers[i].arena);
+	}
+	pthread_mutex_destroy(&context->lock);
+	pthread_cond_destroy(&context->wake);
+	pthread_cond_destroy(&context->idle);
+	engineFree(context->workers);
+	engineFree(context);
+}
+
+/**
+ * @brief Forgets every result kept by a context's searches: the transposition table, and each thread's table of solved endgames
+ *
+ * Afterwards a search runs exactly as it would with a newly created context
+ */
+void searchContextClear (SearchContext* context)  {
+	if (context->tt != NULL)  {
+		ttClear(context->tt);
+	}
+	for (int i = 0; i < context->threads; i++)  {
+		memset(context->workers[i].endgameTable, 0, ENDGAME_TABLE_ENTRIES*sizeof(EndgameEntry));
+	}
+}
+
+/**
+ * @brief The transposition table a context searches with
+ */
+TranspositionTable* searchContextTable (const SearchContext* context)  {
+	return context->tt;
+}
+
+/**
+ * @brief Turns the time limits of a search into the deadlines of its main thread
+ *
+ * A fixed time per move is used almost whole. A clock is shared out evenly between the moves the side to move still has to play, roughly half the empty squares, plus the increment; the move
+ * may run past its share while an iteration is still going, but never past a fixed fraction of what is left on the clock
+ *
+ * @param limits The limits of the search
+ * @param root The position being searched
+ * @param start When the search started
+ * @param soft Receives the time after which no new iteration is started, or 0 for none
+ * @param hard Receives the time at which the search is stopped, or 0 for none
+ */
+void searchPlanTime (const SearchLimits* limits, const Position* root, double start, double* soft, double* hard)  {
+	double share = 0, limit = 0;
+
+	if (limits->moveTime > 0)  {
+		share = limit = limits->moveTime;
+	}
+	if (limits->clockTime > 0)  {
+		int movesToGo = (countEmpties(root)+1) / 2;
+		double clockShare, clockLimit;
+
+		movesToGo = movesToGo < MIN_MOVES_TO_GO ? MIN_MOVES_TO_GO : movesToGo;
+		clockShare = limits->clockTime/movesToGo + limits->increment;
+		clockLimit = HARD_LIMIT_FACTOR*clockShare < MAX_CLOCK_FRACTION*limits->clockTime ? HARD_LIMIT_FACTOR*clockShare : MAX_CLOCK_FRACTION*limits->clockTime;
+		share = share > 0 && share < clockShare ? share : clockShare;
+		limit = limit > 0 && limit < clockLimit ? limit : clockLimit;
+	}
+	if (limit <= 0)  {
+		*soft = *hard = 0;
+		return;
+	}
+	share = share < limit ? share : limit;
+	limit = limit > 2*MOVE_OVERHEAD ? limit-MOVE_OVERHEAD : limit/2;
+	*soft = start + SOFT_LIMIT_FRACTION*share;
+	*hard = start + limit;
+}
+
+#ifdef ENGINE_STATS
+/**
+ * @brief Adds a helper thread's counts to the main thread's; the iterations are left as the main thread's own
+ */
+static void addSearchStats (SearchStats* total, const SearchStats* stats)  {
+	total->moveGenerations += stats->moveGenerations;
+	total->evaluations += stats->evaluations;
+	total->ttCutoffs += stats->ttCutoffs;
+	total->betaCutoffs += stats->betaCutoffs;
+	total->firstMoveCutoffs += stats->firstMoveCutoffs;
+	total->cutoffMoves += stats->cutoffMoves;
+	total->passes += stats->passes;
+	total->endgameSolves += stats->endgameSolves;
+	total->endgameNodes += stats->endgameNodes;
+}
+#endif
+
+/**
+ * @brief Finds the best move in a position by iterative deepening, using every thread of a context
+ *
+ * @param context The threads, memory and transposition table to search with; entries left in the table by earlier searches are reused
+ * @param pos The position being searched; it is left unchanged
+ * @param limits How deep, how long and how many nodes the search may go; a search with no limit at all runs to MAX_PLY
+ * @param result Receives the best move, its score and the principal variation of the main thread's deepest iteration, and the node counts of every thread; a search stopped by its time or node
+ *               limit returns the deepest completed iteration, or the best root move of the interrupted one
+ */
+void searchPosition (SearchContext* context, Position* pos, const SearchLimits* limits, SearchResult* result)  {
+	//Variable declaration
+	int threads = context->threads;
+	uint64_t allocations = heapAllocations();
+	int maxDepth = limits->maxDepth > 0 && limits->maxDepth < MAX_PLY-1 ? limits->maxDepth : MAX_PLY-2;
+	double start = secondsNow();
+	Searcher* mainSearcher;
+	TTStats ttStats;
+
+	if (context->tt != NULL)  {
+		ttNewSearch(context->tt);
+	}
+	for (int i = 0; i < threads; i++)  {
+		prepareWorker(&context->workers[i], pos, limits);
+	}
+	//Only the main thread watches the limits; the helpers are stopped with it
+	mainSearcher = context->workers[0].searcher;
+	searchPlanTime(limits, pos, start, &mainSearcher->softDeadline, &mainSearcher->deadline);
+	mainSearcher->maxNodes = limits->maxNodes;
+	mainSearcher->cancel = limits->cancel;
+
+	//Wakes the helpers, searches on this thread, then stops the helpers and waits for all of them to go back to sleep
+	pthread_mutex_lock(&context->lock);
+	context->stop = false;
+	context->maxDepth = maxDepth;
+	context->running = threads-1;
+	context->generation++;
+	pthread_cond_broadcast(&context->wake);
+	pthread_mutex_unlock(&context->lock);
+
+	iterativeDeepening(mainSearcher, maxDepth, result);
+
+	pthread_mutex_lock(&context->lock);
+	__atomic_store_n(&context->stop, true, __ATOMIC_RELAXED);
+	while (context->running > 0)  {
+		pthread_cond_wait(&context->idle, &context->lock);
+	}
+	pthread_mutex_unlock(&context->lock);
+
+	result->seconds = secondsNow() - start;
+	result->threads = threads;
+	result->nodes = 0;
+	memset(&ttStats, 0, sizeof(TTStats));
+	for (int i = 0; i < threads; i++)  {
+		result->threadNodes[i] = context->workers[i].searcher->nodes;
+		result->nodes += context->workers[i].searcher->nodes;
+		ttAddStats(&ttStats, &context->workers[i].searcher->ttStats);
+	}
+	result->tt = ttStats;
+#ifdef ENGINE_STATS
+	result->stats = context->workers[0].searcher->stats;
+	for (int i = 1; i < threads; i++)  {
+		addSearchStats(&result->stats, &context->workers[i].searcher->stats);
+	}
+#endif
+	if (context->tt != NULL)  {
+		ttAddStats(&context->tt->stats, &ttStats);
+	}
+	result->arenaBytes = context->workers[0].arena.peak;
+	result->heapAllocations = heapAllocations() - allocations;
+	for (int i = 1; i < threads; i++)  {
+		result->heapAllocations += context->workers[i].allocations;
+	}
+}
+
+/**
+ * @brief Writes what a search found and what it did as one line of JSON, for collecting the statistics of many searches in a file
+ *
+ * Builds with ENGINE_STATS add the search's counts, the effective branching factor of its last completed iteration (its nodes over those of the one before), and the nodes and time of every
+ * iteration
+ *
+ * @param file The file written to
+ * @param result The search's result
+ * @param dim The size n of the n x n board searched
+ */
+void searchWriteJson (FILE* file, const SearchResult* result, int dim)  {
+	char name[3];
+#ifdef ENGINE_STATS
+	const SearchStats* stats = &result->stats;
+	int last = result->depth;
+	double branching = last > 1 && stats->iterationNodes[last-1] > 0 ? (double) stats->iterationNodes[last] / stats->iterationNodes[last-1] : 0.0;
+#endif
+
+	name[0] = result->move == PASS_MOVE ? '-' : result->move/dim+'a';
+	name[1] = result->move == PASS_MOVE ? '-' : result->move%dim+'a';
+	name[2] = '\0';
+	fprintf(file, "{\"size\": %d, \"move\": \"%s\", \"score\": %d, \"depth\": %d, \"bookMove\": %s, \"solvedMove\": %s, \"ponderHit\": %s, \"nodes\": %llu, \"seconds\": %.6f, \"nodesPerSecond\": %.0f, \"threads\": %d, "
+		"\"ttProbes\": %llu, \"ttHits\": %llu, \"ttFalseHits\": %llu, \"ttStores\": %llu, \"ttCollisions\": %llu, \"arenaBytes\": %zu, \"heapAllocations\": %llu", dim, name, result->score,
+		result->depth, result->bookMove ? "true" : "false", result->solvedMove ? "true" : "false", result->ponderHit ? "true" : "false", (unsigned long long) result->nodes, result->seconds,
+		result->seconds > 0 ? result->nodes/result->seconds : 0.0, result->threads, (unsigned long long) result->tt.probes, (unsigned long long) result->tt.hits,
+		(unsigned long long) result->tt.falseHits, (unsigned long long) result->tt.stores, (unsigned long long) result->tt.collisions, result->arenaBytes,
+		(unsigned long long) result->heapAllocations);
+#ifdef ENGINE_STATS
+	fprintf(file, ", \"moveGenerations\": %llu, \"evaluations\": %llu, \"ttCutoffs\": %llu, \"betaCutoffs\": %llu, \"firstMoveCutoffs\": %llu, \"movesPerCutoff\": %.3f, \"passes\": %llu, "
+		"\"endgameSolves\": %llu, \"endgameNodes\": %llu, \"branchingFactor\": %.3f, \"iterations\": [", (unsigned long long) stats->moveGenerations, (unsigned long long) stats->evaluations,
+		(unsigned long long) stats->ttCutoffs, (unsigned long long) stats->betaCutoffs, (unsigned long long) stats->firstMoveCutoffs,
+		stats->betaCutoffs > 0 ? (double) stats->cutoffMoves/stats->betaCutoffs : 0.0, (unsigned long long) stats->passes, (unsigned long long) stats->endgameSolves,
+		(unsigned long long) stats->endgameNodes, branching);
+	//The book, the strong-solve database and positions without a legal move are not searched, and have no iterations
+	for (int depth = 1; depth <= stats->iterations && result->nodes > 0; depth++)  {
+		fprintf(file, "%s{\"depth\": %d, \"nodes\": %llu, \"seconds\": %.6f}", depth > 1 ? ", " : "", depth, (unsigned long long) stats->iterationNodes[depth], stats->iterationSeconds[depth]);
+	}
+	fprintf(file, "]");
+#endif
+	fprintf(file, "}\n");
+}
@@ -0,0 +1,114 @@
+/**
+ * @file search.h
+ * @brief Alpha-beta negamax search with iterative deepening
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+#include "tt.h"
+#include "eval.h"
+
+//Deepest the search ever goes, counting passes
+#define MAX_PLY 64
+
+//Scores are from the point of view of the side to move; a finished game scores SCORE_WIN plus the disc differential for a win, and minus SCORE_WIN plus the differential for a loss
+#define SCORE_INFINITY 1000000
+#define SCORE_WIN 100000
+
+//Most threads a single search can use
+#define MAX_THREADS 64
+
+//A move that has not been found yet; distinct from every square and from PASS_MOVE
+#define NO_MOVE -2
+
+//Smallest time left on a clock; a search with this little time returns its first move at once
+#define MIN_CLOCK_TIME 0.001
+
+//Counting what the search does costs time, so the counters are only compiled in when ENGINE_STATS is defined; every file must then be built with it. STAT(statement) runs the statement in
+//those builds and compiles to nothing otherwise
+#ifdef ENGINE_STATS
+#define STAT(statement) do  { statement; } while (0)
+#else
+#define STAT(statement) ((void) 0)
+#endif
+
+#ifdef ENGINE_STATS
+/**
+ * @brief What a search did, counted as it went and added up over every thread; the iterations are those of the main thread
+ */
+typedef struct  {
+	uint64_t moveGenerations;			//Positions whose moves were generated to be searched
+	uint64_t evaluations;				//Positions scored by the evaluation at the end of a line
+	uint64_t ttCutoffs;					//Positions settled by a stored result without being searched
+	uint64_t betaCutoffs;				//Positions whose remaining moves were cut off
+	uint64_t firstMoveCutoffs;			//Cut offs made by the first move searched, which show how well the moves are ordered
+	uint64_t cutoffMoves;				//Moves searched before each cut off, added up
+	uint64_t passes;					//Passes searched
+	uint64_t endgameSolves;				//Positions handed to the exact solver
+	uint64_t endgameNodes;				//Positions the exact solver visited
+	int iterations;						//Iterations started, the last of them perhaps cut short
+	uint64_t iterationNodes[MAX_PLY];	//Positions visited by each iteration, indexed by its depth
+	double iterationSeconds[MAX_PLY];	//Wall-clock time of each iteration, indexed by its depth
+} SearchStats;
+#endif
+
+/**
+ * @brief How far a search is allowed to go
+ *
+ * Every limit given applies, and the first one reached ends the search; a limit of 0 is not used
+ */
+typedef struct  {
+	int maxDepth;		//Deepest iteration searched, in moves; passes do not count
+	int endgameEmpties;	//With at most this many empty squares at the root, every move is solved exactly to the end of the game; deeper in a search, a position with at most this many is solved
+						//exactly wherever the remaining depth reaches the end of the game anyway. 0 never solves
+	double moveTime;	//Seconds the search may take
+	double clockTime;	//Seconds left on the side to move's clock, shared out between the moves it still has to play; a clock that has run out is given as MIN_CLOCK_TIME
+	double increment;	//Seconds added to the clock after every move
+	uint64_t maxNodes;	//Positions the main thread may visit
+	const bool* cancel;	//Set by another thread to stop the search as if its time had run out; NULL for none
+} SearchLimits;
+
+/**
+ * @brief What a search found
+ */
+typedef struct  {
+	int move;			//The best move, or PASS_MOVE if the side to move has no legal move
+	int score;			//The score of the best move for the side to move
+	int depth;			//The deepest iteration that completed; 0 for a move from the opening book or the strong-solve database
+	bool bookMove;		//Whether the move came from the opening book, without a search
+	bool solvedMove;	//Whether the move came from the strong-solve database, without a search; the score is then exact
+	bool ponderHit;		//Whether the search began while the opponent was still thinking, on the reply it then played
+	int pvLength;		//The number of moves in the principal variation
+	int pv[MAX_PLY];	//The principal variation: the best move followed by the best replies found for both sides
+	uint64_t nodes;		//The number of positions visited over all iterations, by all threads
+	TTStats tt;			//How the transposition table was used over all iterations, by all threads
+	double seconds;		//Wall-clock time the search took
+	int threads;		//The number of threads that searched
+	uint64_t threadNodes[MAX_THREADS];	//The number of positions each thread visited
+	size_t arenaBytes;					//Most working memory one thread has used from its arena
+	uint64_t heapAllocations;			//Heap allocations the search's own threads made while searching; always 0 once the context is set up
+#ifdef ENGINE_STATS
+	SearchStats stats;
+#endif
+} SearchResult;
+
+//The threads, working memory and transposition table that searches are run with; set up once and reused for every search
+typedef struct SearchContext SearchContext;
+
+int terminalScore (const Position* pos);
+int scoreFromDifference (int difference);
+SearchContext* searchContextCreate (int threads, TranspositionTable* tt, const EvalWeights* weights);
+void searchContextFree (SearchContext* context);
+void searchContextClear (SearchContext* context);
+TranspositionTable* searchContextTable (const SearchContext* context);
+void searchPlanTime (const SearchLimits* limits, const Position* root, double start, double* soft, double* hard);
+void searchPosition (SearchContext* context, Position* pos, const SearchLimits* limits, SearchResult* result);
+void searchWriteJson (FILE* file, const SearchResult* result, int dim);
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file selfplay.c
+ * @brief Headless engine-against-engine games, written to a file of game records
+ *
+ * Each game opens with a few moves picked at random from its seed and is then played out by the engine for both sides, with no terminal input or output. Every finished game is written as one line:
+ *
+ *   size seed blackDiscs whiteDiscs move move ...
+ *
+ * with each move written as its row and column letters, as the game takes it as input, and a pass written as "--". Games can also be added to the end of a binary record file, which holds the
+ * same games in a fraction of the space. With one thread the same options always play the same games
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "selfplay.h"
+#include "util.h"
+
+/**
+ * @brief Plays one game from the starting position to the end
+ *
+ * @param engine The engine that plays both sides
+ * @param dim The size n of the n x n board
+ * @param seed Picks the random opening moves
+ * @param options How many opening moves are random and how far the rest are searched
+ * @param moves Receives every move of the game, passes included
+ * @param summary Receives the positions visited by every search, and the time of the slowest one
+ * @param pos Receives the final position
+ * @param statsFile The file every search is written to as a line of JSON, or NULL
+ *
+ * @return The number of moves played
+ */
+static int playSelfPlayGame (ReversiEngine* engine, int dim, uint64_t seed, const SelfPlayOptions* options, int* moves, SelfPlaySummary* summary, Position* pos, FILE* statsFile)  {
+	int legal[MAX_SQUARES];
+	int count = 0, legalCount, move;
+	uint64_t random = seed;
+	SearchLimits limits = options->limits;
+	SearchResult result;
+	double clock[2] = {options->limits.clockTime, options->limits.clockTime};
+
+	reversiNewPosition(pos, dim);
+	while (!reversiGameOver(pos))  {
+		legalCount = reversiLegalMoves(pos, legal);
+		if (legalCount == 0)  {
+			move = PASS_MOVE;
+		}
+		else if (count < options->randomPlies)  {
+			move = legal[nextRandom(&random) % legalCount];
+		}
+		else  {
+			//Each side searches on its own clock, which keeps at least MIN_CLOCK_TIME once it has run out
+			limits.clockTime = clock[pos->side];
+			move = reversiSearch(engine, pos, &limits, &result);
+			if (options->limits.clockTime > 0)  {
+				clock[pos->side] += limits.increment - result.seconds;
+				clock[pos->side] = clock[pos->side] > MIN_CLOCK_TIME ? clock[pos->side] : MIN_CLOCK_TIME;
+			}
+			summary->nodes += result.nodes;
+			summary->longestMove = result.seconds > summary->longestMove ? result.seconds : summary->longestMove;
+			if (statsFile != NULL)  {
+				searchWriteJson(statsFile, &result, dim);
+			}
+		}
+		reversiPlay(pos, move);
+		moves[count++] = move;
+	}
+	return count;
+}
+
+/**
+ * @brief Plays a run of engine-against-engine games and writes their records
+ *
+ * @param engine The engine that plays both sides of every game
+ * @param options How many games, on which board sizes, from which seed and how far each move is searched
+ * @param summary Receives the results and how long the run took
+ *
+ * @return Whether the run was played; false if a board size is not playable or an output file could not be written
+ */
+bool selfPlay (ReversiEngine* engine, const SelfPlayOptions* options, SelfPlaySummary* summary)  {
+	//Variable declaration
+	static GameRecord game;
+	FILE* output = NULL;
+	FILE* records = NULL;
+	FILE* stats = NULL;
+	Position pos;
+	bool written = true;
+	double start = secondsNow();
+
+	memset(summary, 0, sizeof(SelfPlaySummary));
+	for (int i = 0; i < options->sizeCount; i++)  {
+		if (options->sizes[i] < REVERSI_MIN_DIM || options->sizes[i] > MAX_DIM)  {
+			return false;
+		}
+	}
+	if (options->sizeCount == 0)  {
+		return false;
+	}
+	if (options->outputPath != NULL)  {
+		output = fopen(options->outputPath, "w");
+		if (output == NULL)  {
+			return false;
+		}
+		fprintf(output, "# size seed blackDiscs whiteDiscs moves\n");
+	}
+	if (options->recordPath != NULL)  {
+		records = recordAppend(options->recordPath);
+		written = records != NULL;
+	}
+	if (options->statsPath != NULL && written)  {
+		stats = fopen(options->statsPath, "w");
+		written = stats != NULL;
+	}
+	if (!written)  {
+		if (output != NULL)  {
+			fclose(output);
+		}
+		if (records != NULL)  {
+			fclose(records);
+		}
+		return false;
+	}
+
+	for (int i = 0; i < options->games; i++)  {
+		game.dim = options->sizes[i % options->sizeCount];
+		game.seed = options->seed + i;
+		game.moveCount = playSelfPlayGame(engine, game.dim, game.seed, options, game.moves, summary, &pos, stats);
+		game.discs[BLACK] = reversiDiscs(&pos, BLACK);
+		game.discs[WHITE] = reversiDiscs(&pos, WHITE);
+
+		summary->games++;
+		summary->moves += game.moveCount;
+		if (game.discs[BLACK] == game.discs[WHITE])  {
+			summary->draws++;
+		}
+		else  {
+			summary->wins[game.discs[BLACK] > game.discs[WHITE] ? BLACK : WHITE]++;
+		}
+		if (output != NULL)  {
+			recordWriteText(output, &game);
+		}
+		if (records != NULL)  {
+			written = recordWrite(records, &game) && written;
+		}
+	}
+
+	summary->seconds = secondsNow() - start;
+	if (output != NULL && fclose(output) != 0)  {
+		written = false;
+	}
+	if (records != NULL && fclose(records) != 0)  {
+		written = false;
+	}
+	if (stats != NULL && fclose(stats) != 0)  {
+		written = false;
+	}
+	return written;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file selfplay.h
+ * @brief Headless engine-against-engine games, written to a file of game records
+ */
+
+#ifndef SELFPLAY_H
+#define SELFPLAY_H
+
+#include <stdint.h>
+
+#include "reversi.h"
+#include "record.h"
+
+//Most board sizes one run can cycle through
+#define MAX_SELFPLAY_SIZES 16
+
+//Opening moves played at random, unless another number is given, so games from different seeds differ
+#define DEFAULT_RANDOM_PLIES 4
+
+/**
+ * @brief What a self-play run plays
+ */
+typedef struct  {
+	int games;							//Number of games
+	int sizes[MAX_SELFPLAY_SIZES];		//Board sizes, used in turn: game i is played on sizes[i % sizeCount]
+	int sizeCount;
+	uint64_t seed;						//Game i is played from seed+i, which picks its random opening moves
+	int randomPlies;					//Number of opening moves played at random
+	SearchLimits limits;				//How far every move is searched; clockTime and increment give each side its own clock for the game. With no limit, reversiDefaultDepth of the board size
+	const char* outputPath;				//File the game records are written to as text; NULL to write none
+	const char* recordPath;				//Binary record file every game is added to; NULL to add to none
+	const char* statsPath;				//File every search is written to as one line of JSON; NULL for none
+} SelfPlayOptions;
+
+/**
+ * @brief What a self-play run played
+ */
+typedef struct  {
+	int games;
+	uint64_t moves;			//Moves played over every game, passes included
+	uint64_t nodes;			//Positions visited by every search
+	int wins[2];			//Games won by each colour, indexed by BLACK and WHITE
+	int draws;
+	double seconds;			//Wall-clock time of the whole run
+	double longestMove;		//Wall-clock time of the slowest search
+} SelfPlaySummary;
+
+bool selfPlay (ReversiEngine* engine, const SelfPlayOptions* options, SelfPlaySummary* summary);
+
+#endif
@@ -0,0 +1,376 @@
+/**
+ * @file solved.c
+ * @brief Strong-solve database: the exact result and best move of positions on small boards, in a hash-indexed binary file that is mapped into memory
+ *
+ * The solver, solvedb, works out the exact final disc differential and a best move for positions of a small board, and this file keeps them. A position and its 7 reflections and rotations
+ * have the same result, so only one of them is stored, the canonical one: each symmetry is applied to the discs laid out on an 8 x 8 board, and the one whose discs come first is kept. A database
+ * file is a SolvedHeader followed by an open-addressed hash table of entries, in the byte order of the machine that built it. Opening a database maps the file read-only and checks its header,
+ * as the opening book does, and a lookup hashes the canonical position and probes from its slot to the first empty one, so it costs the same however large the database is. Databases are
+ * rewritten whole, to a temporary file that is then renamed over the old one
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "solved.h"
+#include "arena.h"
+
+//First bytes of a database file
+static const char solvedMagic[4] = {'R', 'V', 'S', 'D'};
+
+//The parts of an entry a lookup compares: the discs and board size of the side to move, and the discs of the opponent
+#define SOLVED_OWN_KEY_MASK 0x00ffffffffffffffULL
+
+/**
+ * @brief Lays the squares of a board of up to 8 x 8, stored as bit row*dim+col, out on the rows of an 8 x 8 board, as bit row*8+col
+ *
+ * @param squares The squares, as a position stores them
+ * @param dim The size n of the n x n board
+ */
+uint64_t solvedSpread (uint64_t squares, int dim)  {
+	uint64_t spread = 0, row = (1ULL << dim) - 1;
+
+	for (int r = 0; r < dim; r++)  {
+		spread |= ((squares >> r*dim) & row) << 8*r;
+	}
+	return spread;
+}
+
+/**
+ * @brief Takes squares laid out on the rows of an 8 x 8 board back to bit row*dim+col, as a position stores them
+ *
+ * @param squares The squares, on the 8 x 8 layout
+ * @param dim The size n of the n x n board
+ */
+uint64_t solvedGather (uint64_t squares, int dim)  {
+	uint64_t gathered = 0, row = (1ULL << dim) - 1;
+
+	for (int r = 0; r < dim; r++)  {
+		gathered |= ((squares >> 8*r) & row) << r*dim;
+	}
+	return gathered;
+}
+
+/**
+ * @brief The squares of an n x n board on the 8 x 8 layout
+ */
+uint64_t solvedRegion (int dim)  {
+	return solvedSpread(dim*dim >= 64 ? ~0ULL : (1ULL << dim*dim) - 1, dim);
+}
+
+/**
+ * @brief Applies one of the symmetries of a square board to its squares
+ *
+ * Each step works on the whole 8 x 8 layout and then moves the board back into its top left corner
+ *
+ * @param squares The squares, on the 8 x 8 layout
+ * @param dim The size n of the n x n board
+ * @param symmetry Which symmetry, from 0 to SOLVED_SYMMETRIES-1; 0 leaves the squares as they are
+ *
+ * @return The squares after the symmetry
+ */
+uint64_t solvedTransform (uint64_t squares, int dim, int symmetry)  {
+	uint64_t swap;
+
+	if (symmetry & 1)  {
+		//Swaps rows and columns by exchanging ever smaller blocks across the diagonal
+		swap = 0x0f0f0f0f00000000ULL & (squares ^ (squares << 28));
+		squares ^= swap ^ (swap >> 28);
+		swap = 0x3333000033330000ULL & (squares ^ (squares << 14));
+		squares ^= swap ^ (swap >> 14);
+		swap = 0x5500550055005500ULL & (squares ^ (squares << 7));
+		squares ^= swap ^ (swap >> 7);
+	}
+	if (symmetry & 2)  {
+		squares = __builtin_bswap64(squares) >> 8*(8-dim);
+	}
+	if (symmetry & 4)  {
+		//Reverses the bits of every row, and the empty columns that come first are then shifted out
+		squares = ((squares >> 1) & 0x5555555555555555ULL) | ((squares & 0x5555555555555555ULL) << 1);
+		squares = ((squares >> 2) & 0x3333333333333333ULL) | ((squares & 0x3333333333333333ULL) << 2);
+		squares = ((squares >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((squares & 0x0f0f0f0f0f0f0f0fULL) << 4);
+		squares >>= 8-dim;
+	}
+	return squares;
+}
+
+/**
+ * @brief Applies one of the symmetries of a square board to a single square, or takes it back
+ *
+ * @param square The square, as row*8+col
+ * @param dim The size n of the n x n board
+ * @param symmetry Which symmetry, as for solvedTransform
+ * @param inverse Whether to take the symmetry back instead: where the square was before it was applied
+ *
+ * @return The square after the symmetry, as row*8+col
+ */
+int solvedTransformSquare (int square, int dim, int symmetry, bool inverse)  {
+	int row = square/8, col = square%8, swap;
+
+	//Every step is its own inverse, so taking the symmetry back runs them in the other order
+	if ((symmetry & 1) && !inverse)  {
+		swap = row;
+		row = col;
+		col = swap;
+	}
+	if (symmetry & 2)  {
+		row = dim-1-row;
+	}
+	if (symmetry & 4)  {
+		col = dim-1-col;
+	}
+	if ((symmetry & 1) && inverse)  {
+		swap = row;
+		row = col;
+		col = swap;
+	}
+	return row*8 + col;
+}
+
+/**
+ * @brief Turns a position into its canonical orientation: of its symmetries, the one whose discs of the side to move come first, and then those of the opponent
+ *
+ * @param own The discs of the side to move, on the 8 x 8 layout; replaced by the canonical ones
+ * @param opp The discs of the opponent, on the 8 x 8 layout; replaced by the canonical ones
+ * @param dim The size n of the n x n board
+ *
+ * @return The symmetry that was applied
+ */
+int solvedCanonical (uint64_t* own, uint64_t* opp, int dim)  {
+	uint64_t bestOwn = *own, bestOpp = *opp;
+	int best = 0;
+
+	for (int symmetry = 1; symmetry < SOLVED_SYMMETRIES; symmetry++)  {
+		uint64_t turnedOwn = solvedTransform(*own, dim, symmetry), turnedOpp;
+		if (turnedOwn > bestOwn)  {
+			continue;
+		}
+		turnedOpp = solvedTransform(*opp, dim, symmetry);
+		if (turnedOwn < bestOwn || turnedOpp < bestOpp)  {
+			bestOwn = turnedOwn;
+			bestOpp = turnedOpp;
+			best = symmetry;
+		}
+	}
+	*own = bestOwn;
+	*opp = bestOpp;
+	return best;
+}
+
+/**
+ * @brief Packs a solved position into an entry
+ *
+ * @param own The canonical discs of the side to move, on the 8 x 8 layout
+ * @param opp The canonical discs of the opponent, on the 8 x 8 layout
+ * @param dim The size n of the n x n board
+ * @param move The best move in the canonical orientation, as row*8+col
+ * @param difference The final disc differential for the side to move with best play by both sides
+ */
+SolvedEntry solvedMakeEntry (uint64_t own, uint64_t opp, int dim, int move, int difference)  {
+	SolvedEntry entry;
+
+	entry.own = (own & SOLVED_DISCS_MASK) | (uint64_t) dim << SOLVED_DIM_SHIFT | (uint64_t) (uint8_t) move << SOLVED_MOVE_SHIFT;
+	entry.opp = (opp & SOLVED_DISCS_MASK) | (uint64_t) (uint8_t) (int8_t) difference << SOLVED_RESULT_SHIFT;
+	return entry;
+}
+
+/**
+ * @brief The slot of a table at which the probe for a position starts
+ *
+ * The database builder hashes its own tables of positions with the same function, so the file it writes and every lookup in it always agree
+ *
+ * @param ownKey The discs and board size of the side to move, as the first word of an entry holds them without its move
+ * @param opp The discs of the opponent
+ * @param capacity The number of slots; a power of two
+ *
+ * @return The slot
+ */
+size_t solvedSlot (uint64_t ownKey, uint64_t opp, size_t capacity)  {
+	uint64_t hash = ownKey*0x9e3779b97f4a7c15ULL ^ opp*0xc2b2ae3d27d4eb4fULL;
+
+	hash ^= hash >> 29;
+	return (size_t) (hash*0xbf58476d1ce4e5b9ULL >> 32) & (capacity-1);
+}
+
+/**
+ * @brief Maps a database file into memory
+ *
+ * @param path The file
+ *
+ * @return The open database, or NULL if the file cannot be read or is not a database of this version
+ */
+SolvedDatabase* solvedOpen (const char* path)  {
+	SolvedDatabase* database;
+	const SolvedHeader* header;
+	struct stat status;
+	void* mapping;
+	int file = open(path, O_RDONLY);
+
+	if (file < 0)  {
+		return NULL;
+	}
+	if (fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(SolvedHeader))  {
+		close(file);
+		return NULL;
+	}
+	//The mapping stays valid once the file is closed
+	mapping = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (mapping == MAP_FAILED)  {
+		return NULL;
+	}
+	header = (const SolvedHeader*) mapping;
+	database = (SolvedDatabase*) engineMalloc(sizeof(SolvedDatabase));
+	//A table with no empty slot would leave a probe for a missing position nowhere to stop
+	if (database == NULL || memcmp(header->magic, solvedMagic, 4) != 0 || header->version != SOLVED_VERSION || header->capacity == 0 || (header->capacity & (header->capacity-1)) != 0 ||
+		header->count >= header->capacity || sizeof(SolvedHeader) + header->capacity*sizeof(SolvedEntry) != (size_t) status.st_size)  {
+		engineFree(database);
+		munmap(mapping, (size_t) status.st_size);
+		return NULL;
+	}
+	database->entries = (const SolvedEntry*) (header+1);
+	database->capacity = (size_t) header->capacity;
+	database->count = (size_t) header->count;
+	database->mapping = mapping;
+	database->bytes = (size_t) status.st_size;
+	return database;
+}
+
+/**
+ * @brief Unmaps a database
+ */
+void solvedClose (SolvedDatabase* database)  {
+	if (database == NULL)  {
+		return;
+	}
+	munmap(database->mapping, database->bytes);
+	engineFree(database);
+}
+
+/**
+ * @brief Finds the entry of a position already in its canonical orientation
+ *
+ * @param database The database
+ * @param own The canonical discs of the side to move, on the 8 x 8 layout
+ * @param opp The canonical discs of the opponent, on the 8 x 8 layout
+ * @param dim The size n of the n x n board
+ *
+ * @return The entry, or NULL if the database does not hold the position
+ */
+const SolvedEntry* solvedFind (const SolvedDatabase* database, uint64_t own, uint64_t opp, int dim)  {
+	uint64_t ownKey = own | (uint64_t) dim << SOLVED_DIM_SHIFT;
+
+	for (size_t slot = solvedSlot(ownKey, opp, database->capacity); database->entries[slot].own != 0; slot = (slot+1) & (database->capacity-1))  {
+		const SolvedEntry* entry = &database->entries[slot];
+		if ((entry->own & SOLVED_OWN_KEY_MASK) == ownKey && (entry->opp & SOLVED_DISCS_MASK) == opp)  {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Finds the exact result and a best move of a position
+ *
+ * The stored move is turned back from the canonical orientation to the position's own, and a move that is not legal in the position is never given
+ *
+ * @param database The database
+ * @param pos The position
+ * @param move Receives the move
+ * @param difference Receives the final disc differential for the side to move with best play by both sides
+ *
+ * @return Whether the database held the position
+ */
+bool solvedLookup (const SolvedDatabase* database, const Position* pos, int* move, int* difference)  {
+	uint64_t own, opp;
+	const SolvedEntry* entry;
+	Bitboard flips;
+	int symmetry, square;
+
+	if (pos->dim > SOLVED_MAX_DIM)  {
+		return false;
+	}
+	own = solvedSpread(pos->disc[pos->side].word[0], pos->dim);
+	opp = solvedSpread(pos->disc[1-pos->side].word[0], pos->dim);
+	symmetry = solvedCanonical(&own, &opp, pos->dim);
+	entry = solvedFind(database, own, opp, pos->dim);
+	if (entry == NULL)  {
+		return false;
+	}
+	square = solvedTransformSquare((int) (entry->own >> SOLVED_MOVE_SHIFT), pos->dim, symmetry, true);
+	square = (square/8)*pos->dim + square%8;
+	if (square < 0 || square >= pos->dim*pos->dim || computeFlips(pos, pos->side, square, &flips, NULL) == 0)  {
+		return false;
+	}
+	*move = square;
+	*difference = (int8_t) (uint8_t) (entry->opp >> SOLVED_RESULT_SHIFT);
+	return true;
+}
+
+/**
+ * @brief Writes a database, replacing any database already at the path only once the new one is complete
+ *
+ * The table is given twice as many slots as there are entries, rounded up to a power of two, so probes stay short
+ *
+ * @param path The file
+ * @param entries The entries, in any order; of two entries for the same position, the later one is kept
+ * @param count The number of entries
+ *
+ * @return Whether the database was written
+ */
+bool solvedWrite (const char* path, const SolvedEntry* entries, size_t count)  {
+	SolvedHeader header;
+	SolvedEntry* table;
+	size_t capacity = 16, length = strlen(path), stored = 0;
+	char* temporary;
+	FILE* file;
+	bool written;
+
+	while (capacity < 2*count)  {
+		capacity *= 2;
+	}
+	table = (SolvedEntry*) engineMalloc(capacity*sizeof(SolvedEntry));
+	temporary = (char*) engineMalloc(length+5);
+	if (table == NULL || temporary == NULL)  {
+		engineFree(table);
+		engineFree(temporary);
+		return false;
+	}
+	memset(table, 0, capacity*sizeof(SolvedEntry));
+	for (size_t i = 0; i < count; i++)  {
+		uint64_t ownKey = entries[i].own & SOLVED_OWN_KEY_MASK, opp = entries[i].opp & SOLVED_DISCS_MASK;
+		size_t slot = solvedSlot(ownKey, opp, capacity);
+		while (table[slot].own != 0 && ((table[slot].own & SOLVED_OWN_KEY_MASK) != ownKey || (table[slot].opp & SOLVED_DISCS_MASK) != opp))  {
+			slot = (slot+1) & (capacity-1);
+		}
+		stored += table[slot].own == 0;
+		table[slot] = entries[i];
+	}
+
+	memcpy(temporary, path, length);
+	memcpy(temporary+length, ".tmp", 5);
+	file = fopen(temporary, "wb");
+	written = file != NULL;
+	if (written)  {
+		memset(&header, 0, sizeof(SolvedHeader));
+		memcpy(header.magic, solvedMagic, 4);
+		header.version = SOLVED_VERSION;
+		header.capacity = capacity;
+		header.count = stored;
+		written = fwrite(&header, sizeof(SolvedHeader), 1, file) == 1 && fwrite(table, sizeof(SolvedEntry), capacity, file) == capacity;
+		written = fclose(file) == 0 && written && rename(temporary, path) == 0;
+		if (!written)  {
+			remove(temporary);
+		}
+	}
+	engineFree(table);
+	engineFree(temporary);
+	return written;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file solved.h
+ * @brief Strong-solve database: the exact result and best move of positions on small boards, in a hash-indexed binary file that is mapped into memory
+ */
+
+#ifndef SOLVED_H
+#define SOLVED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bitboard.h"
+
+//Version of the file layout, stored after the magic bytes
+#define SOLVED_VERSION 1
+
+//Largest board the database holds; its squares, laid out on the rows of an 8 x 8 board, fit in the low 48 bits of a word
+#define SOLVED_MAX_DIM 6
+
+//The symmetries of a square board: bit 0 swaps rows and columns, then bit 1 turns the rows upside down, then bit 2 mirrors the columns
+#define SOLVED_SYMMETRIES 8
+
+//Parts of the words of an entry: the discs, on the 8 x 8 layout; the board size, the best move and the result, each in a byte above them
+#define SOLVED_DISCS_MASK 0x0000ffffffffffffULL
+#define SOLVED_DIM_SHIFT 48
+#define SOLVED_MOVE_SHIFT 56
+#define SOLVED_RESULT_SHIFT 48
+
+/**
+ * @brief One solved position, in its canonical orientation: the one of its symmetries whose discs come first
+ *
+ * Square (row, col) of every board is bit row*8+col, as on an 8 x 8 board, so every symmetry is a few operations on the whole word. An entry whose first word is 0 is an empty slot
+ */
+typedef struct  {
+	uint64_t own;			//The discs of the side to move, the board size in bits 48 to 55, and the best move, as row*8+col, in bits 56 to 63
+	uint64_t opp;			//The discs of the opponent, and in bits 48 to 55 the final disc differential for the side to move with best play by both sides, as a signed byte
+} SolvedEntry;
+
+/**
+ * @brief The start of a database file, followed directly by its table of entries
+ */
+typedef struct  {
+	char magic[4];
+	uint16_t version;
+	uint16_t reserved;
+	uint64_t capacity;		//The number of slots in the table; a power of two
+	uint64_t count;			//The number of slots holding a position
+} SolvedHeader;
+
+/**
+ * @brief How often an engine found its move in its strong-solve database
+ */
+typedef struct  {
+	uint64_t probes;		//Positions looked up
+	uint64_t hits;			//Positions whose move came from the database
+} SolvedStats;
+
+/**
+ * @brief An open database: the file's table, mapped read-only so every process using the file shares its pages
+ */
+typedef struct  {
+	const SolvedEntry* entries;
+	size_t capacity;
+	size_t count;
+	void* mapping;
+	size_t bytes;
+} SolvedDatabase;
+
+uint64_t solvedSpread (uint64_t squares, int dim);
+uint64_t solvedGather (uint64_t squares, int dim);
+uint64_t solvedTransform (uint64_t squares, int dim, int symmetry);
+int solvedTransformSquare (int square, int dim, int symmetry, bool inverse);
+int solvedCanonical (uint64_t* own, uint64_t* opp, int dim);
+uint64_t solvedRegion (int dim);
+SolvedEntry solvedMakeEntry (uint64_t own, uint64_t opp, int dim, int move, int difference);
+size_t solvedSlot (uint64_t ownKey, uint64_t opp, size_t capacity);
+SolvedDatabase* solvedOpen (const char* path);
+void solvedClose (SolvedDatabase* database);
+const SolvedEntry* solvedFind (const SolvedDatabase* database, uint64_t own, uint64_t opp, int dim);
+bool solvedLookup (const SolvedDatabase* database, const Position* pos, int* move, int* difference);
+bool solvedWrite (const char* path, const SolvedEntry* entries, size_t count);
+
+#endif
@@ -0,0 +1,606 @@
+/**
+ * @file solvedb.c
+ * @brief Strongly solves a small board: finds the exact result and a best move of every position reachable from the start, and writes them to a strong-solve database
+ *
+ * The solve runs in three steps, all on the canonical orientation of each position, so a position and its reflections and rotations are found, solved and stored once:
+ *
+ *   enumerate  every position reachable from the start with at most the given number of moves played is found, once, by a walk over the game tree that stops at positions it has seen
+ *   solve      the positions at that number of moves, the frontier, are shared out between threads, and each is solved exactly by an alpha-beta search that keeps bounds in a table of its own
+ *   back up    every other position takes the best result over its moves, worked out from the frontier back to the start with each result remembered, so no position is worked out twice
+ *
+ * With no number of moves given, every reachable position is enumerated and there is nothing to solve but the finished games, which is the whole game tree of a 4 x 4 board. Larger boards have
+ * far too many positions to hold them all, so there the number of moves sets how deep into the game the database reaches; beyond it the engine searches as usual. Every position with a legal move is
+ * written to the database; the entries of other board sizes already in the file are kept, so one file can hold every size
+ *
+ * With -verify, nothing is built: entries sampled from an existing database are checked against the engine's own exact solver instead, which must find the same differential, and find that the
+ * stored move reaches it
+ *
+ *   solvedb.exe [-size N] [-plies N] [-threads N] [-memo MB] [-out FILE]
+ *   solvedb.exe -verify FILE [-samples N] [-seed N]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "reversi.h"
+#include "endgame.h"
+#include "solved.h"
+#include "util.h"
+
+//Defaults of the command line options
+#define DEFAULT_SOLVED "solved.bin"
+#define DEFAULT_SOLVED_DIM 4
+#define DEFAULT_MEMO_MEGABYTES 64
+#define DEFAULT_VERIFY_SAMPLES 1000
+#define DEFAULT_VERIFY_SEED 1
+
+//Larger than any disc differential the database can hold
+#define SOLVE_INFINITY 100
+
+//Empty squares at or above which a solve keeps its bounds in its table; below, solving again is cheaper
+#define MEMO_EMPTIES 5
+//Empty squares above which moves are ordered fastest-first; at or below, they are searched as they come
+#define FASTEST_FIRST_EMPTIES 5
+
+/**
+ * @brief A position found by the enumeration, with its result once it is known
+ */
+typedef struct  {
+	uint64_t own;			//The canonical discs of the side to move, on the 8 x 8 layout
+	uint64_t opp;			//The canonical discs of the opponent
+	int8_t difference;		//The final disc differential for the side to move with best play
+	int8_t move;			//The best move in the canonical orientation, as row*8+col; -1 for a position without a legal move
+	bool used;				//Whether the slot holds a position
+	bool solved;			//Whether the result is known
+} SolvedPosition;
+
+/**
+ * @brief Bounds on the final disc differential of one position, kept by a thread's solves
+ */
+typedef struct  {
+	uint64_t own;
+	uint64_t opp;
+	int8_t lower;			//The differential is at least this
+	int8_t upper;			//The differential is at most this
+	int8_t move;			//The best move found, tried first next time; -1 if none
+} MemoEntry;
+
+/**
+ * @brief Everything the solve works with: the board, the positions found, and the frontier still to be solved
+ */
+typedef struct  {
+	int dim;
+	uint64_t region;		//The squares of the board, on the 8 x 8 layout
+	int plies;				//Moves played at the frontier
+	SolvedPosition* slots;	//Every position found, in an open-addressed table
+	size_t capacity;		//Slots in the table; a power of two
+	size_t count;			//Positions in the table
+	size_t* frontier;		//The slots of the positions at the frontier that have a legal move
+	size_t frontierCount;
+	size_t next;			//The next frontier position for a thread to take; read and written atomically
+	size_t done;			//Frontier positions solved; read and written atomically
+	size_t memoEntries;		//Entries in each thread's table of bounds; a power of two
+	double start;			//When the solve started
+} Builder;
+
+/**
+ * @brief One thread solving frontier positions
+ */
+typedef struct  {
+	Builder* builder;
+	MemoEntry* memo;
+	uint64_t nodes;			//Positions visited by the thread's solves
+	pthread_t thread;
+} SolverThread;
+
+/**
+ * @brief Finds the slot of a canonical position, or the empty slot where it belongs
+ */
+static SolvedPosition* findPosition (const Builder* builder, uint64_t own, uint64_t opp)  {
+	size_t slot = solvedSlot(own, opp, builder->capacity);
+
+	while (builder->slots[slot].used && (builder->slots[slot].own != own || builder->slots[slot].opp != opp))  {
+		slot = (slot+1) & (builder->capacity-1);
+	}
+	return &builder->slots[slot];
+}
+
+/**
+ * @brief Doubles the table of positions once it is half full
+ *
+ * @return Whether there was memory for it
+ */
+static bool growPositions (Builder* builder)  {
+	SolvedPosition* old = builder->slots;
+	size_t oldCapacity = builder->capacity;
+
+	if (2*(builder->count+1) <= builder->capacity)  {
+		return true;
+	}
+	builder->capacity = oldCapacity > 0 ? 2*oldCapacity : 1 << 16;
+	builder->slots = (SolvedPosition*) calloc(builder->capacity, sizeof(SolvedPosition));
+	if (builder->slots == NULL)  {
+		return false;
+	}
+	for (size_t i = 0; i < oldCapacity; i++)  {
+		if (old[i].used)  {
+			*findPosition(builder, old[i].own, old[i].opp) = old[i];
+		}
+	}
+	free(old);
+	return true;
+}
+
+/**
+ * @brief The legal moves of the side to move, on the 8 x 8 layout
+ */
+static inline uint64_t movesOf (const Builder* builder, uint64_t own, uint64_t opp)  {
+	return generateMoves8x8(own, opp) & builder->region;
+}
+
+/**
+ * @brief Finds every position reachable from a position with at most the builder's number of moves played
+ *
+ * Frontier positions are left unsolved with a move of 0, to be listed once the table stops growing; positions without a legal move on either side are solved at once
+ *
+ * @param builder The solve
+ * @param own The discs of the side to move, on the 8 x 8 layout
+ * @param opp The discs of the opponent
+ * @param played The moves played to reach the position
+ *
+ * @return Whether there was memory for every position
+ */
+static bool enumerate (Builder* builder, uint64_t own, uint64_t opp, int played)  {
+	SolvedPosition* position;
+	uint64_t moves;
+
+	//Grows the table first, so the slot found stays where it is
+	if (!growPositions(builder))  {
+		return false;
+	}
+	solvedCanonical(&own, &opp, builder->dim);
+	position = findPosition(builder, own, opp);
+	if (position->used)  {
+		return true;
+	}
+	position->own = own;
+	position->opp = opp;
+	position->used = true;
+	position->solved = false;
+	position->move = -1;
+	builder->count++;
+
+	moves = movesOf(builder, own, opp);
+	if (moves == 0)  {
+		if (movesOf(builder, opp, own) == 0)  {
+			position->difference = (int8_t) (__builtin_popcountll(own) - __builtin_popcountll(opp));
+			position->solved = true;
+			return true;
+		}
+		//A pass plays no disc, so the position after it is just as far into the game
+		return enumerate(builder, opp, own, played);
+	}
+	if (played == builder->plies)  {
+		position->move = 0;
+		return true;
+	}
+	for (; moves != 0; moves &= moves-1)  {
+		int square = __builtin_ctzll(moves);
+		uint64_t flips = computeFlips8x8(own, opp, square);
+		if (!enumerate(builder, opp & ~flips, own | flips | 1ULL << square, played+1))  {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Solves a position exactly, playing every line out to the end of the game
+ *
+ * Empty squares are not awarded to either side, the same as the engine's own solver
+ *
+ * @param thread The thread solving; its node count is added to
+ * @param own The discs of the side to move, on the 8 x 8 layout
+ * @param opp The discs of the opponent
+ * @param alpha The differential the side to move is already guaranteed elsewhere
+ * @param beta The differential the opponent is already guaranteed elsewhere
+ * @param passed Whether the opponent has just passed, in which case having no move ends the game
+ *
+ * @return The final disc differential for the side to move with best play by both sides, or a bound on it if it lies outside the window
+ */
+static int solvePosition (SolverThread* thread, uint64_t own, uint64_t opp, int alpha, int beta, bool passed)  {
+	const Builder* builder = thread->builder;
+	uint64_t moves = movesOf(builder, own, opp), children[2][64];
+	int empties = __builtin_popcountll(builder->region & ~(own|opp)), order[64], squares[64], count = 0, best = -SOLVE_INFINITY, bestMove = -1, ttMove = -1, low = alpha;
+	MemoEntry* entry = NULL;
+
+	thread->nodes++;
+	if (moves == 0)  {
+		if (passed)  {
+			return __builtin_popcountll(own) - __builtin_popcountll(opp);
+		}
+		return -solvePosition(thread, opp, own, -beta, -alpha, true);
+	}
+	if (empties == 1)  {
+		int flipped = __builtin_popcountll(computeFlips8x8(own, opp, __builtin_ctzll(moves)));
+		return __builtin_popcountll(own) - __builtin_popcountll(opp) + 2*flipped + 1;
+	}
+	if (empties >= MEMO_EMPTIES)  {
+		entry = &thread->memo[solvedSlot(own, opp, builder->memoEntries)];
+		if (entry->own == own && entry->opp == opp)  {
+			if (entry->lower >= beta || entry->lower == entry->upper)  {
+				return entry->lower;
+			}
+			if (entry->upper <= alpha)  {
+				return entry->upper;
+			}
+			alpha = entry->lower > alpha ? entry->lower : alpha;
+			beta = entry->upper < beta ? entry->upper : beta;
+			ttMove = entry->move;
+		}
+		low = alpha;
+	}
+
+	//With many empty squares left, the moves that leave the opponent the fewest replies go first, after the best move found before
+	for (; moves != 0; moves &= moves-1)  {
+		int square = __builtin_ctzll(moves), key, i;
+		uint64_t flips = computeFlips8x8(own, opp, square);
+		uint64_t childOwn = opp & ~flips, childOpp = own | flips | 1ULL << square;
+		key = square == ttMove ? 0 : empties > FASTEST_FIRST_EMPTIES ? 1 + __builtin_popcountll(movesOf(builder, childOwn, childOpp)) : 1;
+		for (i = count; i > 0 && order[i-1] >> 8 > key; i--)  {
+			order[i] = order[i-1];
+		}
+		order[i] = (key << 8) | count;
+		children[0][count] = childOwn;
+		children[1][count] = childOpp;
+		squares[count++] = square;
+	}
+	//The first move is searched with the whole window; the rest only have to be shown no better, with a null window, and are searched again if one is
+	for (int i = 0; i < count; i++)  {
+		int child = order[i] & 0xff, score;
+		if (i == 0)  {
+			score = -solvePosition(thread, children[0][child], children[1][child], -beta, -alpha, false);
+		}
+		else  {
+			score = -solvePosition(thread, children[0][child], children[1][child], -alpha-1, -alpha, false);
+			if (score > alpha && score < beta)  {
+				score = -solvePosition(thread, children[0][child], children[1][child], -beta, -score, false);
+			}
+		}
+		if (score > best)  {
+			best = score;
+			bestMove = squares[child];
+			if (score > alpha)  {
+				alpha = score;
+				if (alpha >= beta)  {
+					break;
+				}
+			}
+		}
+	}
+
+	if (entry != NULL)  {
+		entry->own = own;
+		entry->opp = opp;
+		entry->lower = (int8_t) (best > low ? best : -SOLVE_INFINITY);
+		entry->upper = (int8_t) (best < beta ? best : SOLVE_INFINITY);
+		entry->move = (int8_t) bestMove;
+	}
+	return best;
+}
+
+/**
+ * @brief Solves frontier positions, taking the next unsolved one until none are left
+ *
+ * @param argument The thread's state
+ *
+ * @return NULL
+ */
+static void* solveFrontier (void* argument)  {
+	SolverThread* thread = (SolverThread*) argument;
+	Builder* builder = thread->builder;
+
+	for (size_t next = __atomic_fetch_add(&builder->next, 1, __ATOMIC_RELAXED); next < builder->frontierCount; next = __atomic_fetch_add(&builder->next, 1, __ATOMIC_RELAXED))  {
+		SolvedPosition* position = &builder->slots[builder->frontier[next]];
+		uint64_t own = position->own, opp = position->opp;
+		int alpha = -SOLVE_INFINITY, move = -1;
+		size_t done;
+
+		//Every move is first shown no better than the best so far with a null window, and only a move that is better is searched again for its exact result
+		for (uint64_t moves = movesOf(builder, own, opp); moves != 0; moves &= moves-1)  {
+			int square = __builtin_ctzll(moves);
+			uint64_t flips = computeFlips8x8(own, opp, square);
+			int score = -solvePosition(thread, opp & ~flips, own | flips | 1ULL << square, -alpha-1, -alpha, false);
+			if (score > alpha)  {
+				score = -solvePosition(thread, opp & ~flips, own | flips | 1ULL << square, -SOLVE_INFINITY, -score, false);
+				alpha = score;
+				move = square;
+			}
+		}
+		position->difference = (int8_t) alpha;
+		position->move = (int8_t) move;
+		position->solved = true;
+		done = __atomic_add_fetch(&builder->done, 1, __ATOMIC_RELAXED);
+		if (done % 1000 == 0)  {
+			fprintf(stderr, "solved %zu of %zu frontier positions, %.0fs\n", done, builder->frontierCount, secondsNow() - builder->start);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Works out the result of a position from those of the positions after its moves, remembering every result found
+ *
+ * @param builder The solve, with every frontier position solved
+ * @param own The discs of the side to move, on the 8 x 8 layout
+ * @param opp The discs of the opponent
+ *
+ * @return The final disc differential for the side to move with best play by both sides
+ */
+static int backUp (Builder* builder, uint64_t own, uint64_t opp)  {
+	SolvedPosition* position;
+	uint64_t moves;
+	int best = -SOLVE_INFINITY, move = -1;
+
+	solvedCanonical(&own, &opp, builder->dim);
+	position = findPosition(builder, own, opp);
+	if (position->solved)  {
+		return position->difference;
+	}
+	//Moves are generated from the canonical discs, so the best move is in the canonical orientation
+	moves = movesOf(builder, own, opp);
+	if (moves == 0)  {
+		best = -backUp(builder, opp, own);
+	}
+	for (; moves != 0; moves &= moves-1)  {
+		int square = __builtin_ctzll(moves);
+		uint64_t flips = computeFlips8x8(own, opp, square);
+		int score = -backUp(builder, opp & ~flips, own | flips | 1ULL << square);
+		if (score > best)  {
+			best = score;
+			move = square;
+		}
+	}
+	position->difference = (int8_t) best;
+	position->move = (int8_t) move;
+	position->solved = true;
+	return best;
+}
+
+/**
+ * @brief Checks entries sampled from a database against the engine's exact solver
+ *
+ * Each entry is set up as its canonical position, with its own discs to move, and solved from scratch. The entry is wrong if the solver finds another differential, or if its move is not legal or
+ * leads to a position the solver finds worse. Every entry of the table has the same chance of being picked, and none is picked twice
+ *
+ * @param path The database
+ * @param samples The number of entries to check; all of them if the database holds no more
+ * @param seed The seed that picks the entries
+ *
+ * @return The number of wrong entries, or -1 if the database could not be opened
+ */
+static int verifyDatabase (const char* path, size_t samples, uint64_t seed)  {
+	static UndoStack undo;
+	SolvedDatabase* database = solvedOpen(path);
+	EndgameSolver solver = {0};
+	Position pos;
+	bool stop = false;
+	char squares[MAX_SQUARES+1], name[3];
+	size_t left, checked = 0;
+	int wrong = 0;
+	double start = secondsNow();
+
+	if (database == NULL)  {
+		return -1;
+	}
+	solver.pos = &pos;
+	solver.undo = &undo;
+	solver.stop = &stop;
+	left = database->count;
+	samples = samples < left ? samples : left;
+	for (size_t i = 0; i < database->capacity && checked < samples; i++)  {
+		const SolvedEntry* entry = &database->entries[i];
+		int dim = (int) ((entry->own >> SOLVED_DIM_SHIFT) & 0xff), move = (int) (entry->own >> SOLVED_MOVE_SHIFT), stored = (int8_t) (uint8_t) (entry->opp >> SOLVED_RESULT_SHIFT);
+		int exact, reached = -SOLVE_INFINITY, square;
+		uint64_t own, opp;
+		Bitboard flips;
+
+		if (entry->own == 0)  {
+			continue;
+		}
+		//Picks the entry with the chance of the samples still wanted among the entries still to come
+		if (nextRandom(&seed) % left-- >= samples - checked)  {
+			continue;
+		}
+		checked++;
+		if (dim < REVERSI_MIN_DIM || dim > SOLVED_MAX_DIM)  {
+			printf("slot %zu: no board is %d x %d\n", i, dim, dim);
+			wrong++;
+			continue;
+		}
+		own = solvedGather(entry->own & SOLVED_DISCS_MASK, dim);
+		opp = solvedGather(entry->opp & SOLVED_DISCS_MASK, dim);
+		for (int j = 0; j < dim*dim; j++)  {
+			squares[j] = (own >> j & 1) ? 'B' : (opp >> j & 1) ? 'W' : 'U';
+		}
+		squares[dim*dim] = '\0';
+		reversiSetPosition(&pos, dim, squares, 'B');
+		clearUndoStack(&undo);
+		exact = solveEndgame(&solver, -SOLVE_INFINITY, SOLVE_INFINITY, false);
+		square = move%8 < dim && move/8 < dim ? (move/8)*dim + move%8 : -1;
+		if (square >= 0 && computeFlips(&pos, pos.side, square, &flips, NULL) > 0)  {
+			makeMove(&pos, square, &undo);
+			reached = -solveEndgame(&solver, -SOLVE_INFINITY, SOLVE_INFINITY, false);
+			unmakeMove(&pos, &undo);
+		}
+		if (exact != stored || reached != exact)  {
+			reversiMoveName(square >= 0 ? square : 0, dim, name);
+			printf("size %d %s B: stored %s %+d, exact %+d, stored move reaches %+d\n", dim, squares, square >= 0 ? name : "--", stored, exact, reached);
+			wrong++;
+		}
+	}
+	printf("verified %zu of %zu entries, %d wrong, nodes %llu time %.1fs\n", checked, database->count, wrong, (unsigned long long) solver.nodes, secondsNow() - start);
+	solvedClose(database);
+	return wrong;
+}
+
+/**
+ * @brief Solves the board and writes the database
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	const char* path = DEFAULT_SOLVED;
+	const char* verifyPath = NULL;
+	size_t samples = DEFAULT_VERIFY_SAMPLES;
+	uint64_t seed = DEFAULT_VERIFY_SEED;
+	int threads = 1, memoMegabytes = DEFAULT_MEMO_MEGABYTES, difference, symmetry, start;
+	static Builder builder;
+	static SolverThread solvers[MAX_THREADS];
+	SolvedEntry* entries;
+	SolvedDatabase* existing;
+	size_t count = 0, kept = 0, stored = 0;
+	uint64_t own, opp, nodes = 0;
+	Position pos;
+	char name[3];
+	bool written;
+
+	builder.dim = DEFAULT_SOLVED_DIM;
+	builder.plies = -1;
+	for (int i = 1; i < argc; i++)  {
+		if (strcmp(argv[i], "-size") == 0 && i+1 < argc)  {
+			builder.dim = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-plies") == 0 && i+1 < argc)  {
+			builder.plies = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-threads") == 0 && i+1 < argc)  {
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-memo") == 0 && i+1 < argc)  {
+			memoMegabytes = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-out") == 0 && i+1 < argc)  {
+			path = argv[++i];
+		}
+		else if (strcmp(argv[i], "-verify") == 0 && i+1 < argc)  {
+			verifyPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "-samples") == 0 && i+1 < argc)  {
+			samples = (size_t) strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "-seed") == 0 && i+1 < argc)  {
+			seed = strtoull(argv[++i], NULL, 10);
+		}
+	}
+	if (verifyPath != NULL)  {
+		int wrong = verifyDatabase(verifyPath, samples, seed);
+		if (wrong < 0)  {
+			fprintf(stderr, "Could not open %s\n", verifyPath);
+		}
+		return wrong != 0;
+	}
+	if (builder.dim < REVERSI_MIN_DIM || builder.dim > SOLVED_MAX_DIM)  {
+		fprintf(stderr, "The database holds boards of %d x %d to %d x %d\n", REVERSI_MIN_DIM, REVERSI_MIN_DIM, SOLVED_MAX_DIM, SOLVED_MAX_DIM);
+		return 1;
+	}
+	threads = threads < 1 ? 1 : threads > MAX_THREADS ? MAX_THREADS : threads;
+	//Every square filled is as far as any game goes, so with no number of moves the whole tree is enumerated
+	if (builder.plies < 0 || builder.plies > builder.dim*builder.dim - 4)  {
+		builder.plies = builder.dim*builder.dim - 4;
+	}
+	builder.region = solvedRegion(builder.dim);
+	builder.memoEntries = 1;
+	while (2*builder.memoEntries*sizeof(MemoEntry) <= (size_t) (memoMegabytes > 0 ? memoMegabytes : 1) << 20)  {
+		builder.memoEntries *= 2;
+	}
+
+	builder.start = secondsNow();
+	reversiNewPosition(&pos, builder.dim);
+	own = solvedSpread(pos.disc[pos.side].word[0], builder.dim);
+	opp = solvedSpread(pos.disc[1-pos.side].word[0], builder.dim);
+	if (!enumerate(&builder, own, opp, 0))  {
+		fprintf(stderr, "Not enough memory to hold every position\n");
+		return 1;
+	}
+	builder.frontier = (size_t*) malloc((builder.count > 0 ? builder.count : 1) * sizeof(size_t));
+	if (builder.frontier == NULL)  {
+		fprintf(stderr, "Not enough memory to list the positions to solve\n");
+		return 1;
+	}
+	for (size_t i = 0; i < builder.capacity; i++)  {
+		if (builder.slots[i].used && !builder.slots[i].solved && builder.slots[i].move == 0)  {
+			builder.frontier[builder.frontierCount++] = i;
+		}
+	}
+	fprintf(stderr, "%zu positions up to %d moves, %zu of them to solve, %.1fs\n", builder.count, builder.plies, builder.frontierCount, secondsNow() - builder.start);
+
+	for (int i = 0; i < threads; i++)  {
+		solvers[i].builder = &builder;
+		solvers[i].memo = (MemoEntry*) calloc(builder.memoEntries, sizeof(MemoEntry));
+		if (solvers[i].memo == NULL)  {
+			fprintf(stderr, "Not enough memory for %d tables of %d MB\n", threads, memoMegabytes);
+			return 1;
+		}
+	}
+	for (int i = 1; i < threads; i++)  {
+		if (pthread_create(&solvers[i].thread, NULL, solveFrontier, &solvers[i]) != 0)  {
+			threads = i;
+			break;
+		}
+	}
+	solveFrontier(&solvers[0]);
+	for (int i = 0; i < threads; i++)  {
+		if (i > 0)  {
+			pthread_join(solvers[i].thread, NULL);
+		}
+		nodes += solvers[i].nodes;
+		free(solvers[i].memo);
+	}
+	difference = backUp(&builder, own, opp);
+
+	//The entries of other board sizes already in the file are kept
+	existing = solvedOpen(path);
+	entries = (SolvedEntry*) malloc((builder.count + (existing != NULL ? existing->count : 0)) * sizeof(SolvedEntry));
+	if (entries == NULL)  {
+		fprintf(stderr, "Not enough memory to write the database\n");
+		return 1;
+	}
+	for (size_t i = 0; existing != NULL && i < existing->capacity; i++)  {
+		const SolvedEntry* entry = &existing->entries[i];
+		if (entry->own != 0 && (int) ((entry->own >> SOLVED_DIM_SHIFT) & 0xff) != builder.dim)  {
+			entries[count++] = *entry;
+			kept++;
+		}
+	}
+	solvedClose(existing);
+	for (size_t i = 0; i < builder.capacity; i++)  {
+		const SolvedPosition* position = &builder.slots[i];
+		if (position->used && position->move >= 0)  {
+			entries[count++] = solvedMakeEntry(position->own, position->opp, builder.dim, position->move, position->difference);
+			stored++;
+		}
+	}
+	written = solvedWrite(path, entries, count);
+
+	own = solvedSpread(pos.disc[pos.side].word[0], builder.dim);
+	opp = solvedSpread(pos.disc[1-pos.side].word[0], builder.dim);
+	symmetry = solvedCanonical(&own, &opp, builder.dim);
+	start = solvedTransformSquare(findPosition(&builder, own, opp)->move, builder.dim, symmetry, true);
+	reversiMoveName((start/8)*builder.dim + start%8, builder.dim, name);
+	printf("size %d plies %d positions %zu stored %zu kept %zu nodes %llu time %.1fs\n", builder.dim, builder.plies, builder.count, stored, kept, (unsigned long long) nodes,
+		secondsNow() - builder.start);
+	printf("start: %s to move, final differential %+d with best play, best move %s\n", pos.side == BLACK ? "black" : "white", difference, name);
+	free(entries);
+	free(builder.slots);
+	free(builder.frontier);
+	if (!written)  {
+		fprintf(stderr, "Could not write %s\n", path);
+		return 1;
+	}
+	return 0;
+}
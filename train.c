@@ -0,0 +1,360 @@
+/**
+ * @file train.c
+ * @brief Offline trainer of the evaluation weights, fitted by least squares to the results of self-play games
+ *
+ * Reads game records written by the self-play mode, binary or text, replays every game, and takes each position along the way as a sample whose target is the final disc differential of its game. Every sample
+ * is also added with the colours swapped, so the weights score both colours alike. The weights are then fitted to minimise the squared difference between the evaluation and the targets, with
+ * a small penalty on the size of every weight, so the many pattern entries that appear in only a few positions are not fitted to the noise of those games. Entries that never appear keep the
+ * weight 0
+ *
+ *   train.exe [-out FILE] [-iterations N] [-lambda L] [-skip K] records...
+ *
+ * The weights are written for the -weights option of the game and the benchmark
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "reversi.h"
+#include "arena.h"
+#include "record.h"
+
+//Defaults of the command line options
+#define DEFAULT_ITERATIONS 50
+#define DEFAULT_LAMBDA 4.0
+#define DEFAULT_OUTPUT "weights.bin"
+
+/**
+ * @brief One position of a game, reduced to the features the evaluation uses
+ */
+typedef struct  {
+	uint32_t weight[PATTERN_INSTANCES];	//The weight each pattern's contents select within the stage
+	int16_t mobility;					//Black's legal moves less white's
+	int16_t discs;						//Black's discs less white's
+	int8_t tempo;						//1 with black to move, -1 with white to move
+	uint8_t stage;
+	int16_t target;						//The final disc differential of the game for black, in EVAL_SCALE units
+} Sample;
+
+/**
+ * @brief Every sample read, in one growing array
+ */
+typedef struct  {
+	Sample* samples;
+	size_t count;
+	size_t capacity;
+} SampleSet;
+
+/**
+ * @brief Adds a sample, growing the set as needed
+ *
+ * @return Whether there was memory for it
+ */
+static bool addSample (SampleSet* set, const Sample* sample)  {
+	if (set->count == set->capacity)  {
+		size_t capacity = set->capacity > 0 ? 2*set->capacity : 1 << 16;
+		Sample* grown = (Sample*) realloc(set->samples, capacity*sizeof(Sample));
+		if (grown == NULL)  {
+			return false;
+		}
+		set->samples = grown;
+		set->capacity = capacity;
+	}
+	set->samples[set->count++] = *sample;
+	return true;
+}
+
+/**
+ * @brief Reduces a position to its features, and adds it to the set together with its colour-swapped twin
+ *
+ * @param set The samples
+ * @param pos The position
+ * @param difference The final disc differential of the game, for black
+ *
+ * @return Whether there was memory for both samples
+ */
+static bool addPosition (SampleSet* set, const Position* pos, int difference)  {
+	Sample sample, swapped;
+	LegalMoves legal;
+	int black = countSquares(&pos->disc[BLACK], pos->words), white = countSquares(&pos->disc[WHITE], pos->words);
+
+	generateLegalMoves(pos, &legal);
+	sample.mobility = (int16_t) (legal.count[BLACK] - legal.count[WHITE]);
+	sample.discs = (int16_t) (black - white);
+	sample.tempo = pos->side == BLACK ? 1 : -1;
+	sample.stage = (uint8_t) evalStage(pos->dim, black+white);
+	sample.target = (int16_t) (difference*EVAL_SCALE);
+	swapped = sample;
+	swapped.mobility = (int16_t) -sample.mobility;
+	swapped.discs = (int16_t) -sample.discs;
+	swapped.tempo = (int8_t) -sample.tempo;
+	swapped.target = (int16_t) -sample.target;
+	for (int i = 0; i < PATTERN_INSTANCES; i++)  {
+		int type = patternInstanceType[i];
+		sample.weight[i] = (uint32_t) (patternTypeOffset[type] + pos->pattern[i]);
+		swapped.weight[i] = (uint32_t) (patternTypeOffset[type] + swapPatternColours(type, pos->pattern[i]));
+	}
+	return addSample(set, &sample) && addSample(set, &swapped);
+}
+
+/**
+ * @brief The samples of the game being replayed, kept until the whole game is known to be legal
+ */
+typedef struct  {
+	SampleSet samples;
+	int skip;				//Opening moves whose positions are left out
+	int difference;			//The final disc differential of the game for black
+} GameSamples;
+
+/**
+ * @brief Adds the position reached by each move of a replayed game, for recordReplay
+ *
+ * Each position is visited before the next move is played from it, so the position after the game's first move is the one visited at ply 1, and the final position, with no move left, is never visited
+ */
+static bool visitSample (const Position* pos, int ply, int move, void* context)  {
+	GameSamples* game = (GameSamples*) context;
+
+	(void) move;
+	return ply < 1 || ply < game->skip || addPosition(&game->samples, pos, game->difference);
+}
+
+/**
+ * @brief Replays one game and adds its positions to the set
+ *
+ * @param set The samples
+ * @param record The game
+ * @param skip Opening moves whose positions are left out
+ *
+ * @return 1 if the game was added, 0 if it is not a game the trainer can use, and -1 if there was no memory left
+ */
+static int addGame (SampleSet* set, const GameRecord* record, int skip)  {
+	GameSamples game = {{NULL, 0, 0}, skip, record->discs[BLACK] - record->discs[WHITE]};
+	int status;
+
+	if (record->dim < PATTERN_MIN_DIM)  {
+		return 0;
+	}
+	//Replays the whole game first, so a record that turns out not to be legal adds nothing
+	status = recordReplay(record, visitSample, &game);
+	for (size_t i = 0; status > 0 && i < game.samples.count; i++)  {
+		status = addSample(set, &game.samples.samples[i]) ? 1 : -1;
+	}
+	free(game.samples.samples);
+	return status;
+}
+
+/**
+ * @brief Evaluates a sample with one set of weights of every stage
+ */
+static double predict (const double* weights, const Sample* sample)  {
+	const double* stage = weights + (size_t) sample->stage*EVAL_STAGE_WEIGHTS;
+	double sum = stage[EVAL_MOBILITY]*sample->mobility + stage[EVAL_DISCS]*sample->discs + stage[EVAL_TEMPO]*sample->tempo;
+
+	for (int i = 0; i < PATTERN_INSTANCES; i++)  {
+		sum += stage[sample->weight[i]];
+	}
+	return sum;
+}
+
+/**
+ * @brief Adds a value times each sample's features to the weights the sample uses
+ */
+static void scatter (double* weights, const Sample* sample, double value)  {
+	double* stage = weights + (size_t) sample->stage*EVAL_STAGE_WEIGHTS;
+
+	for (int i = 0; i < PATTERN_INSTANCES; i++)  {
+		stage[sample->weight[i]] += value;
+	}
+	stage[EVAL_MOBILITY] += value*sample->mobility;
+	stage[EVAL_DISCS] += value*sample->discs;
+	stage[EVAL_TEMPO] += value*sample->tempo;
+}
+
+/**
+ * @brief Fits the weights to the samples by least squares
+ *
+ * Solves the normal equations of the samples, with lambda added to their diagonal so that entries seen in only a few positions stay close to 0, by the conjugate gradient method. Each
+ * iteration is one pass over the samples to evaluate them along the search direction and one to add up the result for every weight; the equations are scaled by their diagonal, which for a
+ * pattern entry is the number of samples it appears in
+ *
+ * @param set The samples
+ * @param weights Receives the weights of every stage, back to back
+ * @param iterations The number of iterations
+ * @param lambda Added to the diagonal of the normal equations
+ *
+ * @return Whether there was memory to fit the weights
+ */
+static bool fitWeights (const SampleSet* set, double* weights, int iterations, double lambda)  {
+	size_t total = (size_t) EVAL_STAGES*EVAL_STAGE_WEIGHTS;
+	double* residual = (double*) calloc(total, sizeof(double));
+	double* diagonal = (double*) calloc(total, sizeof(double));
+	double* direction = (double*) calloc(total, sizeof(double));
+	double* product = (double*) calloc(total, sizeof(double));
+	double* error = (double*) malloc(set->count*sizeof(double));
+	double* along = (double*) malloc(set->count*sizeof(double));
+	double rz = 0, step, denominator, squared;
+
+	if (residual == NULL || diagonal == NULL || direction == NULL || product == NULL || error == NULL || along == NULL)  {
+		free(residual);
+		free(diagonal);
+		free(direction);
+		free(product);
+		free(error);
+		free(along);
+		return false;
+	}
+
+	//Starting from all weights 0, every error is the target itself, and the residual of the normal equations is the targets added up for every weight
+	for (size_t s = 0; s < set->count; s++)  {
+		const Sample* sample = &set->samples[s];
+		error[s] = sample->target;
+		scatter(residual, sample, error[s]);
+		double* stage = diagonal + (size_t) sample->stage*EVAL_STAGE_WEIGHTS;
+		for (int i = 0; i < PATTERN_INSTANCES; i++)  {
+			stage[sample->weight[i]] += 1;
+		}
+		stage[EVAL_MOBILITY] += sample->mobility*sample->mobility;
+		stage[EVAL_DISCS] += sample->discs*sample->discs;
+		stage[EVAL_TEMPO] += 1;
+	}
+	for (size_t w = 0; w < total; w++)  {
+		weights[w] = 0;
+		diagonal[w] += lambda;
+		direction[w] = residual[w] / diagonal[w];
+		rz += residual[w]*direction[w];
+	}
+
+	for (int iteration = 1; iteration <= iterations && rz > 0; iteration++)  {
+		double next = 0;
+
+		//The normal equations applied to the search direction: every sample evaluated along it, added up for every weight, plus lambda times the direction
+		memset(product, 0, total*sizeof(double));
+		for (size_t s = 0; s < set->count; s++)  {
+			along[s] = predict(direction, &set->samples[s]);
+			scatter(product, &set->samples[s], along[s]);
+		}
+		denominator = 0;
+		for (size_t w = 0; w < total; w++)  {
+			product[w] += lambda*direction[w];
+			denominator += direction[w]*product[w];
+		}
+		step = rz / denominator;
+
+		squared = 0;
+		for (size_t s = 0; s < set->count; s++)  {
+			error[s] -= step*along[s];
+			squared += error[s]*error[s];
+		}
+		for (size_t w = 0; w < total; w++)  {
+			weights[w] += step*direction[w];
+			residual[w] -= step*product[w];
+			next += residual[w]*residual[w] / diagonal[w];
+		}
+		for (size_t w = 0; w < total; w++)  {
+			direction[w] = residual[w] / diagonal[w] + (next / rz)*direction[w];
+		}
+		rz = next;
+		if (iteration == 1 || iteration % 10 == 0 || iteration == iterations)  {
+			printf("iteration %d  rms error %.3f discs\n", iteration, sqrt(squared/set->count) / EVAL_SCALE);
+		}
+	}
+	free(residual);
+	free(diagonal);
+	free(direction);
+	free(product);
+	free(error);
+	free(along);
+	return true;
+}
+
+/**
+ * @brief Trains evaluation weights from self-play records
+ */
+int main (int argc, char** argv)  {
+	//Variable declaration
+	const char* output = DEFAULT_OUTPUT;
+	int iterations = DEFAULT_ITERATIONS, skip = 0, games = 0, skipped = 0, status;
+	double lambda = DEFAULT_LAMBDA;
+	SampleSet set = {NULL, 0, 0};
+	static GameRecord game;
+	static EvalWeights fitted;
+	double* weights;
+	bool read = true;
+
+	for (int i = 1; i < argc && read; i++)  {
+		if (strcmp(argv[i], "-out") == 0 && i+1 < argc)  {
+			output = argv[++i];
+		}
+		else if (strcmp(argv[i], "-iterations") == 0 && i+1 < argc)  {
+			iterations = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-skip") == 0 && i+1 < argc)  {
+			skip = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-lambda") == 0 && i+1 < argc)  {
+			lambda = atof(argv[++i]);
+		}
+		else  {
+			RecordReader* reader = recordOpen(argv[i]);
+			if (reader == NULL)  {
+				fprintf(stderr, "Could not read %s\n", argv[i]);
+				read = false;
+				break;
+			}
+			while ((status = recordRead(reader, &game)) != 0)  {
+				status = status > 0 ? addGame(&set, &game, skip) : 0;
+				games += status > 0;
+				skipped += status == 0;
+				if (status < 0)  {
+					fprintf(stderr, "Not enough memory for the samples\n");
+					read = false;
+					break;
+				}
+			}
+			recordClose(reader);
+		}
+	}
+	if (read && set.count == 0)  {
+		fprintf(stderr, "No games to train on; boards must be at least %dx%d\n", PATTERN_MIN_DIM, PATTERN_MIN_DIM);
+	}
+	if (!read || set.count == 0)  {
+		free(set.samples);
+		return 1;
+	}
+	printf("games %d skipped %d samples %zu\n", games, skipped, set.count);
+
+	weights = (double*) malloc((size_t) EVAL_STAGES*EVAL_STAGE_WEIGHTS*sizeof(double));
+	if (weights == NULL || !fitWeights(&set, weights, iterations, lambda))  {
+		fprintf(stderr, "Not enough memory to fit the weights\n");
+		free(weights);
+		free(set.samples);
+		return 1;
+	}
+
+	//Rounds into the evaluation's table; a stage no game reached keeps the hand-set weights
+	evalDefaultWeights(&fitted);
+	for (int stage = 0; stage < EVAL_STAGES; stage++)  {
+		bool reached = false;
+		for (size_t s = 0; s < set.count && !reached; s++)  {
+			reached = set.samples[s].stage == stage;
+		}
+		for (int w = 0; w < EVAL_STAGE_WEIGHTS && reached; w++)  {
+			double value = round(weights[(size_t) stage*EVAL_STAGE_WEIGHTS + w]);
+			fitted.weight[stage][w] = (int16_t) (value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value);
+		}
+	}
+	status = evalSaveWeights(output, &fitted) ? 0 : 1;
+	if (status == 0)  {
+		printf("weights written to %s\n", output);
+	}
+	else  {
+		fprintf(stderr, "Could not write %s\n", output);
+	}
+	free(weights);
+	free(set.samples);
+	return status;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file tt.c
+ * @brief Fixed-size, lock-free transposition table keyed by Zobrist hash
+ *
+ * The table is an array of buckets, each one cache line of 4 entries. A position can be stored in any entry of the bucket its key selects; when the bucket is full, the entry from the oldest search
+ * is replaced first, and among entries of the same age the one searched least deeply
+ */
+
+#include <string.h>
+
+#include "tt.h"
+#include "arena.h"
+
+//Layout of the packed data word: 16 bits of move, 32 bits of score, 8 bits of depth, 2 bits of bound and 6 bits of age
+#define DATA_MOVE(data) ((int) (int16_t) ((data) & 0xffff))
+#define DATA_SCORE(data) ((int) (int32_t) (((data) >> 16) & 0xffffffff))
+#define DATA_DEPTH(data) ((int) (((data) >> 48) & 0xff))
+#define DATA_BOUND(data) ((int) (((data) >> 56) & 0x3))
+#define DATA_AGE(data) ((int) (((data) >> 58) & 0x3f))
+#define AGE_MASK 0x3f
+
+/**
+ * @brief Packs a result into a data word
+ */
+static uint64_t packData (int move, int score, int depth, int bound, int age)  {
+	return (uint64_t) (uint16_t) move | (uint64_t) (uint32_t) score << 16 | (uint64_t) (depth & 0xff) << 48 | (uint64_t) bound << 56 | (uint64_t) (age & AGE_MASK) << 58;
+}
+
+/**
+ * @brief Creates a table of about the given size
+ *
+ * The number of buckets is rounded down to a power of two so a bucket can be picked from a key with a mask
+ *
+ * @param megabytes The most memory the table may use
+ *
+ * @return The new, empty table, or NULL if the memory could not be allocated
+ */
+TranspositionTable* ttCreate (size_t megabytes)  {
+	TranspositionTable* tt = (TranspositionTable*) engineMalloc(sizeof(TranspositionTable));
+	uint64_t buckets = 1;
+
+	if (tt == NULL)  {
+		return NULL;
+	}
+	while (buckets*2*sizeof(TTBucket) <= megabytes*1024*1024)  {
+		buckets *= 2;
+	}
+	//Aligns the buckets to cache lines so a probe touches a single line
+	tt->buckets = (TTBucket*) engineAlignedMalloc(64, buckets*sizeof(TTBucket));
+	if (tt->buckets == NULL)  {
+		engineFree(tt);
+		return NULL;
+	}
+	tt->bucketMask = buckets-1;
+	memset(&tt->stats, 0, sizeof(TTStats));
+	ttClear(tt);
+	return tt;
+}
+
+/**
+ * @brief Releases a table
+ */
+void ttFree (TranspositionTable* tt)  {
+	if (tt != NULL)  {
+		engineFree(tt->buckets);
+		engineFree(tt);
+	}
+}
+
+/**
+ * @brief Empties every entry of a table
+ */
+void ttClear (TranspositionTable* tt)  {
+	memset(tt->buckets, 0, (tt->bucketMask+1)*sizeof(TTBucket));
+	tt->age = 0;
+}
+
+/**
+ * @brief Marks the start of a new search, so the entries of earlier searches become the first to be replaced
+ */
+void ttNewSearch (TranspositionTable* tt)  {
+	tt->age = (tt->age+1) & AGE_MASK;
+}
+
+/**
+ * @brief Looks up a position
+ *
+ * @param tt The table
+ * @param key The Zobrist hash of the position
+ * @param data Receives the stored result if the position is found
+ * @param stats The counters of the searcher making the lookup
+ *
+ * @return Whether the position was found
+ */
+bool ttProbe (TranspositionTable* tt, uint64_t key, TTData* data, TTStats* stats)  {
+	TTBucket* bucket = &tt->buckets[key & tt->bucketMask];
+
+	stats->probes++;
+	for (int i = 0; i < TT_BUCKET_SIZE; i++)  {
+		uint64_t check = __atomic_load_n(&bucket->entry[i].check, __ATOMIC_RELAXED);
+		uint64_t word = __atomic_load_n(&bucket->entry[i].data, __ATOMIC_RELAXED);
+		//The check only matches if both words were written together for this key
+		if ((check ^ word) == key && word != 0)  {
+			data->move = DATA_MOVE(word);
+			data->score = DATA_SCORE(word);
+			data->depth = DATA_DEPTH(word);
+			data->bound = DATA_BOUND(word);
+			stats->hits++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Stores the result of searching a position
+ *
+ * Overwrites the position's own entry if it is already in the bucket, otherwise an empty entry, otherwise the entry whose age and depth make it least useful
+ *
+ * @param tt The table
+ * @param key The Zobrist hash of the position
+ * @param depth The depth the position was searched to
+ * @param bound What the score says about the true score
+ * @param score The score found
+ * @param move The best move found, or PASS_MOVE
+ * @param stats The counters of the searcher making the store
+ */
+void ttStore (TranspositionTable* tt, uint64_t key, int depth, int bound, int score, int move, TTStats* stats)  {
+	TTBucket* bucket = &tt->buckets[key & tt->bucketMask];
+	TTEntry* replace = NULL;
+	int replaceValue = 0, victim = -1, age = tt->age;
+	uint64_t replaceWord = 0;
+
+	for (int i = 0; i < TT_BUCKET_SIZE && replace == NULL; i++)  {
+		TTEntry* entry = &bucket->entry[i];
+		uint64_t check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+		uint64_t word = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+
+		if (word != 0 && (check ^ word) == key)  {
+			//Keeps a deeper result of the same position from the current search
+			if (DATA_AGE(word) == age && DATA_DEPTH(word) > depth && bound != BOUND_EXACT)  {
+				return;
+			}
+			replace = entry;
+		}
+	}
+	for (int i = 0; i < TT_BUCKET_SIZE && replace == NULL; i++)  {
+		uint64_t word = __atomic_load_n(&bucket->entry[i].data, __ATOMIC_RELAXED);
+		//Each search of age difference counts as much as 8 moves of depth, so stale entries go before shallow ones; an empty entry is always taken
+		int value = word == 0 ? -1000 : DATA_DEPTH(word) - 8*((age - DATA_AGE(word)) & AGE_MASK);
+
+		if (victim == -1 || value < replaceValue)  {
+			victim = i;
+			replaceValue = value;
+			replaceWord = word;
+		}
+	}
+	if (replace == NULL)  {
+		replace = &bucket->entry[victim];
+	}
+
+	if (replaceWord != 0 && DATA_AGE(replaceWord) == age)  {
+		stats->collisions++;
+	}
+	stats->stores++;
+	uint64_t word = packData(move, score, depth, bound, age);
+	__atomic_store_n(&replace->data, word, __ATOMIC_RELAXED);
+	__atomic_store_n(&replace->check, key ^ word, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Estimates how full a table is
+ *
+ * @return Permille of the first thousand entries (or fewer, for a tiny table) that hold a result
+ */
+int ttUsage (const TranspositionTable* tt)  {
+	int used = 0, sampled = 0;
+
+	for (uint64_t b = 0; b <= tt->bucketMask && sampled < 1000; b++)  {
+		for (int i = 0; i < TT_BUCKET_SIZE; i++, sampled++)  {
+			uint64_t word = tt->buckets[b].entry[i].data;
+			if (word != 0)  {
+				used++;
+			}
+		}
+	}
+	return sampled > 0 ? used*1000/sampled : 0;
+}
+
+/**
+ * @brief The memory used by the entries of a table, in bytes
+ */
+size_t ttBytes (const TranspositionTable* tt)  {
+	return (tt->bucketMask+1)*sizeof(TTBucket);
+}
+
+/**
+ * @brief Adds one set of counters to a running total
+ */
+void ttAddStats (TTStats* total, const TTStats* stats)  {
+	total->probes += stats->probes;
+	total->hits += stats->hits;
+	total->falseHits += stats->falseHits;
+	total->stores += stats->stores;
+	total->collisions += stats->collisions;
+}
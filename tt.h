@@ -0,0 +1,74 @@
+/**
+ * @file tt.h
+ * @brief Fixed-size, lock-free transposition table keyed by Zobrist hash
+ */
+
+#ifndef TT_H
+#define TT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//What a stored score says about the true score of the position
+#define BOUND_UPPER 1		//The true score is at most the stored score
+#define BOUND_LOWER 2		//The true score is at least the stored score
+#define BOUND_EXACT 3
+
+//Entries per bucket; a bucket of 4 entries fills one 64-byte cache line
+#define TT_BUCKET_SIZE 4
+
+/**
+ * @brief One stored search result
+ *
+ * The data is packed into a single word, and the word is stored XORed with the position's key. A reader that catches a half-written entry sees a key that does not match and treats the entry as a
+ * miss, so readers and writers never need a lock
+ */
+typedef struct  {
+	uint64_t check;		//The key XORed with the data
+	uint64_t data;		//The move, score, depth, bound and age packed together
+} TTEntry;
+
+typedef struct  {
+	TTEntry entry[TT_BUCKET_SIZE];
+} TTBucket;
+
+/**
+ * @brief A search result read back from the table
+ */
+typedef struct  {
+	int move;			//The best move found, or PASS_MOVE
+	int score;
+	int depth;			//The depth the position was searched to
+	int bound;			//BOUND_UPPER, BOUND_LOWER or BOUND_EXACT
+} TTData;
+
+/**
+ * @brief Counts of how the table is being used, kept by each searcher and added together for reports
+ */
+typedef struct  {
+	uint64_t probes;		//Lookups
+	uint64_t hits;			//Lookups that found the position
+	uint64_t falseHits;		//Hits whose move turned out to be illegal, i.e. a different position with the same key
+	uint64_t stores;		//Results written
+	uint64_t collisions;	//Writes that evicted an entry of another position stored during the current search
+} TTStats;
+
+typedef struct  {
+	TTBucket* buckets;
+	uint64_t bucketMask;	//The number of buckets, a power of two, minus 1
+	int age;				//Increases with every new search so older entries are replaced first
+	TTStats stats;			//Totals over every search that has finished with the table
+} TranspositionTable;
+
+TranspositionTable* ttCreate (size_t megabytes);
+void ttFree (TranspositionTable* tt);
+void ttClear (TranspositionTable* tt);
+void ttNewSearch (TranspositionTable* tt);
+bool ttProbe (TranspositionTable* tt, uint64_t key, TTData* data, TTStats* stats);
+void ttStore (TranspositionTable* tt, uint64_t key, int depth, int bound, int score, int move, TTStats* stats);
+int ttUsage (const TranspositionTable* tt);
+size_t ttBytes (const TranspositionTable* tt);
+void ttAddStats (TTStats* total, const TTStats* stats);
+
+#endif
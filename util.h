@@ -0,0 +1,40 @@
+/**
+ * @file util.h
+ * @brief Small helpers shared by the engine and its tools: a monotonic clock and a seeded random number generator
+ *
+ * Both are inline, so every file that includes the header gets its own copy without a file to add to any build. clock_gettime needs POSIX, so a file including this header must define
+ * _POSIX_C_SOURCE before its first #include
+ */
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief Wall-clock time in seconds, from a monotonic clock
+ *
+ * @return The time in seconds since an arbitrary fixed point
+ */
+static inline double secondsNow (void)  {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec*1e-9;
+}
+
+/**
+ * @brief Steps a splitmix64 generator
+ *
+ * @param state The generator's state, which is advanced
+ *
+ * @return The next random number
+ */
+static inline uint64_t nextRandom (uint64_t* state)  {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+#endif